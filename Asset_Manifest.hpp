@@ -0,0 +1,152 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef ASSET_MANIFEST_HEADER
+#define ASSET_MANIFEST_HEADER
+
+    #include <cstdint>
+    #include <stdexcept>
+
+    #include <basics/Id>
+
+    namespace jesus_villar_examen
+    {
+
+        using basics::Id;
+
+        /**
+         * Información de un recurso del manifiesto (Id, ruta y tamaño nominal).
+         */
+        struct Asset_Data
+        {
+            Id           id;
+            const char * path;
+            float        width;                         ///< Ancho que se usa cuando se simula sin cargar el recurso.
+            float        height;                        ///< Alto  que se usa cuando se simula sin cargar el recurso.
+        };
+
+        /**
+         * Manifiesto de recursos resuelto en tiempo de compilación. A cada Id se le asigna un índice
+         * denso en [0, COUNT) mediante un hash perfecto mínimo cuya semilla se busca al compilar, de
+         * modo que los recursos se pueden guardar en un array plano de tamaño fijo y consultar con
+         * un simple acceso indexado.
+         */
+        template< unsigned COUNT >
+        class Asset_Manifest
+        {
+            static_assert (COUNT > 0, "El manifiesto debe contener al menos un recurso.");
+
+        private:
+
+            Asset_Data entries[COUNT];                  ///< Recursos en el orden en el que se declararon.
+            unsigned   index_by_slot[COUNT];            ///< Índice del recurso que ocupa cada hueco de la tabla hash.
+            uint32_t   seed;                            ///< Semilla con la que el hash no produce colisiones.
+
+        public:
+
+            /**
+             * Construye el manifiesto y busca (en tiempo de compilación si es constexpr) una semilla
+             * con la que el hash reparte los Id sin colisiones.
+             * @param source Array con los datos de los recursos. No puede haber Id repetidos.
+             */
+            constexpr Asset_Manifest (const Asset_Data (& source)[COUNT])
+            :
+                entries       {},
+                index_by_slot {},
+                seed          (0)
+            {
+                for (unsigned index = 0; index < COUNT; ++index)
+                {
+                    for (unsigned other = 0; other < index; ++other)
+                    {
+                        if (source[other].id == source[index].id) throw std::logic_error("Id repetido en el manifiesto.");
+                    }
+
+                    entries[index] = source[index];
+                }
+
+                while (!try_seed (seed))
+                {
+                    if (++seed == 0) throw std::logic_error("No se ha encontrado un hash perfecto para el manifiesto.");
+                }
+            }
+
+        public:
+
+            static constexpr unsigned size ()
+            {
+                return COUNT;
+            }
+
+            constexpr const Asset_Data & operator [] (unsigned index) const
+            {
+                return entries[index];
+            }
+
+            /**
+             * Devuelve el índice denso asignado a un Id. Si el Id no forma parte del manifiesto lanza
+             * una excepción, lo que en una expresión constante se traduce en un error de compilación.
+             * @param id Id del recurso.
+             * @return Índice en [0, COUNT).
+             */
+            constexpr unsigned index_of (Id id) const
+            {
+                return entries[index_by_slot[slot_of (id, seed)]].id == id
+                     ? index_by_slot[slot_of (id, seed)]
+                     : throw std::out_of_range("El Id no forma parte del manifiesto.");
+            }
+
+        private:
+
+            static constexpr unsigned slot_of (Id id, uint32_t seed)
+            {
+                // Mezcla de bits (finalizador de murmur3) seguida de una reducción al rango de la tabla:
+
+                uint32_t hash = uint32_t(id) ^ seed;
+
+                hash ^= hash >> 16; hash *= 0x85EBCA6Bu;
+                hash ^= hash >> 13; hash *= 0xC2B2AE35u;
+                hash ^= hash >> 16;
+
+                return unsigned(hash % COUNT);
+            }
+
+            constexpr bool try_seed (uint32_t candidate)
+            {
+                bool used[COUNT] {};
+
+                for (unsigned index = 0; index < COUNT; ++index)
+                {
+                    unsigned slot = slot_of (entries[index].id, candidate);
+
+                    if (used[slot]) return false;
+
+                    used[slot]          = true;
+                    index_by_slot[slot] = index;
+                }
+
+                return true;
+            }
+
+        };
+
+        /**
+         * Permite declarar un manifiesto sin tener que indicar explícitamente el número de recursos.
+         */
+        template< unsigned COUNT >
+        constexpr Asset_Manifest< COUNT > make_asset_manifest (const Asset_Data (& source)[COUNT])
+        {
+            return Asset_Manifest< COUNT >(source);
+        }
+
+    }
+
+#endif
@@ -0,0 +1,297 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Batch_Runner.hpp"
+
+#include <mutex>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <condition_variable>
+
+#if !defined(_WIN32)
+    #include <unistd.h>
+#endif
+
+namespace jesus_villar_examen
+{
+
+    // ---------------------------------------------------------------------------------------------
+    // Barrera reutilizable con la que los hilos esperan a que todos terminen el fotograma actual.
+
+    class Frame_Barrier
+    {
+        std::mutex              mutex;
+        std::condition_variable condition;
+        unsigned                expected;
+        unsigned                waiting;
+        unsigned                generation;
+
+    public:
+
+        Frame_Barrier(unsigned expected) : expected(expected), waiting(0), generation(0)
+        {
+        }
+
+        void arrive_and_wait ()
+        {
+            std::unique_lock< std::mutex > lock (mutex);
+
+            unsigned current = generation;
+
+            if (++waiting == expected)
+            {
+                waiting = 0;
+                generation++;
+                condition.notify_all ();
+            }
+            else
+            {
+                condition.wait (lock, [this, current] { return generation != current; });
+            }
+        }
+    };
+
+    // ---------------------------------------------------------------------------------------------
+    // Entrada por defecto: cada partida toca la pantalla de vez en cuando e inclina el dispositivo
+    // siguiendo un paseo aleatorio. El estado se deriva de la partida y del fotograma para que no
+    // haya estado compartido entre hilos.
+
+    static Game_Scene::Input_Frame random_input (unsigned simulation, unsigned frame)
+    {
+        std::minstd_rand generator (simulation * 2654435761u + frame / 30 + 1);
+
+        Game_Scene::Input_Frame input {};
+
+        input.touches          = std::uniform_int_distribution< unsigned >(0, 9)(generator) == 0 ? 1 : 0;
+        input.events           = input.touches + (frame == 0 ? 1 : 0);
+        input.has_acceleration = true;
+        input.acceleration.x   = std::uniform_real_distribution< float >(-1.f, 1.f)(generator);
+        input.acceleration.y   = 0.f;
+        input.acceleration.z   = 1.f;
+
+        return input;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    static const unsigned resident_sample_frames = 60;             ///< Pasos entre muestras de la memoria residente.
+
+    // ---------------------------------------------------------------------------------------------
+    // Memoria residente según /proc/self/statm (segundo campo, en páginas del sistema). En
+    // plataformas que no lo tienen se devuelve 0.
+
+    static size_t resident_bytes ()
+    {
+        #if defined(_WIN32)
+        return 0;
+        #else
+        std::ifstream statm ("/proc/self/statm");
+
+        size_t total_pages, resident_pages;
+        long   page_size = sysconf (_SC_PAGESIZE);
+
+        return statm >> total_pages >> resident_pages && page_size > 0 ? resident_pages * size_t(page_size) : 0;
+        #endif
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Batch_Runner::Batch_Runner(unsigned simulations, unsigned threads)
+    :
+        simulations  (simulations),
+        threads      (threads > 0 ? threads : std::max (std::thread::hardware_concurrency (), 1u)),
+        input_script (random_input),
+        scenario     (Scenario::defaults ())
+    {
+        this->threads = std::max (std::min (this->threads, simulations), 1u);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Batch_Runner::Report Batch_Runner::run (unsigned frames, float time_step)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        struct Worker_Totals
+        {
+            unsigned hits;
+            unsigned deaths;
+            double   best_survival_sum;
+            float    best_survival;
+            uint64_t collision_pairs;
+            uint64_t overflowed_contacts;
+            uint64_t script_updates;
+            uint64_t script_resumes;
+            double   script_seconds;
+            uint64_t animation_updates;
+            double   animation_seconds;
+        };
+
+        std::vector< Worker_Totals > totals  (threads, Worker_Totals { 0, 0, 0.0, 0.f, 0, 0, 0, 0, 0.0, 0, 0.0 });
+        std::vector< std::thread   > workers;
+        Frame_Barrier                barrier (threads);
+        Clock::time_point            start;
+        size_t                       memory = 0;
+
+        Memory_Tracker::get_instance ().reset_peaks ();
+
+        // Cada hilo se encarga del bloque [first, last) de partidas. Las partidas se crean dentro
+        // del propio hilo para que su memoria quede cerca del núcleo que las va a usar:
+
+        for (unsigned thread = 0; thread < threads; ++thread)
+        {
+            unsigned first = unsigned(uint64_t(simulations) *  thread      / threads);
+            unsigned last  = unsigned(uint64_t(simulations) * (thread + 1) / threads);
+
+            workers.emplace_back ([this, &totals, &barrier, &start, &memory, thread, first, last, frames, time_step]
+            {
+                std::vector< std::unique_ptr< Game_Scene > > scenes;
+
+                scenes.reserve (last - first);
+
+                // Con una semilla fija cada partida usa la suya a partir de ella, de modo que el lote
+                // completo se repite igual sin que todas las partidas jueguen lo mismo:
+
+                Scenario simulation_scenario = scenario;
+
+                for (unsigned simulation = first; simulation < last; ++simulation)
+                {
+                    if (scenario.random_seed != 0) simulation_scenario.random_seed = scenario.random_seed + simulation;
+
+                    scenes.emplace_back (new Game_Scene(Game_Scene::HEADLESS, simulation_scenario));
+
+                    if (wave_timeline) scenes.back ()->set_wave_timeline (wave_timeline);
+                }
+
+                barrier.arrive_and_wait ();                 // Se empieza a medir cuando todas están creadas
+
+                if (thread == 0)
+                {
+                    memory = resident_bytes ();
+                    start  = Clock::now ();
+                }
+
+                barrier.arrive_and_wait ();
+
+                for (unsigned frame = 0; frame < frames; ++frame)
+                {
+                    for (unsigned index = 0; index < scenes.size (); ++index)
+                    {
+                        scenes[index]->step (time_step, input_script (first + index, frame));
+                    }
+
+                    barrier.arrive_and_wait ();
+
+                    // La memoria residente se muestrea de vez en cuando (y tras el último paso)
+                    // para quedarse con el pico, como el de Memory_Tracker:
+
+                    if (thread == 0 && ((frame + 1) % resident_sample_frames == 0 || frame + 1 == frames))
+                    {
+                        memory = std::max (memory, resident_bytes ());
+                    }
+                }
+
+                Worker_Totals & worker_totals = totals[thread];
+
+                for (auto & scene : scenes)
+                {
+                    const Game_Scene::Statistics & statistics = scene->get_statistics ();
+
+                    worker_totals.hits                += statistics.hits;
+                    worker_totals.deaths              += statistics.deaths;
+                    worker_totals.best_survival_sum   += statistics.best_survival_time;
+                    worker_totals.best_survival        = std::max (worker_totals.best_survival, statistics.best_survival_time);
+                    worker_totals.collision_pairs     += statistics.collision_pairs;
+                    worker_totals.overflowed_contacts += statistics.overflowed_contacts;
+                    worker_totals.script_updates      += statistics.script_updates;
+                    worker_totals.script_resumes      += statistics.script_resumes;
+                    worker_totals.script_seconds      += statistics.script_seconds;
+                    worker_totals.animation_updates   += statistics.animation_updates;
+                    worker_totals.animation_seconds   += statistics.animation_seconds;
+                }
+            });
+        }
+
+        for (auto & worker : workers) worker.join ();
+
+        double wall_seconds = std::chrono::duration< double >(Clock::now () - start).count ();
+
+        Report report { simulations, threads, frames, wall_seconds, 0.0, 0.0, 0.0, 0.0, 0.f, 0.0, 0.0, 0, memory, 0, 0.0, 0.0, 0.0 };
+
+        uint64_t script_updates    = 0;
+        uint64_t script_resumes    = 0;
+        double   script_seconds    = 0.0;
+        uint64_t animation_updates = 0;
+        double   animation_seconds = 0.0;
+
+        // Suma de los picos de cada subsistema (puede superar ligeramente al pico conjunto):
+
+        for (unsigned tag = 0; tag < MEMORY_TAG_COUNT; ++tag)
+        {
+            report.tracked_peak_bytes += Memory_Tracker::get_instance ().get_statistics (Memory_Tag(tag)).peak_bytes;
+        }
+
+        for (const Worker_Totals & worker_totals : totals)
+        {
+            report.average_hits          += worker_totals.hits;
+            report.average_deaths        += worker_totals.deaths;
+            report.average_best_survival += worker_totals.best_survival_sum;
+            report.best_survival          = std::max (report.best_survival, worker_totals.best_survival);
+            report.collision_pairs       += double(worker_totals.collision_pairs);
+            report.overflowed_contacts   += worker_totals.overflowed_contacts;
+
+            script_updates += worker_totals.script_updates;
+            script_resumes += worker_totals.script_resumes;
+            script_seconds += worker_totals.script_seconds;
+
+            animation_updates += worker_totals.animation_updates;
+            animation_seconds += worker_totals.animation_seconds;
+        }
+
+        // Un paso de los scripts cuesta lo que tarda en recorrer todos más lo que tardan los que
+        // se reanudan, así que se dan las dos medias sobre el mismo tiempo total:
+
+        if (script_updates > 0) report.script_nanoseconds            = script_seconds * 1e9 / double(script_updates);
+        if (script_resumes > 0) report.script_nanoseconds_per_resume = script_seconds * 1e9 / double(script_resumes);
+
+        if (animation_updates > 0) report.animation_nanoseconds = animation_seconds * 1e9 / double(animation_updates);
+
+        if (simulations > 0)
+        {
+            report.average_hits          /= simulations;
+            report.average_deaths        /= simulations;
+            report.average_best_survival /= simulations;
+        }
+
+        if (simulations > 0 && frames > 0)
+        {
+            report.collision_pairs /= double(simulations) * frames;
+        }
+
+        if (wall_seconds > 0.0)
+        {
+            report.frames_per_second = double(simulations) * frames / wall_seconds;
+        }
+
+        if (frames > 0)
+        {
+            report.frame_milliseconds = wall_seconds * 1000.0 / frames;
+        }
+
+        return report;
+    }
+
+}
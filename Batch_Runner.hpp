@@ -0,0 +1,116 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef BATCH_RUNNER_HEADER
+#define BATCH_RUNNER_HEADER
+
+    #include <functional>
+
+    #include "Game_Scene.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Ejecuta muchas partidas HEADLESS independientes a la vez (para equilibrar el juego o
+         * ajustar la IA). Las partidas se reparten en bloques contiguos entre los hilos y cada hilo
+         * crea y avanza solo las suyas, de modo que su memoria no se comparte entre núcleos. Todos
+         * los hilos avanzan el mismo fotograma a la vez (lockstep).
+         */
+        class Batch_Runner
+        {
+        public:
+
+            /**
+             * Función que devuelve la entrada de una partida en un fotograma. Se invoca desde los
+             * hilos de trabajo, por lo que no debe modificar estado compartido.
+             */
+            typedef std::function< Game_Scene::Input_Frame (unsigned simulation, unsigned frame) > Input_Script;
+
+            /**
+             * Resultados agregados de una ejecución.
+             */
+            struct Report
+            {
+                unsigned simulations;
+                unsigned threads;
+                unsigned frames;                        ///< Fotogramas simulados por cada partida.
+                double   wall_seconds;                  ///< Tiempo real que ha durado la ejecución.
+                double   frames_per_second;             ///< Fotogramas simulados por segundo entre todas las partidas.
+                double   average_hits;                  ///< Media de submarinos alcanzados por partida.
+                double   average_deaths;                ///< Media de hundimientos por partida.
+                double   average_best_survival;         ///< Media de la mayor supervivencia (en segundos) de cada partida.
+                float    best_survival;                 ///< Mayor supervivencia entre todas las partidas.
+                double   frame_milliseconds;            ///< Tiempo medio que tardan todas las partidas en avanzar un fotograma.
+                double   collision_pairs;               ///< Media de pares comprobados con intersects() por partida y fotograma.
+                uint64_t overflowed_contacts;           ///< Contactos descartados entre todas las partidas por no caber en el buffer de colisiones.
+                size_t   resident_bytes;                ///< Pico de memoria residente del proceso durante run(), muestreado cada 60 pasos (0 si no se puede medir).
+                size_t   tracked_peak_bytes;            ///< Pico de la memoria anotada en Memory_Tracker (todos los subsistemas) durante run().
+                double   script_nanoseconds;            ///< Coste medio de cada script de comportamiento en un paso (esté esperando o se reanude).
+                double   script_nanoseconds_per_resume; ///< Tiempo total de los scripts entre las reanudaciones (incluye descontar la espera de los que no se reanudan).
+                double   animation_nanoseconds;         ///< Coste medio de avanzar cada animación de sprite en un paso.
+            };
+
+        private:
+
+            unsigned     simulations;
+            unsigned     threads;
+            Input_Script input_script;
+            Scenario     scenario;
+
+            std::shared_ptr< const Wave_Timeline > wave_timeline;
+
+        public:
+
+            /**
+             * @param simulations Número de partidas que se ejecutan a la vez.
+             * @param threads Número de hilos (0 para usar uno por núcleo).
+             */
+            Batch_Runner(unsigned simulations, unsigned threads = 0);
+
+            /**
+             * Cambia la entrada de las partidas. Por defecto cada partida recibe toques y giros del
+             * acelerómetro aleatorios (reproducibles, con una semilla por partida).
+             */
+            void set_input_script (Input_Script script)
+            {
+                input_script = std::move (script);
+            }
+
+            /**
+             * Cambia el escenario con el que se crean las partidas (por defecto Scenario::defaults()).
+             */
+            void set_scenario (const Scenario & new_scenario)
+            {
+                scenario = new_scenario;
+            }
+
+            /**
+             * Hace que las partidas sigan una línea de tiempo (ver Game_Scene::set_wave_timeline).
+             * Todas leen la misma proyección del fichero, cada una con su propio cursor.
+             */
+            void set_wave_timeline (std::shared_ptr< const Wave_Timeline > timeline)
+            {
+                wave_timeline = std::move (timeline);
+            }
+
+            /**
+             * Crea las partidas desde cero y las avanza 'frames' fotogramas.
+             * @param frames Número de fotogramas que se simulan.
+             * @param time_step Duración de cada fotograma en segundos.
+             */
+            Report run (unsigned frames, float time_step = 1.f / 60.f);
+
+        };
+
+    }
+
+#endif
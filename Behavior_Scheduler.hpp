@@ -0,0 +1,214 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef BEHAVIOR_SCHEDULER_HEADER
+#define BEHAVIOR_SCHEDULER_HEADER
+
+    #include <chrono>
+    #include <cstdint>
+
+    #include "Memory_Tracker.hpp"
+
+    /**
+     * Macros con las que se escriben los scripts de comportamiento como código secuencial que se
+     * suspende y se reanuda (corrutinas sin pila). Un script es una función que empieza con
+     * BEHAVIOR_BEGIN y termina con BEHAVIOR_END; BEHAVIOR_WAIT lo suspende y la siguiente vez que
+     * se llama continúa justo detrás. Como cada llamada empieza de cero, las variables locales no
+     * sobreviven a una suspensión: lo que deba recordarse se guarda en el Behavior_Frame. Tampoco
+     * se puede suspender dentro de un switch del propio script ni poner dos esperas en la misma
+     * línea, porque el punto de reanudación es el número de línea.
+     *
+     * BEHAVIOR_WAIT suma la espera a lo que sobró de la anterior (el tiempo que se pasó del plazo
+     * en el paso en que se reanudó), así que una cadena de esperas no se retrasa un fotograma en
+     * cada una. BEHAVIOR_YIELD descarta ese resto y reanuda el script en el siguiente update().
+     */
+    #define BEHAVIOR_BEGIN(frame)           switch ((frame).resume_point) { case 0:
+
+    #define BEHAVIOR_WAIT(frame, seconds)   do { (frame).wait += (seconds); (frame).resume_point = __LINE__; return jesus_villar_examen::BEHAVIOR_RUNNING; case __LINE__: ; } while (0)
+
+    #define BEHAVIOR_YIELD(frame)           do { (frame).wait = 0.f; (frame).resume_point = __LINE__; return jesus_villar_examen::BEHAVIOR_RUNNING; case __LINE__: ; } while (0)
+
+    #define BEHAVIOR_END(frame)             } (frame).resume_point = 0; return jesus_villar_examen::BEHAVIOR_DONE
+
+    namespace jesus_villar_examen
+    {
+
+        enum Behavior_Status
+        {
+            BEHAVIOR_RUNNING,                           ///< El script se ha suspendido y debe reanudarse.
+            BEHAVIOR_DONE,                              ///< El script ha terminado y su frame se libera.
+        };
+
+        /**
+         * Estado de un script suspendido. Todos ocupan lo mismo, así que se guardan en un pool
+         * de tamaño fijo sin reservar memoria al empezar o terminar scripts.
+         */
+        struct Behavior_Frame
+        {
+            uint32_t entity;                            ///< Entidad que controla el script.
+            uint32_t resume_point;                      ///< Punto en el que se reanuda (0 al empezar).
+            float    wait;                              ///< Segundos que faltan para reanudarlo (negativo si se pasó del plazo).
+            uint32_t counter;                           ///< Contador libre para los bucles del script.
+            float    value;                             ///< Valor libre que el script necesite conservar.
+        };
+
+        /**
+         * Ejecuta scripts de comportamiento (ver BEHAVIOR_BEGIN) de muchas entidades. En cada paso
+         * descuenta el tiempo de espera de todos los scripts y reanuda los que han terminado de
+         * esperar. Los frames están contiguos y los de los scripts que terminan se rellenan con
+         * el último, de modo que recorrerlos solo toca memoria contigua.
+         *
+         * CONTEXT es lo que reciben los scripts además de su frame (normalmente la escena).
+         */
+        template< typename CONTEXT >
+        class Behavior_Scheduler
+        {
+        public:
+
+            typedef Behavior_Status (* Script) (Behavior_Frame & frame, CONTEXT & context);
+
+            /**
+             * Métricas del último update().
+             */
+            struct Metrics
+            {
+                unsigned scripts;                       ///< Scripts en el pool al empezar.
+                unsigned resumed;                       ///< Scripts que se han reanudado.
+                float    microseconds;                  ///< Tiempo que ha tardado.
+            };
+
+        private:
+
+            struct Slot
+            {
+                Script         script;
+                Behavior_Frame frame;
+            };
+
+            unsigned                                capacity;
+            unsigned                                count;
+            Tracked_Vector< Slot, MEMORY_POOLS >    slots;
+            Metrics                                 metrics;
+
+        public:
+
+            /**
+             * Reserva el pool de golpe.
+             * @param capacity Número máximo de scripts a la vez.
+             */
+            explicit Behavior_Scheduler(unsigned capacity = 0)
+            :
+                capacity (0),
+                count    (0),
+                metrics  {}
+            {
+                reset (capacity);
+            }
+
+        public:
+
+            /**
+             * Descarta todos los scripts y cambia la capacidad del pool.
+             */
+            void reset (unsigned new_capacity)
+            {
+                capacity = new_capacity;
+                count    = 0;
+
+                slots.assign (capacity, Slot {});
+            }
+
+            /**
+             * Empieza un script que se ejecuta por primera vez en el siguiente update().
+             * @return false si el pool está lleno.
+             */
+            bool start (Script script, uint32_t entity)
+            {
+                if (count == capacity) return false;
+
+                slots[count++] = Slot { script, Behavior_Frame { entity, 0, 0.f, 0, 0.f } };
+
+                return true;
+            }
+
+            /**
+             * Termina los scripts de una entidad.
+             */
+            void stop (uint32_t entity)
+            {
+                for (unsigned index = 0; index < count; )
+                {
+                    if (slots[index].frame.entity == entity) slots[index] = slots[--count];
+                    else ++index;
+                }
+            }
+
+            /**
+             * Termina todos los scripts.
+             */
+            void clear ()
+            {
+                count = 0;
+            }
+
+            /**
+             * Avanza el tiempo de los scripts y reanuda los que no tienen que seguir esperando.
+             * Los que se empiecen desde un script se ejecutan ya en este mismo update().
+             */
+            void update (float time, CONTEXT & context)
+            {
+                typedef std::chrono::steady_clock Clock;
+
+                const Clock::time_point start = Clock::now ();
+
+                metrics.scripts = count;
+                metrics.resumed = 0;
+
+                for (unsigned index = 0; index < count; )
+                {
+                    Slot & slot = slots[index];
+
+                    // Un resto negativo no se sigue descontando: se reanuda en este paso y la
+                    // siguiente espera lo compensa.
+
+                    if (slot.frame.wait > 0.f)
+                    {
+                        slot.frame.wait -= time;
+
+                        if (slot.frame.wait > 0.f)
+                        {
+                            ++index;
+                            continue;
+                        }
+                    }
+
+                    ++metrics.resumed;
+
+                    if (slot.script (slot.frame, context) == BEHAVIOR_DONE) slot = slots[--count];
+                    else ++index;
+                }
+
+                metrics.microseconds = std::chrono::duration< float, std::micro >(Clock::now () - start).count ();
+            }
+
+            unsigned get_count    () const { return count;    }
+            unsigned get_capacity () const { return capacity; }
+
+            const Metrics & get_metrics () const
+            {
+                return metrics;
+            }
+
+        };
+
+    }
+
+#endif
@@ -0,0 +1,656 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Benchmark_Suite.hpp"
+#include "Game_Scene.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace jesus_villar_examen
+{
+
+    // ---------------------------------------------------------------------------------------------
+    // Los lotes acumulan sus resultados aquí para que el compilador no pueda descartar el trabajo.
+
+    static volatile uint64_t sink = 0;
+
+    // ---------------------------------------------------------------------------------------------
+    // Game objects repartidos al azar (con una semilla fija) por la resolución virtual con los
+    // tamaños de los sprites del juego y todos los anchors posibles.
+
+    template< typename OBJECT >
+    static std::shared_ptr< std::vector< OBJECT > > make_gameobjects (unsigned count)
+    {
+        static const int anchors[] = { basics::CENTER, basics::BOTTOM | basics::LEFT, basics::TOP | basics::RIGHT, basics::LEFT };
+
+        auto          objects = std::make_shared< std::vector< OBJECT > > ();
+        Random_Stream random  (Counter_Random(count), 0, 0);
+
+        objects->reserve (count);
+
+        for (unsigned index = 0; index < count; ++index)
+        {
+            objects->emplace_back (Size2f{ random.next_float (24.f, 256.f), random.next_float (24.f, 128.f) });
+
+            OBJECT & object = objects->back ();
+
+            object.set_anchor   (anchors[index % 4]);
+            object.set_position ({ random.next_float (0.f, 1280.f), random.next_float (0.f, 720.f) });
+            object.set_speed    ({ random.next_float (-400.f, 400.f), random.next_float (-400.f, 400.f) });
+        }
+
+        return objects;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Benchmark_Suite::Benchmark_Suite(unsigned repetitions, double minimum_seconds)
+    :
+        repetitions     (std::max (repetitions, 1u)),
+        minimum_seconds (minimum_seconds)
+    {
+        // El tamaño realista es el de una partida normal (unas decenas de entidades) y el de
+        // estrés el de Scenario::stress(10000):
+
+        for (unsigned size : { 64u, 10000u })
+        {
+            add_gameobject_benchmarks< float > (size, "gameobject_"      );
+            add_gameobject_benchmarks< Fixed > (size, "gameobject_fixed_");
+        }
+
+        add_scene_benchmarks (Scenario::defaults ()     );
+        add_scene_benchmarks (Scenario::stress   (10000));
+
+        add_random_benchmarks ();
+
+        for (unsigned entities : { 1000u, 10000u })
+        {
+            add_spatial_benchmarks (entities);
+        }
+
+        for (unsigned sprites : { 1000u, 10000u, 100000u })
+        {
+            add_animation_benchmarks (sprites);
+        }
+
+        for (unsigned particles : { 1000u, 10000u, 100000u })
+        {
+            add_particle_benchmarks (particles);
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    template< typename SCALAR >
+    void Benchmark_Suite::add_gameobject_benchmarks (unsigned size, const std::string & prefix)
+    {
+        typedef Basic_GameObject< SCALAR > Object;
+
+        auto objects = make_gameobjects< Object > (size);
+        auto points  = std::make_shared< std::vector< Point2f > > ();
+
+        Random_Stream random (Counter_Random(size + 1), 0, 0);
+
+        for (unsigned index = 0; index < size; ++index)
+        {
+            points->push_back ({ random.next_float (0.f, 1280.f), random.next_float (0.f, 720.f) });
+        }
+
+        // Cada objeto se compara con otro que está a un salto fijo para no medir solo pares
+        // vecinos en memoria:
+
+        add
+        ({
+            prefix + "intersects", size,
+            [objects] ()
+            {
+                const std::vector< Object > & list  = *objects;
+                const size_t                  count = list.size ();
+                uint64_t                      hits  = 0;
+
+                for (size_t index = 0; index < count; ++index) hits += list[index].intersects (list[(index * 7 + 1) % count]);
+
+                sink = sink + hits;
+
+                return uint64_t(count);
+            },
+            nullptr
+        });
+
+        add
+        ({
+            prefix + "contains", size,
+            [objects, points] ()
+            {
+                const std::vector< Object > & list  = *objects;
+                const size_t                  count = list.size ();
+                uint64_t                      hits  = 0;
+
+                for (size_t index = 0; index < count; ++index) hits += list[index].contains ((*points)[index]);
+
+                sink = sink + hits;
+
+                return uint64_t(count);
+            },
+            nullptr
+        });
+
+        // Cada lote parte de las posiciones iniciales para que en coma fija no se llegue a saturar:
+
+        auto initial = std::make_shared< std::vector< Object > > (*objects);
+
+        add
+        ({
+            prefix + "update", size,
+            [objects] ()
+            {
+                for (Object & object : *objects) object.update (1.f / 60.f);
+
+                return uint64_t(objects->size ());
+            },
+            [objects, initial] ()
+            {
+                *objects = *initial;
+            }
+        });
+
+        add
+        ({
+            prefix + "anchor_edges", size,
+            [objects] ()
+            {
+                float sum = 0.f;
+
+                for (const Object & object : *objects) sum += object.get_left_x () + object.get_bottom_y ();
+
+                sink = sink + uint64_t(sum != 0.f);
+
+                return uint64_t(objects->size ());
+            },
+            nullptr
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Las operaciones de la escena se miden sobre una partida HEADLESS recién creada. Un lote
+    // dispara hasta agotar las balas (o recoloca todos los submarinos) y 'reset' las vuelve a
+    // ocultar sin medirlo.
+
+    void Benchmark_Suite::add_scene_benchmarks (const Scenario & scenario)
+    {
+        std::shared_ptr< Game_Scene > scene (new Game_Scene(Game_Scene::HEADLESS, scenario));
+
+        auto hide_all = [] (Game_Scene::GameObject_List & list)
+        {
+            for (auto & object : list) object->hide ();
+        };
+
+        add
+        ({
+            "scene_spawn_bullet", unsigned(scene->player_bullets.size ()),
+            [scene] ()
+            {
+                uint64_t spawned = 0;
+
+                while (scene->spawn_bullet ()) ++spawned;
+
+                return spawned + 1;                     // El último intento, que no encuentra bala, también cuenta
+            },
+            [scene, hide_all] () { hide_all (scene->player_bullets); }
+        });
+
+        add
+        ({
+            "scene_spawn_enemy_bullet", unsigned(scene->enemy_bullets.size ()),
+            [scene] ()
+            {
+                const size_t count = scene->enemy_bullets.size ();
+
+                for (size_t shot = 0; shot < count; ++shot) scene->spawn_enemy_bullet (1);
+
+                return uint64_t(count);
+            },
+            [scene, hide_all] () { hide_all (scene->enemy_bullets); }
+        });
+
+        add
+        ({
+            "scene_random_submarine_values", unsigned(scene->submarines.size ()),
+            [scene] ()
+            {
+                for (auto & submarine : scene->submarines) scene->random_submarine_values (*submarine);
+
+                return uint64_t(scene->submarines.size ());
+            },
+            nullptr
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Coste por número uniforme en [0, 1) de Counter_Random (por lotes con SIMD, de uno en uno y
+    // con Random_Stream) frente al rand() de la biblioteca estándar al que sustituye.
+
+    void Benchmark_Suite::add_random_benchmarks ()
+    {
+        const unsigned size   = 4096;
+        auto           values = std::make_shared< std::vector< float > > (size);
+        auto           frame  = std::make_shared< uint32_t > (0);
+
+        add
+        ({
+            "random_fill_uniform", size,
+            [values, frame] ()
+            {
+                Counter_Random(1).fill_uniform (0, (*frame)++, 0, values->data (), values->size ());
+
+                sink = sink + uint64_t((*values)[0] < .5f);
+
+                return uint64_t(values->size ());
+            },
+            nullptr
+        });
+
+        add
+        ({
+            "random_uniform", size,
+            [values, frame] ()
+            {
+                const Counter_Random random (1);
+                const uint32_t       current = (*frame)++;
+
+                for (unsigned index = 0; index < size; ++index) (*values)[index] = random.uniform (0, current, index);
+
+                sink = sink + uint64_t((*values)[0] < .5f);
+
+                return uint64_t(size);
+            },
+            nullptr
+        });
+
+        add
+        ({
+            "random_stream_next_float", size,
+            [values, frame] ()
+            {
+                Random_Stream stream (Counter_Random(1), 0, (*frame)++);
+
+                for (float & value : *values) value = stream.next_float ();
+
+                sink = sink + uint64_t((*values)[0] < .5f);
+
+                return uint64_t(size);
+            },
+            nullptr
+        });
+
+        add
+        ({
+            "random_std_rand", size,
+            [values] ()
+            {
+                for (float & value : *values) value = float(std::rand ()) / (float(RAND_MAX) + 1.f);
+
+                sink = sink + uint64_t((*values)[0] < .5f);
+
+                return uint64_t(size);
+            },
+            nullptr
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Un paso de Sprite_Animator con animaciones repartidas entre clips de un atlas de 4x4 que se
+    // repiten a distintas velocidades y uno que no se repite y notifica al terminar (entonces se
+    // vuelve a empezar). Cada operación es una animación avanzada, así que el coste debería ser el
+    // mismo con cualquier número de sprites.
+
+    void Benchmark_Suite::add_animation_benchmarks (unsigned sprites)
+    {
+        auto animator = std::make_shared< Sprite_Animator > ();
+
+        uint16_t                    first = animator->add_grid_frames (4, 4);
+        const Sprite_Animator::Clip clips[] =
+        {
+            animator->add_clip (first,      8, 12.f, true ),
+            animator->add_clip (first + 8,  4,  8.f, true ),
+            animator->add_clip (first + 12, 4, 24.f, false, ID(animation-finished)),
+        };
+
+        for (unsigned sprite = 0; sprite < sprites; ++sprite)
+        {
+            animator->add_animation (clips[sprite % 3]);
+        }
+
+        const Sprite_Animator::Clip restart = clips[2];
+
+        add
+        ({
+            "sprite_animator_update", sprites,
+            [animator, restart] ()
+            {
+                uint64_t events = 0;
+
+                animator->update (1.f / 60.f, [&] (Sprite_Animator::Animation animation, Id) { animator->play (animation, restart); events++; });
+
+                sink = sink + events + uint64_t(animator->get_uv (0).u0 < .5f);
+
+                return uint64_t(animator->size ());
+            },
+            nullptr
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Un paso de Particle_System con el pool lleno. Las partículas son como las de una explosión
+    // pero con una vida tan larga que ninguna muere durante la medida, así que cada lote avanza
+    // siempre el mismo número. Cada operación es una partícula avanzada.
+
+    void Benchmark_Suite::add_particle_benchmarks (unsigned particles)
+    {
+        static const Particle_System::Settings settings { 1.f, .55f, .1f, { 14.f, 14.f }, 60.f, 320.f, 6.2832f, -100.f, .8f, 1e9f };
+
+        auto system = std::make_shared< Particle_System > (settings, particles);
+
+        system->set_random (Random_Stream(Counter_Random(particles), 0, 0));
+        system->emit       ({ 640.f, 360.f }, system->get_capacity (), 0.f);
+
+        add
+        ({
+            "particle_update", particles,
+            [system] ()
+            {
+                system->update (1.f / 60.f);
+
+                sink = sink + system->get_count ();
+
+                return uint64_t(system->get_count ());
+            },
+            nullptr
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Consultas del Spatial_Index de una partida de estrés con las balas en vuelo frente a lo que
+    // costaría responderlas recorriendo todos los gameobjects. Cada operación es una consulta
+    // desde un punto al azar de la resolución virtual (o, en spatial_rebuild, una entidad
+    // insertada al reconstruir el índice).
+
+    void Benchmark_Suite::add_spatial_benchmarks (unsigned entities)
+    {
+        std::shared_ptr< Game_Scene > scene (new Game_Scene(Game_Scene::HEADLESS, Scenario::stress (entities)));
+
+        // El primer evento empieza la partida y el disparo automático del escenario de estrés llena
+        // el agua de balas:
+
+        Game_Scene::Input_Frame start {};
+
+        start.events = 1;
+
+        scene->step (1.f / 60.f, start);
+
+        for (unsigned frame = 0; frame < 120; ++frame) scene->step (1.f / 60.f, Game_Scene::Input_Frame {});
+
+        auto objects = std::make_shared< std::vector< const GameObject * > > ();
+        auto bullets = std::make_shared< std::vector< const GameObject * > > ();
+        auto points  = std::make_shared< std::vector< Point2f > > ();
+
+        objects->push_back (scene->player_ship_pointer);
+
+        for (auto & bullet    : scene->player_bullets) { objects->push_back (bullet.get ()); bullets->push_back (bullet.get ()); }
+        for (auto & bullet    : scene->enemy_bullets ) objects->push_back (bullet.get ());
+        for (auto & submarine : scene->submarines    ) objects->push_back (submarine.get ());
+
+        Random_Stream random (Counter_Random(entities), 0, 0);
+
+        for (unsigned index = 0; index < 256; ++index)
+        {
+            points->push_back ({ random.next_float (0.f, float(scene->canvas_width)), random.next_float (0.f, float(scene->canvas_height)) });
+        }
+
+        const uint32_t all_categories = Game_Scene::CATEGORY_SHIP | Game_Scene::CATEGORY_PLAYER_BULLET | Game_Scene::CATEGORY_ENEMY_BULLET | Game_Scene::CATEGORY_SUBMARINE;
+
+        add
+        ({
+            "spatial_query_point", entities,
+            [scene, points, all_categories] ()
+            {
+                const GameObject * results[64];
+                uint64_t           found = 0;
+
+                for (const Point2f & point : *points) found += scene->spatial_index.query_point (point, all_categories, results, 64);
+
+                sink = sink + found;
+
+                return uint64_t(points->size ());
+            },
+            nullptr
+        });
+
+        add
+        ({
+            "linear_query_point", entities,
+            [objects, points] ()
+            {
+                uint64_t found = 0;
+
+                for (const Point2f & point : *points)
+                {
+                    for (const GameObject * object : *objects) found += object->is_visible () && object->contains (point);
+                }
+
+                sink = sink + found;
+
+                return uint64_t(points->size ());
+            },
+            nullptr
+        });
+
+        add
+        ({
+            "spatial_query_nearest", entities,
+            [scene, points] ()
+            {
+                Spatial_Index::Hit hit;
+                uint64_t           found = 0;
+
+                for (const Point2f & point : *points) found += scene->spatial_index.query_nearest (point, Game_Scene::CATEGORY_PLAYER_BULLET, &hit, 1);
+
+                sink = sink + found;
+
+                return uint64_t(points->size ());
+            },
+            nullptr
+        });
+
+        // La distancia de un punto a una caja es la de su proyección sobre ella:
+
+        add
+        ({
+            "linear_query_nearest", entities,
+            [bullets, points] ()
+            {
+                float nearest_sum = 0.f;
+
+                for (const Point2f & point : *points)
+                {
+                    float nearest = 1e30f;
+
+                    for (const GameObject * bullet : *bullets)
+                    {
+                        if (bullet->is_not_visible ()) continue;
+
+                        float dx = std::max (std::max (bullet->get_left_x   () - point[0], 0.f), point[0] - bullet->get_right_x ());
+                        float dy = std::max (std::max (bullet->get_bottom_y () - point[1], 0.f), point[1] - bullet->get_top_y   ());
+
+                        nearest = std::min (nearest, dx * dx + dy * dy);
+                    }
+
+                    nearest_sum += nearest;
+                }
+
+                sink = sink + uint64_t(nearest_sum > 0.f);
+
+                return uint64_t(points->size ());
+            },
+            nullptr
+        });
+
+        add
+        ({
+            "spatial_rebuild", entities,
+            [scene, objects] ()
+            {
+                scene->build_spatial_index ();
+
+                return uint64_t(objects->size ());
+            },
+            nullptr
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Benchmark_Suite::Results Benchmark_Suite::run () const
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        Results results;
+
+        for (const Benchmark & benchmark : benchmarks)
+        {
+            double best = 0.0;
+
+            for (unsigned repetition = 0; repetition < repetitions; ++repetition)
+            {
+                double   seconds    = 0.0;
+                uint64_t operations = 0;
+
+                if (benchmark.reset) benchmark.reset ();
+
+                while (seconds < minimum_seconds)
+                {
+                    Clock::time_point start = Clock::now ();
+
+                    operations += benchmark.batch ();
+                    seconds    += std::chrono::duration< double >(Clock::now () - start).count ();
+
+                    if (benchmark.reset) benchmark.reset ();
+                }
+
+                double nanoseconds = seconds * 1e9 / double(std::max< uint64_t > (operations, 1));
+
+                if (repetition == 0 || nanoseconds < best) best = nanoseconds;
+            }
+
+            results.push_back (Result { benchmark.name, benchmark.size, best });
+        }
+
+        return results;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    std::string Benchmark_Suite::to_json (const Results & results)
+    {
+        std::ostringstream json;
+
+        json << "{\n  \"benchmarks\":\n  [\n";
+
+        for (size_t index = 0; index < results.size (); ++index)
+        {
+            char nanoseconds[32];
+
+            snprintf (nanoseconds, sizeof(nanoseconds), "%.4f", results[index].nanoseconds);
+
+            json << "    { \"name\": \"" << results[index].name << "\", \"size\": " << results[index].size
+                 << ", \"ns_per_op\": " << nanoseconds << " }" << (index + 1 < results.size () ? "," : "") << "\n";
+        }
+
+        json << "  ]\n}\n";
+
+        return json.str ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // No es un lector de JSON general: busca en orden las tres claves de cada objeto tal y como las
+    // escribe to_json().
+
+    bool Benchmark_Suite::load (const std::string & path, Results & results)
+    {
+        std::ifstream file (path);
+
+        if (!file) return false;
+
+        std::stringstream buffer;
+
+        buffer << file.rdbuf ();
+
+        const std::string text = buffer.str ();
+
+        results.clear ();
+
+        for (size_t position = text.find ("\"name\""); position != std::string::npos; position = text.find ("\"name\"", position))
+        {
+            size_t name_start = text.find ('"', text.find (':', position) + 1);
+            size_t name_end   = name_start == std::string::npos ? name_start : text.find ('"', name_start + 1);
+            size_t size_key   = text.find ("\"size\"",      name_end);
+            size_t time_key   = text.find ("\"ns_per_op\"", name_end);
+
+            if (name_end == std::string::npos || size_key == std::string::npos || time_key == std::string::npos) return false;
+
+            Result result;
+
+            result.name        = text.substr (name_start + 1, name_end - name_start - 1);
+            result.size        = unsigned(strtoul (text.c_str () + text.find (':', size_key) + 1, nullptr, 10));
+            result.nanoseconds = strtod (text.c_str () + text.find (':', time_key) + 1, nullptr);
+
+            results.push_back (result);
+
+            position = time_key;
+        }
+
+        return !results.empty ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Benchmark_Suite::Regressions Benchmark_Suite::compare (const Results & results, const Results & baseline, double threshold_percent)
+    {
+        Regressions regressions;
+
+        for (const Result & result : results)
+        {
+            auto reference = std::find_if
+            (
+                baseline.begin (), baseline.end (),
+                [&result] (const Result & item) { return item.name == result.name && item.size == result.size; }
+            );
+
+            if (reference == baseline.end () || reference->nanoseconds <= 0.0) continue;
+
+            double percent = (result.nanoseconds / reference->nanoseconds - 1.0) * 100.0;
+
+            if (percent > threshold_percent)
+            {
+                regressions.push_back (Regression { result.name, result.size, reference->nanoseconds, result.nanoseconds, percent });
+            }
+        }
+
+        return regressions;
+    }
+
+}
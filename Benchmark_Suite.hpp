@@ -0,0 +1,122 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef BENCHMARK_SUITE_HEADER
+#define BENCHMARK_SUITE_HEADER
+
+    #include <string>
+    #include <vector>
+    #include <cstdint>
+    #include <functional>
+
+    #include "Scenario.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Microbenchmarks de las operaciones que se ejecutan en cada fotograma (primitivas de
+         * GameObject en float y en coma fija, operaciones de la escena, números aleatorios,
+         * consultas espaciales, animaciones de sprites y partículas), cada una con un tamaño
+         * realista y otro de estrés. Los resultados se guardan en JSON para usarlos como
+         * referencia (baseline) y comparar con ella las ejecuciones siguientes.
+         */
+        class Benchmark_Suite
+        {
+        public:
+
+            struct Result
+            {
+                std::string name;
+                unsigned    size;                       ///< Número de entidades con que se ha medido.
+                double      nanoseconds;                ///< Mejor tiempo medio por operación entre las repeticiones.
+            };
+
+            struct Regression
+            {
+                std::string name;
+                unsigned    size;
+                double      baseline_nanoseconds;
+                double      nanoseconds;
+                double      percent;                    ///< Cuánto más lento es que la referencia.
+            };
+
+            typedef std::vector< Result     > Results;
+            typedef std::vector< Regression > Regressions;
+
+            /**
+             * Un benchmark ejecuta en cada llamada a 'batch' un lote de operaciones (del que devuelve
+             * cuántas ha hecho) y, si hace falta, deja listo el estado para el siguiente lote con
+             * 'reset', que no se mide.
+             */
+            struct Benchmark
+            {
+                std::string                  name;
+                unsigned                     size;
+                std::function< uint64_t () > batch;
+                std::function< void     () > reset;
+            };
+
+        private:
+
+            std::vector< Benchmark > benchmarks;
+            unsigned                 repetitions;
+            double                   minimum_seconds;   ///< Tiempo mínimo que se mide en cada repetición.
+
+        public:
+
+            /**
+             * Crea la suite con todos los benchmarks del juego.
+             */
+            Benchmark_Suite(unsigned repetitions = 5, double minimum_seconds = .02);
+
+            void add (Benchmark benchmark)
+            {
+                benchmarks.push_back (std::move (benchmark));
+            }
+
+            /**
+             * Ejecuta todos los benchmarks.
+             */
+            Results run () const;
+
+        public:
+
+            static std::string to_json (const Results & results);
+
+            /**
+             * Lee un fichero escrito con to_json().
+             * @return false si no se puede leer o no contiene ningún resultado.
+             */
+            static bool load (const std::string & path, Results & results);
+
+            /**
+             * Devuelve los benchmarks de 'results' que son más de 'threshold_percent' por ciento más
+             * lentos que el de 'baseline' con el mismo nombre y tamaño. Los que no están en la
+             * referencia no se comparan.
+             */
+            static Regressions compare (const Results & results, const Results & baseline, double threshold_percent);
+
+        private:
+
+            template< typename SCALAR >
+            void add_gameobject_benchmarks (unsigned size, const std::string & prefix);
+            void add_scene_benchmarks      (const Scenario & scenario);
+            void add_random_benchmarks     ();
+            void add_spatial_benchmarks    (unsigned entities);
+            void add_animation_benchmarks  (unsigned sprites);
+            void add_particle_benchmarks   (unsigned particles);
+
+        };
+
+    }
+
+#endif
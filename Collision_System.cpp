@@ -0,0 +1,133 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Collision_System.hpp"
+
+#include <algorithm>
+
+namespace jesus_villar_examen
+{
+
+    constexpr unsigned Collision_System::max_layers;                ///< Número de bits de categoría.
+
+    // ---------------------------------------------------------------------------------------------
+
+    Collision_System::Collision_System(size_t capacity)
+    :
+        capacity   (capacity),
+        overflowed (0)
+    {
+        contacts.reserve (capacity);
+
+        clear ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    static unsigned index_of (uint32_t layer)
+    {
+        unsigned index = 0;
+
+        while (index < Collision_System::max_layers - 1 && !(layer & (1u << index))) ++index;
+
+        return index;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Collision_System::enable (uint32_t first_layer, uint32_t second_layer, bool enabled)
+    {
+        uint32_t & first_mask  = masks[index_of (first_layer )];
+        uint32_t & second_mask = masks[index_of (second_layer)];
+
+        if (enabled)
+        {
+            first_mask  |=  second_layer;
+            second_mask |=  first_layer;
+        }
+        else
+        {
+            first_mask  &= ~second_layer;
+            second_mask &= ~first_layer;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    uint32_t Collision_System::get_mask (uint32_t layer) const
+    {
+        return masks[index_of (layer)];
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Collision_System::clear ()
+    {
+        std::fill_n (masks, max_layers, 0u);
+
+        contacts.clear ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Solo se recorre la mitad superior de la matriz (incluida la diagonal) para no repetir pares.
+    // De cada par se recorre la capa cuyas cajas ocupan menos celdas en total, que es la que menos
+    // celdas del índice obliga a visitar.
+    // Dentro de una misma capa cada par se encontraría dos veces, así que solo se acepta cuando el
+    // objeto encontrado está después del que se recorre.
+    // Con el buffer lleno se sigue recorriendo para contar los contactos descartados.
+
+    void Collision_System::detect (Spatial_Index & index)
+    {
+        contacts.clear ();
+
+        overflowed = 0;
+
+        for (unsigned first = 0; first < max_layers; ++first)
+        {
+            for (unsigned second = first; second < max_layers; ++second)
+            {
+                uint32_t first_layer  = 1u << first;
+                uint32_t second_layer = 1u << second;
+
+                if (!(masks[first] & second_layer)) continue;
+
+                bool     same_layer   = first == second;
+                bool     swap         = index.count_cells (second_layer) < index.count_cells (first_layer);
+                uint32_t driver_layer = swap ? second_layer : first_layer;
+                uint32_t query_layer  = swap ? first_layer  : second_layer;
+
+                index.visit_category (driver_layer, [&] (const GameObject & object)
+                {
+                    index.visit_rectangle
+                    (
+                        object.get_left_x (), object.get_bottom_y (), object.get_right_x (), object.get_top_y (), query_layer,
+                        [&] (const GameObject & other)
+                        {
+                            if (same_layer && &other <= &object) return true;
+
+                            if (contacts.size () == capacity)
+                            {
+                                ++overflowed;
+                                return true;
+                            }
+
+                            if (swap) contacts.push_back ({ &other,  &object, first_layer, second_layer });
+                            else      contacts.push_back ({ &object, &other,  first_layer, second_layer });
+
+                            return true;
+                        }
+                    );
+                });
+            }
+        }
+    }
+
+}
@@ -0,0 +1,138 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef COLLISION_SYSTEM_HEADER
+#define COLLISION_SYSTEM_HEADER
+
+    #include <cstdint>
+
+    #include "GameObject.hpp"
+    #include "Spatial_Index.hpp"
+    #include "Memory_Tracker.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Detección de colisiones entre capas. Cada gameobject pertenece a una capa, que es la
+         * categoría (un solo bit) con la que se inserta en el Spatial_Index, y una matriz simétrica
+         * indica qué pares de capas chocan entre sí (la fila de cada capa es su máscara). Solo se
+         * comprueban los pares habilitados.
+         *
+         * detect() no modifica ningún gameobject: guarda los contactos en un buffer plano y
+         * dispatch() los entrega después, de uno en uno y en el orden en que se detectaron, a quien
+         * los procese. Así las respuestas (mover, ocultar...) no alteran la detección a mitad de
+         * recorrido. Como los contactos se calculan con las cajas del índice, quien los procese
+         * debe confirmar con intersects() los de objetos que ya hayan cambiado en ese paso.
+         *
+         * El buffer de contactos se reserva al crear el sistema y no crece: los contactos que no
+         * caben en un paso se descartan y se cuentan en get_overflowed_contacts().
+         */
+        class Collision_System
+        {
+        public:
+
+            static constexpr unsigned max_layers = 32;  ///< Número de bits de categoría.
+
+            /**
+             * Par de objetos cuyas cajas se solapan. 'first' es siempre el de la capa de bit más
+             * bajo, por lo que el orden de cada tipo de contacto se conoce de antemano.
+             */
+            struct Contact
+            {
+                const GameObject * first;
+                const GameObject * second;
+                uint32_t           first_layer;         ///< Categoría (bit) de first.
+                uint32_t           second_layer;        ///< Categoría (bit) de second.
+            };
+
+        private:
+
+            uint32_t                                   masks[max_layers];  ///< Fila de la matriz de cada capa: capas con las que choca.
+            Tracked_Vector< Contact, MEMORY_CONTACTS > contacts;           ///< Contactos del último detect().
+            size_t                                     capacity;           ///< Número máximo de contactos que se guardan en cada detect().
+            size_t                                     overflowed;         ///< Contactos descartados en el último detect() por falta de sitio.
+
+        public:
+
+            /**
+             * @param capacity Número máximo de contactos que se guardan en cada detect().
+             */
+            explicit Collision_System(size_t capacity);
+
+        public:
+
+            /**
+             * Habilita o deshabilita las colisiones entre dos capas (pueden ser la misma).
+             * @param first_layer  Categoría de un solo bit.
+             * @param second_layer Categoría de un solo bit.
+             */
+            void enable (uint32_t first_layer, uint32_t second_layer, bool enabled = true);
+
+            bool is_enabled (uint32_t first_layer, uint32_t second_layer) const
+            {
+                return (get_mask (first_layer) & second_layer) != 0;
+            }
+
+            /**
+             * Capas con las que choca una capa.
+             */
+            uint32_t get_mask (uint32_t layer) const;
+
+            /**
+             * Deshabilita todos los pares.
+             */
+            void clear ();
+
+        public:
+
+            /**
+             * Busca los contactos entre los objetos del índice (ya construido) de cada par de capas
+             * habilitado. Por cada par se recorren los objetos de una de las capas y se consulta el
+             * índice por los de la otra.
+             */
+            void detect (Spatial_Index & index);
+
+            /**
+             * Llama a handler(const Contact &) con cada contacto del último detect().
+             */
+            template< typename HANDLER >
+            void dispatch (HANDLER && handler) const
+            {
+                for (const Contact & contact : contacts)
+                {
+                    handler (contact);
+                }
+            }
+
+            size_t get_contact_count () const
+            {
+                return contacts.size ();
+            }
+
+            size_t get_capacity () const
+            {
+                return capacity;
+            }
+
+            /**
+             * Contactos que el último detect() encontró pero no guardó porque el buffer estaba lleno.
+             */
+            size_t get_overflowed_contacts () const
+            {
+                return overflowed;
+            }
+
+        };
+
+    }
+
+#endif
@@ -0,0 +1,235 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Counter_Random.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define COUNTER_RANDOM_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define COUNTER_RANDOM_USE_NEON
+#endif
+
+namespace jesus_villar_examen
+{
+
+    constexpr unsigned Counter_Random::lanes;                       ///< Números de 32 bits que produce cada bloque.
+
+    // ---------------------------------------------------------------------------------------------
+    // Constantes de Philox4x32 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+    // El contador es (index, frame, stream, 0) y la clave, la semilla.
+
+    static constexpr uint32_t philox_multiplier_0 = 0xD2511F53u;
+    static constexpr uint32_t philox_multiplier_1 = 0xCD9E8D57u;
+    static constexpr uint32_t philox_weyl_0       = 0x9E3779B9u;
+    static constexpr uint32_t philox_weyl_1       = 0xBB67AE85u;
+    static constexpr unsigned philox_rounds       = 10;
+
+    Counter_Random::Block Counter_Random::generate (uint32_t stream, uint32_t frame, uint32_t index) const
+    {
+        uint32_t counter[4] = { index, frame, stream, 0 };
+        uint32_t key_0      = key[0];
+        uint32_t key_1      = key[1];
+
+        for (unsigned round = 0; round < philox_rounds; ++round)
+        {
+            uint64_t product_0 = uint64_t(philox_multiplier_0) * counter[0];
+            uint64_t product_1 = uint64_t(philox_multiplier_1) * counter[2];
+
+            uint32_t next[4] =
+            {
+                uint32_t(product_1 >> 32) ^ counter[1] ^ key_0,
+                uint32_t(product_1),
+                uint32_t(product_0 >> 32) ^ counter[3] ^ key_1,
+                uint32_t(product_0),
+            };
+
+            std::copy (next, next + 4, counter);
+
+            key_0 += philox_weyl_0;
+            key_1 += philox_weyl_1;
+        }
+
+        return Block { { counter[0], counter[1], counter[2], counter[3] } };
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Con SIMD se calculan 4 bloques a la vez: cada registro guarda la misma palabra del contador
+    // de los 4 bloques, así que cada ronda son dos multiplicaciones de 4 carriles. Al terminar se
+    // trasponen para escribir los números en el orden de generate().
+
+    void Counter_Random::fill_uniform (uint32_t stream, uint32_t frame, uint32_t first_index, float * values, size_t count) const
+    {
+        size_t   written = 0;
+        uint32_t index   = first_index;
+
+        #if defined(COUNTER_RANDOM_USE_SSE2)
+
+            const __m128i multiplier_0 = _mm_set1_epi32 (int(philox_multiplier_0));
+            const __m128i multiplier_1 = _mm_set1_epi32 (int(philox_multiplier_1));
+
+            // Parte alta y baja de los productos de 32x32 bits de los 4 carriles:
+
+            auto multiply = [] (__m128i a, __m128i b, __m128i & high, __m128i & low)
+            {
+                __m128i even = _mm_mul_epu32 (a, b);
+                __m128i odd  = _mm_mul_epu32 (_mm_srli_epi64 (a, 32), b);
+
+                low  = _mm_unpacklo_epi32 (_mm_shuffle_epi32 (even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32 (odd, _MM_SHUFFLE(0, 0, 2, 0)));
+                high = _mm_unpacklo_epi32 (_mm_shuffle_epi32 (even, _MM_SHUFFLE(0, 0, 3, 1)), _mm_shuffle_epi32 (odd, _MM_SHUFFLE(0, 0, 3, 1)));
+            };
+
+            for ( ; written + 16 <= count; written += 16, index += 4)
+            {
+                __m128i counter_0 = _mm_add_epi32 (_mm_set1_epi32 (int(index)), _mm_set_epi32 (3, 2, 1, 0));
+                __m128i counter_1 = _mm_set1_epi32 (int(frame));
+                __m128i counter_2 = _mm_set1_epi32 (int(stream));
+                __m128i counter_3 = _mm_setzero_si128 ();
+                uint32_t key_0    = key[0];
+                uint32_t key_1    = key[1];
+
+                for (unsigned round = 0; round < philox_rounds; ++round)
+                {
+                    __m128i high_0, low_0, high_1, low_1;
+
+                    multiply (counter_0, multiplier_0, high_0, low_0);
+                    multiply (counter_2, multiplier_1, high_1, low_1);
+
+                    counter_0 = _mm_xor_si128 (_mm_xor_si128 (high_1, counter_1), _mm_set1_epi32 (int(key_0)));
+                    counter_1 = low_1;
+                    counter_2 = _mm_xor_si128 (_mm_xor_si128 (high_0, counter_3), _mm_set1_epi32 (int(key_1)));
+                    counter_3 = low_0;
+
+                    key_0 += philox_weyl_0;
+                    key_1 += philox_weyl_1;
+                }
+
+                // Se trasponen al escribir: el número 'word' del bloque 'block' está en el carril
+                // 'block' del registro 'word':
+
+                __m128i words[4] = { counter_0, counter_1, counter_2, counter_3 };
+                uint32_t lanes_of[4][4];
+
+                for (unsigned word = 0; word < 4; ++word)
+                {
+                    _mm_storeu_si128 (reinterpret_cast< __m128i * >(lanes_of[word]), words[word]);
+                }
+
+                for (unsigned block = 0; block < 4; ++block)
+                {
+                    for (unsigned word = 0; word < 4; ++word)
+                    {
+                        values[written + block * 4 + word] = to_uniform (lanes_of[word][block]);
+                    }
+                }
+            }
+
+        #elif defined(COUNTER_RANDOM_USE_NEON)
+
+            const uint32x4_t lane_offsets = { 0, 1, 2, 3 };
+
+            auto multiply = [] (uint32x4_t a, uint32_t b, uint32x4_t & high, uint32x4_t & low)
+            {
+                uint64x2_t first  = vmull_n_u32 (vget_low_u32  (a), b);
+                uint64x2_t second = vmull_n_u32 (vget_high_u32 (a), b);
+
+                low  = vmulq_n_u32  (a, b);
+                high = vcombine_u32 (vshrn_n_u64 (first, 32), vshrn_n_u64 (second, 32));
+            };
+
+            for ( ; written + 16 <= count; written += 16, index += 4)
+            {
+                uint32x4_t counter_0 = vaddq_u32 (vdupq_n_u32 (index), lane_offsets);
+                uint32x4_t counter_1 = vdupq_n_u32 (frame);
+                uint32x4_t counter_2 = vdupq_n_u32 (stream);
+                uint32x4_t counter_3 = vdupq_n_u32 (0);
+                uint32_t   key_0     = key[0];
+                uint32_t   key_1     = key[1];
+
+                for (unsigned round = 0; round < philox_rounds; ++round)
+                {
+                    uint32x4_t high_0, low_0, high_1, low_1;
+
+                    multiply (counter_0, philox_multiplier_0, high_0, low_0);
+                    multiply (counter_2, philox_multiplier_1, high_1, low_1);
+
+                    counter_0 = veorq_u32 (veorq_u32 (high_1, counter_1), vdupq_n_u32 (key_0));
+                    counter_1 = low_1;
+                    counter_2 = veorq_u32 (veorq_u32 (high_0, counter_3), vdupq_n_u32 (key_1));
+                    counter_3 = low_0;
+
+                    key_0 += philox_weyl_0;
+                    key_1 += philox_weyl_1;
+                }
+
+                // vst4q intercala las cuatro palabras, que es justo el orden de generate():
+
+                uint32x4x4_t words = {{ counter_0, counter_1, counter_2, counter_3 }};
+                uint32_t     bits[16];
+
+                vst4q_u32 (bits, words);
+
+                for (unsigned value = 0; value < 16; ++value)
+                {
+                    values[written + value] = to_uniform (bits[value]);
+                }
+            }
+
+        #endif
+
+        // Lo que no llena 4 bloques completos (o todo, sin SIMD) se calcula bloque a bloque:
+
+        for ( ; written < count; ++index)
+        {
+            Block block = generate (stream, frame, index);
+
+            for (unsigned lane = 0; lane < lanes && written < count; ++lane)
+            {
+                values[written++] = to_uniform (block.values[lane]);
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Si los bloques pedidos pasan del último índice del fotograma se generan en dos tandas para
+    // continuar por el siguiente, igual que next().
+
+    void Random_Stream::fill_uniform (float * values, size_t count)
+    {
+        used = Counter_Random::lanes;
+
+        while (count > 0)
+        {
+            uint64_t blocks_left = uint64_t(0x100000000ull) - index;
+            size_t   amount      = size_t(std::min< uint64_t > (count, blocks_left * Counter_Random::lanes));
+            uint64_t blocks      = (amount + Counter_Random::lanes - 1) / Counter_Random::lanes;
+
+            random.fill_uniform (stream, frame, index, values, amount);
+
+            if (blocks == blocks_left)
+            {
+                index = 0;
+                frame++;
+            }
+            else
+            {
+                index += uint32_t(blocks);
+            }
+
+            values += amount;
+            count  -= amount;
+        }
+    }
+
+}
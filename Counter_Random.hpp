@@ -0,0 +1,172 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef COUNTER_RANDOM_HEADER
+#define COUNTER_RANDOM_HEADER
+
+    #include <cstddef>
+    #include <cstdint>
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Generador de números aleatorios basado en contador (Philox4x32-10). No tiene estado: cada
+         * bloque de 4 números de 32 bits es una función de la semilla y de un contador formado por
+         * un flujo (por ejemplo, un propósito o una entidad), un fotograma y un índice. Por eso se
+         * puede usar desde varios hilos a la vez y una partida se reproduce igual con la misma
+         * semilla, sin depender del orden en el que se pidan los números de flujos distintos.
+         */
+        class Counter_Random
+        {
+        public:
+
+            static constexpr unsigned lanes = 4;        ///< Números de 32 bits que produce cada bloque.
+
+            struct Block
+            {
+                uint32_t values[lanes];
+            };
+
+        private:
+
+            uint32_t key[2];
+
+        public:
+
+            explicit Counter_Random(uint64_t seed = 0)
+            {
+                set_seed (seed);
+            }
+
+            void set_seed (uint64_t seed)
+            {
+                key[0] = uint32_t(seed      );
+                key[1] = uint32_t(seed >> 32);
+            }
+
+            uint64_t get_seed () const
+            {
+                return uint64_t(key[1]) << 32 | key[0];
+            }
+
+        public:
+
+            /**
+             * Bloque de 4 números de 32 bits que corresponde a un contador.
+             */
+            Block generate (uint32_t stream, uint32_t frame, uint32_t index) const;
+
+            /**
+             * Número uniforme en [0, 1) que corresponde a un contador (el primero de su bloque).
+             */
+            float uniform (uint32_t stream, uint32_t frame, uint32_t index) const
+            {
+                return to_uniform (generate (stream, frame, index).values[0]);
+            }
+
+            /**
+             * Rellena 'values' con números uniformes en [0, 1) tomados de los bloques consecutivos
+             * que empiezan en first_index: values[i] es el número i % 4 del bloque first_index + i / 4.
+             * Se calculan varios bloques a la vez con SIMD (SSE2 o NEON según la plataforma) y el
+             * resultado es idéntico al de generate().
+             */
+            void fill_uniform (uint32_t stream, uint32_t frame, uint32_t first_index, float * values, size_t count) const;
+
+            /**
+             * Convierte 32 bits aleatorios en un float uniforme en [0, 1) (usa los 24 más altos).
+             */
+            static float to_uniform (uint32_t bits)
+            {
+                return float(bits >> 8) * (1.f / 16777216.f);
+            }
+
+        };
+
+        /**
+         * Secuencia de números de un flujo de Counter_Random en un fotograma, para quien necesita
+         * varios números seguidos sin llevar la cuenta de los índices. Cada copia avanza por su
+         * cuenta, así que dos copias del mismo flujo repiten los mismos números.
+         */
+        class Random_Stream
+        {
+            Counter_Random        random;
+            uint32_t              stream;
+            uint32_t              frame;
+            uint32_t              index;                ///< Siguiente bloque que se genera.
+            Counter_Random::Block block;                ///< Último bloque generado.
+            unsigned              used;                 ///< Números de block ya entregados.
+
+        public:
+
+            Random_Stream(const Counter_Random & random = Counter_Random(), uint32_t stream = 0, uint32_t frame = 0)
+            :
+                random (random),
+                stream (stream),
+                frame  (frame ),
+                index  (0),
+                used   (Counter_Random::lanes)
+            {
+            }
+
+        public:
+
+            /**
+             * Siguientes 32 bits. Si se agotan los índices del fotograma se continúa por el siguiente.
+             */
+            uint32_t next ()
+            {
+                if (used == Counter_Random::lanes)
+                {
+                    block = random.generate (stream, frame, index);
+                    used  = 0;
+
+                    if (++index == 0) ++frame;
+                }
+
+                return block.values[used++];
+            }
+
+            /**
+             * Número uniforme en [0, 1).
+             */
+            float next_float ()
+            {
+                return Counter_Random::to_uniform (next ());
+            }
+
+            /**
+             * Número uniforme en [min, max).
+             */
+            float next_float (float min, float max)
+            {
+                return min + (max - min) * next_float ();
+            }
+
+            /**
+             * Entero uniforme en [0, bound) (0 si bound es 0).
+             */
+            uint32_t next_below (uint32_t bound)
+            {
+                return uint32_t((uint64_t(next ()) * bound) >> 32);
+            }
+
+            /**
+             * Rellena 'values' con números uniformes en [0, 1) generando varios bloques a la vez.
+             * Descarta lo que quedara del bloque actual.
+             */
+            void fill_uniform (float * values, size_t count);
+
+        };
+
+    }
+
+#endif
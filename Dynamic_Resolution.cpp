@@ -0,0 +1,115 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Dynamic_Resolution.hpp"
+
+#include <algorithm>
+
+namespace jesus_villar_examen
+{
+
+    constexpr float Dynamic_Resolution::smoothing;                 ///< Peso de cada nueva medida en la media exponencial.
+
+    // ---------------------------------------------------------------------------------------------
+
+    Dynamic_Resolution::Dynamic_Resolution(const Settings & settings)
+    :
+        settings    (settings),
+        metrics     { settings.max_scale, 0.f, 0, 0, 0 },
+        frames_over (0),
+        frames_under(0),
+        floor_scale (settings.min_scale),
+        milliseconds_at_decrease (0.f)
+    {
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Dynamic_Resolution::set_settings (const Settings & new_settings)
+    {
+        settings      = new_settings;
+        metrics.scale = std::min (std::max (metrics.scale, settings.min_scale), settings.max_scale);
+        frames_over   = 0;
+        frames_under  = 0;
+        floor_scale   = settings.min_scale;
+
+        milliseconds_at_decrease = 0.f;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Se cuenta cuántos fotogramas seguidos está la media por encima del objetivo o por debajo del
+    // objetivo menos el margen. Entre ambos umbrales no se cambia nada. Una bajada se comprueba en
+    // la siguiente decisión de bajar: si la media no es menor que cuando se hizo, no ha servido.
+
+    float Dynamic_Resolution::update (float frame_milliseconds)
+    {
+        metrics.frame_milliseconds = metrics.frame_milliseconds > 0.f
+                                   ? metrics.frame_milliseconds + (frame_milliseconds - metrics.frame_milliseconds) * smoothing
+                                   : frame_milliseconds;
+
+        if (metrics.frame_milliseconds > settings.target_milliseconds)
+        {
+            frames_under = 0;
+
+            if (++frames_over >= settings.frames_to_decrease)
+            {
+                if (milliseconds_at_decrease > 0.f && metrics.frame_milliseconds >= milliseconds_at_decrease)
+                {
+                    metrics.scale = std::min (metrics.scale + settings.scale_step, settings.max_scale);
+                    metrics.reverts++;
+                    floor_scale   = metrics.scale;
+
+                    milliseconds_at_decrease = 0.f;
+                }
+                else
+                {
+                    float lowest = std::max (settings.min_scale, floor_scale);
+
+                    milliseconds_at_decrease = 0.f;
+
+                    if (metrics.scale > lowest)
+                    {
+                        metrics.scale = std::max (metrics.scale - settings.scale_step, lowest);
+                        metrics.decreases++;
+
+                        milliseconds_at_decrease = metrics.frame_milliseconds;
+                    }
+                }
+
+                frames_over = 0;
+            }
+        }
+        else if (metrics.frame_milliseconds < settings.target_milliseconds * (1.f - settings.headroom))
+        {
+            frames_over = 0;
+            floor_scale = settings.min_scale;
+
+            milliseconds_at_decrease = 0.f;
+
+            if (++frames_under >= settings.frames_to_increase && metrics.scale < settings.max_scale)
+            {
+                metrics.scale = std::min (metrics.scale + settings.scale_step, settings.max_scale);
+                metrics.increases++;
+                frames_under = 0;
+            }
+        }
+        else
+        {
+            frames_over  = 0;
+            frames_under = 0;
+
+            milliseconds_at_decrease = 0.f;
+        }
+
+        return metrics.scale;
+    }
+
+}
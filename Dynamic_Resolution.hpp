@@ -0,0 +1,96 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef DYNAMIC_RESOLUTION_HEADER
+#define DYNAMIC_RESOLUTION_HEADER
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Controla la escala de resolución a la que se dibuja a partir del tiempo que tarda cada
+         * fotograma. Baja la escala cuando el tiempo supera el objetivo durante varios fotogramas
+         * seguidos y la sube cuando sobra margen durante bastantes más, de modo que no oscila
+         * alrededor del límite (histéresis). Si una bajada no ha reducido el tiempo cuando toca
+         * volver a decidir (por ejemplo, porque ampliar la imagen cuesta más de lo que se ahorra),
+         * se deshace y no se vuelve a bajar de esa escala hasta que vuelva a sobrar margen.
+         */
+        class Dynamic_Resolution
+        {
+        public:
+
+            struct Settings
+            {
+                float    min_scale;                     ///< Escala mínima (fracción de la resolución virtual).
+                float    max_scale;                     ///< Escala máxima.
+                float    target_milliseconds;           ///< Tiempo objetivo por fotograma.
+                float    headroom;                      ///< Fracción del objetivo que tiene que sobrar para subir la escala.
+                float    scale_step;                    ///< Cuánto cambia la escala en cada ajuste.
+                unsigned frames_to_decrease;            ///< Fotogramas seguidos por encima del objetivo para bajar la escala.
+                unsigned frames_to_increase;            ///< Fotogramas seguidos con margen para subir la escala.
+            };
+
+            struct Metrics
+            {
+                float    scale;                         ///< Escala actual.
+                float    frame_milliseconds;            ///< Tiempo por fotograma suavizado.
+                unsigned decreases;                     ///< Veces que se ha bajado la escala.
+                unsigned increases;                     ///< Veces que se ha subido la escala.
+                unsigned reverts;                       ///< Bajadas deshechas porque no redujeron el tiempo.
+            };
+
+            static constexpr float smoothing = .1f;    ///< Peso de cada nueva medida en la media exponencial.
+
+        private:
+
+            Settings settings;
+            Metrics  metrics;
+            unsigned frames_over;                       ///< Fotogramas seguidos por encima del objetivo.
+            unsigned frames_under;                      ///< Fotogramas seguidos con margen.
+            float    floor_scale;                       ///< Escala de la que no se baja tras deshacer una bajada.
+            float    milliseconds_at_decrease;          ///< Tiempo suavizado al bajar la escala (0 si no hay bajada por comprobar).
+
+        public:
+
+            Dynamic_Resolution(const Settings & settings);
+
+        public:
+
+            const Settings & get_settings () const
+            {
+                return settings;
+            }
+
+            const Metrics & get_metrics () const
+            {
+                return metrics;
+            }
+
+            float get_scale () const
+            {
+                return metrics.scale;
+            }
+
+            /**
+             * Cambia los límites y la histéresis. La escala actual se ajusta a los nuevos límites.
+             */
+            void set_settings (const Settings & new_settings);
+
+            /**
+             * Registra la duración de un fotograma y devuelve la escala con la que dibujar el siguiente.
+             */
+            float update (float frame_milliseconds);
+
+        };
+
+    }
+
+#endif
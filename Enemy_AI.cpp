@@ -0,0 +1,225 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Enemy_AI.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace jesus_villar_examen
+{
+
+    constexpr float Enemy_AI::dodge_speed;
+    constexpr float Enemy_AI::dodge_duration;
+    constexpr float Enemy_AI::max_rate_scale;
+
+    // ---------------------------------------------------------------------------------------------
+
+    Enemy_AI::Enemy_AI(unsigned agents_per_step, float budget_microseconds, float think_interval)
+    :
+        agents_per_step     (std::max (agents_per_step, 1u)),
+        budget_microseconds (budget_microseconds),
+        think_interval      (think_interval)
+    {
+        reset (0);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Enemy_AI::reset (unsigned agent_count)
+    {
+        rate_scale = 1.f;
+        now        = 0.f;
+        cursor     = 0;
+        metrics    = Metrics { 0.f, 0.f, 0, 0.f, 0.f, 1.f };
+
+        agents.assign (agent_count, Agent { 0.f, 0.f, false, false });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Se recorren los agentes en orden round-robin empezando donde se quedó el fotograma anterior.
+    // Solo piensan los que han superado su intervalo y se corta en cuanto se agota el cupo, de modo
+    // que los que no han podido pensar serán los primeros en el fotograma siguiente.
+
+    void Enemy_AI::update (float time, const Perception & perception, Agent_List & submarines)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        now += time;
+
+        const Clock::time_point start    = Clock::now ();
+        const unsigned          count    = unsigned(std::min (agents.size (), submarines.size ()));
+        const float             interval = think_interval * rate_scale;
+
+        bool exhausted = false;
+
+        metrics.updated_agents = 0;
+
+        for (unsigned visited = 0; visited < count; ++visited)
+        {
+            if (metrics.updated_agents == agents_per_step)
+            {
+                exhausted = true;
+                break;
+            }
+
+            if (cursor >= count) cursor = 0;
+
+            Agent & agent = agents[cursor];
+
+            if (now - agent.last_think_time >= interval)
+            {
+                think (agent, *submarines[cursor], perception);
+
+                agent.last_think_time = now;
+
+                ++metrics.updated_agents;
+            }
+
+            ++cursor;
+        }
+
+        metrics.used_microseconds = std::chrono::duration< float, std::micro >(Clock::now () - start).count ();
+        metrics.budget_usage      = budget_microseconds > 0.f ? metrics.used_microseconds / budget_microseconds : 0.f;
+
+        // Si el cupo se agota antes de visitar a todos los agentes se reduce la frecuencia de
+        // decisión; si sobra más de la mitad se vuelve poco a poco a la frecuencia normal:
+
+        if (exhausted)
+        {
+            rate_scale = std::min (rate_scale * 1.25f, max_rate_scale);
+        }
+        else if (metrics.updated_agents * 2 < agents_per_step)
+        {
+            rate_scale = std::max (rate_scale * .95f, 1.f);
+        }
+
+        update_metrics ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Posición que tendrá un objeto tras 'time' segundos a velocidad constante. Se calcula con el
+    // tipo de los gameobjects: en coma fija el resultado es el mismo en cualquier plataforma, cosa
+    // que en float no se puede asegurar porque el compilador puede fusionar el producto y la suma
+    // en un FMA en unas (ARM) y no en otras.
+
+    static float predict (float position, float speed, float time)
+    {
+        typedef GameObject::Scalar Scalar;
+
+        return float(multiply_add (Scalar(position), Scalar(speed), Scalar(time)));
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Para apuntar se calcula cuánto tarda una bala en subir desde el submarino hasta el barco y
+    // dónde estará el barco en ese momento si mantiene su velocidad. Para esquivar se busca alguna
+    // bala del jugador que vaya a alcanzar al submarino en menos de un segundo teniendo en cuenta
+    // el avance horizontal de este.
+
+    void Enemy_AI::think (Agent & agent, GameObject & submarine, const Perception & perception)
+    {
+        if (submarine.is_not_visible ()) return;
+
+        const GameObject & ship = *perception.ship;
+
+        float flight_time = (ship.get_bottom_y () - submarine.get_top_y ()) / perception.bullet_speed;
+        float predicted_x = predict (ship.get_position_x (), ship.get_speed_x (), std::max (flight_time, 0.f));
+
+        agent.wants_to_fire = std::fabs (submarine.get_position_x () - predicted_x) < ship.get_width () * .5f;
+
+        auto is_threat = [&submarine] (const GameObject & bullet)
+        {
+            if (bullet.is_visible () && bullet.get_speed_y () < 0.f && bullet.get_bottom_y () > submarine.get_top_y ())
+            {
+                float arrival = (bullet.get_bottom_y () - submarine.get_top_y ()) / -bullet.get_speed_y ();
+
+                if (arrival < 1.f)
+                {
+                    float submarine_x = predict (submarine.get_position_x (), submarine.get_speed_x (), arrival);
+
+                    return std::fabs (submarine_x - bullet.get_position_x ()) < (submarine.get_width () + bullet.get_width ()) * .5f;
+                }
+            }
+
+            return false;
+        };
+
+        bool threatened = false;
+
+        if (perception.index)
+        {
+            // Solo pueden alcanzarlo las balas que están por encima dentro de la franja que barre
+            // el submarino durante el próximo segundo. Se deja de buscar con la primera amenaza:
+
+            float sweep = submarine.get_speed_x ();
+
+            perception.index->visit_rectangle
+            (
+                submarine.get_left_x  () + std::min (sweep, 0.f), submarine.get_top_y (),
+                submarine.get_right_x () + std::max (sweep, 0.f), std::numeric_limits< float >::max (),
+                perception.bullet_categories,
+                [&] (const GameObject & bullet) { return !(threatened = is_threat (bullet)); }
+            );
+        }
+        else for (auto & bullet : *perception.player_bullets)
+        {
+            if (is_threat (*bullet))
+            {
+                threatened = true;
+                break;
+            }
+        }
+
+        if (threatened)
+        {
+            // Se bucea salvo que no haya sitio, en cuyo caso se sube:
+
+            bool room_below = submarine.get_bottom_y () - dodge_speed * dodge_duration > perception.floor_y;
+
+            submarine.set_speed_y (room_below ? -dodge_speed : dodge_speed);
+
+            agent.dodge_until = now + dodge_duration;
+            agent.dodging     = true;
+        }
+        else if (agent.dodging && now >= agent.dodge_until)
+        {
+            // Solo se detiene la esquiva propia: fuera de ella la velocidad vertical puede ser la
+            // de un script de comportamiento
+
+            submarine.set_speed_y (0.f);
+
+            agent.dodging = false;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Enemy_AI::update_metrics ()
+    {
+        float max_staleness   = 0.f;
+        float total_staleness = 0.f;
+
+        for (const Agent & agent : agents)
+        {
+            float staleness = now - agent.last_think_time;
+
+            max_staleness    = std::max (max_staleness, staleness);
+            total_staleness += staleness;
+        }
+
+        metrics.max_staleness     = max_staleness;
+        metrics.average_staleness = agents.empty () ? 0.f : total_staleness / agents.size ();
+        metrics.rate_scale        = rate_scale;
+    }
+
+}
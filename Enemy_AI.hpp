@@ -0,0 +1,147 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef ENEMY_AI_HEADER
+#define ENEMY_AI_HEADER
+
+    #include <memory>
+    #include <vector>
+
+    #include "GameObject.hpp"
+    #include "Memory_Tracker.hpp"
+    #include "Spatial_Index.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * IA de los submarinos repartida en el tiempo. En cada paso solo se actualizan los agentes
+         * a los que les toca (en orden round-robin) y nunca piensan más de un cupo fijo de agentes.
+         * Si el cupo se agota con frecuencia, los agentes pasan a pensar con menos frecuencia
+         * hasta que vuelve a sobrar. El cupo no depende del tiempo real, así que una simulación con
+         * la misma semilla y la misma entrada toma las mismas decisiones en cualquier máquina; el
+         * tiempo consumido solo se mide para las métricas.
+         */
+        class Enemy_AI
+        {
+        public:
+
+            typedef Tracked_Vector< std::shared_ptr< GameObject >, MEMORY_ENTITIES > Agent_List;
+
+            /**
+             * Información del mundo que necesitan los agentes para decidir.
+             */
+            struct Perception
+            {
+                const GameObject * ship;                ///< Barco del jugador al que se apunta.
+                const Agent_List * player_bullets;      ///< Balas del jugador que hay que esquivar.
+                float              bullet_speed;        ///< Velocidad vertical de las balas enemigas.
+                float              floor_y;             ///< Coordenada y más baja a la que pueden bajar los submarinos.
+                Spatial_Index    * index;               ///< Si no es nullptr, se usa para buscar solo las balas cercanas.
+                uint32_t           bullet_categories;   ///< Categorías con las que están las balas del jugador en el índice.
+            };
+
+            /**
+             * Métricas del último fotograma.
+             */
+            struct Metrics
+            {
+                float    used_microseconds;             ///< Tiempo consumido por la IA.
+                float    budget_usage;                  ///< Fracción del presupuesto de tiempo consumida (solo informativa: puede superar 1).
+                unsigned updated_agents;                ///< Agentes que han pensado en este fotograma (como mucho el cupo).
+                float    max_staleness;                 ///< Segundos desde que pensó el agente más desactualizado.
+                float    average_staleness;             ///< Media de segundos desde que pensó cada agente.
+                float    rate_scale;                    ///< Multiplicador aplicado al intervalo entre decisiones.
+            };
+
+        private:
+
+            /**
+             * Estado compacto de cada agente.
+             */
+            struct Agent
+            {
+                float last_think_time;                  ///< Tiempo de simulación en el que pensó por última vez.
+                float dodge_until;                      ///< Tiempo de simulación hasta el que sigue esquivando.
+                bool  wants_to_fire;                    ///< Si la última decisión fue que está alineado con el barco.
+                bool  dodging;                          ///< Si la velocidad vertical del submarino es la de una esquiva.
+            };
+
+        private:
+
+            unsigned            agents_per_step;        ///< Cupo de agentes que pueden pensar en cada paso.
+            float               budget_microseconds;    ///< Tiempo que se espera que consuma la IA en cada paso (solo para las métricas).
+            float               think_interval;         ///< Segundos entre decisiones de un agente con la carga normal.
+            float               rate_scale;             ///< Multiplicador del intervalo que se ajusta según la carga.
+            float               now;                    ///< Tiempo de simulación acumulado.
+            unsigned            cursor;                 ///< Siguiente agente en el orden round-robin.
+
+            Tracked_Vector< Agent, MEMORY_ENTITIES > agents;
+            Metrics              metrics;
+
+        public:
+
+            static constexpr float dodge_speed    = 150.f;  ///< Velocidad vertical con la que un submarino esquiva.
+            static constexpr float dodge_duration = .6f;    ///< Segundos que dura una maniobra de esquiva.
+            static constexpr float max_rate_scale = 8.f;    ///< Límite al que se puede reducir la frecuencia de decisión.
+
+        public:
+
+            /**
+             * @param agents_per_step Número máximo de agentes que piensan en cada paso.
+             * @param budget_microseconds Tiempo con el que se compara el consumido en budget_usage.
+             * @param think_interval Segundos entre decisiones de cada agente cuando sobra cupo.
+             */
+            Enemy_AI(unsigned agents_per_step, float budget_microseconds, float think_interval);
+
+        public:
+
+            /**
+             * Descarta el estado de los agentes y prepara el de 'agent_count' agentes nuevos.
+             */
+            void reset (unsigned agent_count);
+
+            /**
+             * Avanza el tiempo de la IA y actualiza los agentes que toque sin pasarse del cupo.
+             * Las decisiones de movimiento se aplican directamente sobre los submarinos.
+             * @param time Fracción de tiempo que se debe avanzar.
+             * @param perception Información del mundo.
+             * @param submarines Submarinos controlados (uno por agente, en el mismo orden).
+             */
+            void update (float time, const Perception & perception, Agent_List & submarines);
+
+            /**
+             * Indica si el agente estaba alineado con la posición prevista del barco en su última decisión.
+             */
+            bool wants_to_fire (unsigned agent) const
+            {
+                return agent < agents.size () && agents[agent].wants_to_fire;
+            }
+
+            const Metrics & get_metrics () const
+            {
+                return metrics;
+            }
+
+        private:
+
+            /**
+             * Toma las decisiones de un agente: si está alineado para disparar y si debe esquivar.
+             */
+            void think (Agent & agent, GameObject & submarine, const Perception & perception);
+
+            void update_metrics ();
+
+        };
+
+    }
+
+#endif
@@ -0,0 +1,257 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef FIXED_HEADER
+#define FIXED_HEADER
+
+    #include <cstdint>
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Número en coma fija con signo de 32 bits y 16 bits de parte fraccionaria (Q16.16). Las
+         * operaciones entre valores Fixed son enteras, por lo que dan exactamente el mismo resultado
+         * en cualquier plataforma y con cualquier opción de compilación. Cubre el rango [-32768, 32768) con una
+         * precisión de 1/65536, suficiente para posiciones y velocidades en coordenadas virtuales.
+         * Los resultados que se salen del rango se saturan al extremo más cercano (nunca se
+         * desborda) y dividir entre cero da el extremo con el signo del dividendo (o cero si este
+         * también es cero), igual que haría float con el infinito.
+         */
+        class Fixed
+        {
+        public:
+
+            static constexpr int     fraction_bits = 16;
+            static constexpr int32_t one           = int32_t(1) << fraction_bits;
+
+        private:
+
+            int32_t raw;
+
+        public:
+
+            constexpr Fixed() : raw(0)
+            {
+            }
+
+            /**
+             * Convierte un float redondeando al valor representable más cercano. La conversión solo
+             * multiplica por una potencia de 2 (exacto) y redondea, así que también es determinista.
+             * Los valores fuera de [-32768, 32768) se saturan y NaN se convierte en 0.
+             */
+            constexpr explicit Fixed(float value)
+            :
+                raw (round (value * float(one)))
+            {
+            }
+
+            constexpr explicit operator float () const
+            {
+                return float(raw) / float(one);
+            }
+
+            static constexpr Fixed from_raw (int32_t raw)
+            {
+                return Fixed(raw, 0);
+            }
+
+            constexpr int32_t get_raw () const
+            {
+                return raw;
+            }
+
+        public:
+
+            // Operadores aritméticos. Se calculan con 64 bits, donde ningún resultado intermedio
+            // puede desbordar, y se saturan al volver a 32. El producto se desplaza de vuelta (los
+            // compiladores soportados hacen desplazamiento aritmético):
+
+            constexpr Fixed operator -  ()              const { return saturate (-int64_t(raw));                                   }
+            constexpr Fixed operator +  (Fixed other)   const { return saturate (int64_t(raw) + other.raw);                        }
+            constexpr Fixed operator -  (Fixed other)   const { return saturate (int64_t(raw) - other.raw);                        }
+            constexpr Fixed operator *  (Fixed other)   const { return saturate ((int64_t(raw) * other.raw) >> fraction_bits);     }
+            constexpr Fixed operator /  (Fixed other)   const
+            {
+                return other.raw != 0 ? saturate (int64_t(raw) * one / other.raw) : from_raw (raw > 0 ? INT32_MAX : raw < 0 ? INT32_MIN : 0);
+            }
+
+            Fixed & operator += (Fixed other) { return *this = *this + other;   }
+            Fixed & operator -= (Fixed other) { return *this = *this - other;   }
+            Fixed & operator *= (Fixed other) { return *this = *this * other;   }
+            Fixed & operator /= (Fixed other) { return *this = *this / other;   }
+
+            constexpr bool operator == (Fixed other) const { return raw == other.raw; }
+            constexpr bool operator != (Fixed other) const { return raw != other.raw; }
+            constexpr bool operator <  (Fixed other) const { return raw <  other.raw; }
+            constexpr bool operator <= (Fixed other) const { return raw <= other.raw; }
+            constexpr bool operator >  (Fixed other) const { return raw >  other.raw; }
+            constexpr bool operator >= (Fixed other) const { return raw >= other.raw; }
+
+            /**
+             * a + b * c con un solo redondeo y una sola saturación (el producto no se satura antes
+             * de sumar).
+             */
+            friend constexpr Fixed multiply_add (Fixed a, Fixed b, Fixed c)
+            {
+                return saturate (int64_t(a.raw) + ((int64_t(b.raw) * c.raw) >> fraction_bits));
+            }
+
+        public:
+
+            // Funciones calculadas solo con enteros, así que también son deterministas (la
+            // biblioteca de float puede redondear distinto en cada plataforma):
+
+            /**
+             * Raíz cuadrada redondeada hacia abajo al valor representable anterior. La de un valor
+             * negativo es 0.
+             */
+            static Fixed sqrt (Fixed value)
+            {
+                // La raíz de raw / 2^16 en Q16.16 es la raíz entera de raw * 2^16, que cabe en 47
+                // bits. Se calcula bit a bit empezando por la mayor potencia de 4 que puede contener:
+
+                uint64_t remainder = value.raw > 0 ? uint64_t(value.raw) << fraction_bits : 0;
+                uint64_t root      = 0;
+
+                for (uint64_t bit = uint64_t(1) << 46; bit != 0; bit >>= 2)
+                {
+                    if (remainder >= root + bit)
+                    {
+                        remainder -= root + bit;
+                        root       = (root >> 1) + bit;
+                    }
+                    else
+                    {
+                        root >>= 1;
+                    }
+                }
+
+                return from_raw (int32_t(root));
+            }
+
+            /**
+             * Ángulo en radianes, en (-pi, pi], del vector (x, y) respecto al eje X, como atan2()
+             * de la biblioteca estándar. El error es de una o dos unidades de la última posición.
+             * atan2 (0, 0) es 0.
+             */
+            static Fixed atan2 (Fixed y, Fixed x)
+            {
+                // CORDIC en modo vectorial: se gira el vector hacia el eje X con ángulos de valor
+                // atan(2^-i), que solo requieren sumas y desplazamientos, acumulando lo girado con 30
+                // bits de parte fraccionaria. A partir de i = 10, atan(2^-i) * 2^30 redondeado es
+                // 2^(30 - i). Un vector con x negativo se gira antes media vuelta.
+
+                static const int64_t angles[] =
+                {
+                    843314857, 497837829, 263043837, 133525159, 67021687, 33543516, 16775851, 8388437, 4194283, 2097149
+                };
+
+                static const int64_t pi = 3373259426;
+
+                if (x.raw == 0 && y.raw == 0) return Fixed();
+
+                int64_t vector_x = int64_t(x.raw) * (int64_t(1) << 28);
+                int64_t vector_y = int64_t(y.raw) * (int64_t(1) << 28);
+                int64_t angle    = 0;
+
+                if (x.raw < 0)
+                {
+                    vector_x = -vector_x;
+                    vector_y = -vector_y;
+                    angle    = y.raw >= 0 ? pi : -pi;
+                }
+
+                for (int i = 0; i <= 30; ++i)
+                {
+                    int64_t step      = i < 10 ? angles[i] : int64_t(1) << (30 - i);
+                    int64_t shifted_x = vector_x >> i;
+                    int64_t shifted_y = vector_y >> i;
+
+                    if (vector_y > 0)
+                    {
+                        vector_x += shifted_y;
+                        vector_y -= shifted_x;
+                        angle    += step;
+                    }
+                    else
+                    {
+                        vector_x -= shifted_y;
+                        vector_y += shifted_x;
+                        angle    -= step;
+                    }
+                }
+
+                return from_raw (int32_t((angle + (int64_t(1) << 13)) >> 14));
+            }
+
+        private:
+
+            constexpr Fixed(int32_t raw, int) : raw(raw)
+            {
+            }
+
+            // Si 'value' cabe en 32 bits, truncarlo no lo cambia. Si no, se devuelve el extremo con su
+            // signo. Se escribe sin comparaciones de rango para que el compilador genere un cmov en
+            // lugar de saltos:
+
+            static constexpr Fixed saturate (int64_t value)
+            {
+                return from_raw (int32_t(value) == value ? int32_t(value) : int32_t((value >> 63) ^ INT32_MAX));
+            }
+
+            // 'scaled' ya es el valor por 2^16 (exacto). Se trunca y se corrige con la parte
+            // fraccionaria, que también es exacta, para redondear alejándose de cero sin saltos
+            // (sumar medio antes de truncar redondearía al par siguiente algunos impares a partir
+            // de 2^23):
+
+            static constexpr int32_t round (float scaled)
+            {
+                return scaled != scaled        ? 0         :
+                       scaled >=  2147483648.f ? INT32_MAX :
+                       scaled <= -2147483648.f ? INT32_MIN :
+                       round (scaled, int32_t(scaled));
+            }
+
+            static constexpr int32_t round (float scaled, int32_t truncated)
+            {
+                return truncated + (scaled - float(truncated) >= .5f) - (scaled - float(truncated) <= -.5f);
+            }
+
+        };
+
+        /**
+         * Valor en la misma escala con un tipo en el que se pueden sumar y restar unos pocos sin
+         * saturar ni desbordar: con Fixed, su valor interno en 64 bits; con float, el mismo valor.
+         * Permite calcular resultados intermedios exactos (por ejemplo, los bordes de una caja) sin
+         * pagar la saturación de cada operación.
+         */
+        constexpr int64_t widen (Fixed value)
+        {
+            return value.get_raw ();
+        }
+
+        constexpr float widen (float value)
+        {
+            return value;
+        }
+
+        /**
+         * a + b * c con float, para escribir igual el código que trabaja con los dos tipos.
+         */
+        constexpr float multiply_add (float a, float b, float c)
+        {
+            return a + b * c;
+        }
+
+    }
+
+#endif
@@ -16,58 +16,83 @@ using namespace basics;
 namespace jesus_villar_examen
 {
 
-    GameObject::GameObject(Texture_2D * texture)
+    template< typename SCALAR >
+    Basic_GameObject< SCALAR >::Basic_GameObject(Texture_2D * texture)
     :
         texture (texture)
     {
-        anchor   = basics::CENTER;
-        size     = { texture->get_width (), texture->get_height () };
-        position = { 0.f, 0.f };
-        scale    = 0.5f;
-        speed    = { 0.f, 0.f };
-        visible  = true;
+        width      = Scalar(texture->get_width  ());
+        height     = Scalar(texture->get_height ());
+        position_x = position_y = Scalar(0.f);
+        scale      = 0.5f;
+        speed_x    = speed_y    = Scalar(0.f);
+        visible    = true;
+
+        set_anchor (basics::CENTER);
     }
 
-    bool GameObject::intersects (const GameObject & other)
+    template< typename SCALAR >
+    Basic_GameObject< SCALAR >::Basic_GameObject(const Size2f & size)
+    :
+        texture (nullptr)
+    {
+        width      = Scalar(size.width );
+        height     = Scalar(size.height);
+        position_x = position_y = Scalar(0.f);
+        scale      = 0.5f;
+        speed_x    = speed_y    = Scalar(0.f);
+        visible    = true;
+
+        set_anchor (basics::CENTER);
+    }
+
+    template< typename SCALAR >
+    bool Basic_GameObject< SCALAR >::intersects (const Basic_GameObject & other) const
     {
         // Se determinan las coordenadas de la esquina inferior izquierda y de la superior derecha
-        // de este gameobject:
+        // de este gameobject (en coma fija, con 64 bits y sin saturar):
 
-        float this_left    = this->get_left_x   ();
-        float this_bottom  = this->get_bottom_y ();
-        float this_right   = this_left   + this->size.width;
-        float this_top     = this_bottom + this->size.height;
+        Wide this_left    = widen (this->position_x) - widen (this->anchor_offset_x);
+        Wide this_bottom  = widen (this->position_y) - widen (this->anchor_offset_y);
+        Wide this_right   = this_left   + widen (this->width );
+        Wide this_top     = this_bottom + widen (this->height);
 
         // Se determinan las coordenadas de la esquina inferior izquierda y de la superior derecha
         // del otro gameobject:
 
-        float other_left   = other.get_left_x   ();
-        float other_bottom = other.get_bottom_y ();
-        float other_right  = other_left   + other.size.width;
-        float other_top    = other_bottom + other.size.height;
+        Wide other_left   = widen (other.position_x) - widen (other.anchor_offset_x);
+        Wide other_bottom = widen (other.position_y) - widen (other.anchor_offset_y);
+        Wide other_right  = other_left   + widen (other.width );
+        Wide other_top    = other_bottom + widen (other.height);
 
         // Se determina si los rectángulos envolventes de ambos gameobjects se solapan:
 
         return !(other_left >= this_right || other_right <= this_left || other_bottom >= this_top || other_top <= this_bottom);
     }
 
-    bool GameObject::contains (const Point2f & point)
+    template< typename SCALAR >
+    bool Basic_GameObject< SCALAR >::contains (const Point2f & point) const
     {
-        float this_left = this->get_left_x ();
+        // Cada coordenada del punto se convierte justo antes de usarla para que la primera
+        // comparación no tenga que esperar a las dos conversiones:
 
-        if (point.coordinates.x () > this_left)
+        Wide point_x   = widen (Scalar(point.coordinates.x ()));
+        Wide this_left = widen (this->position_x) - widen (this->anchor_offset_x);
+
+        if (point_x > this_left)
         {
-            float this_bottom = this->get_bottom_y ();
+            Wide point_y     = widen (Scalar(point.coordinates.y ()));
+            Wide this_bottom = widen (this->position_y) - widen (this->anchor_offset_y);
 
-            if (point.coordinates.y () > this_bottom)
+            if (point_y > this_bottom)
             {
-                float this_right = this_left + this->size.width;
+                Wide this_right = this_left + widen (this->width);
 
-                if (point.coordinates.x () < this_right)
+                if (point_x < this_right)
                 {
-                    float this_top = this_bottom + this->size.height;
+                    Wide this_top = this_bottom + widen (this->height);
 
-                    if (point.coordinates.y () < this_top)
+                    if (point_y < this_top)
                     {
                         return true;
                     }
@@ -78,4 +103,9 @@ namespace jesus_villar_examen
         return false;
     }
 
+    // Se instancian aquí las dos variantes para que la implementación no tenga que estar en la cabecera:
+
+    template class Basic_GameObject< float >;
+    template class Basic_GameObject< Fixed >;
+
 }
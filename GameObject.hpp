@@ -17,6 +17,8 @@
     #include <basics/Texture_2D>
     #include <basics/Vector>
 
+    #include "Fixed.hpp"
+
     namespace jesus_villar_examen
     {
 
@@ -26,18 +28,39 @@
         using basics::Vector2f;
         using basics::Texture_2D;
 
-        class GameObject
+        /**
+         * Game object cuyo estado cinemático (posición, tamaño y velocidad) y cuyas pruebas de
+         * colisión se calculan con el tipo SCALAR. Con float se comporta como siempre; con Fixed
+         * la integración y las pruebas de colisión dan los mismos resultados en cualquier plataforma
+         * a partir de los mismos valores de entrada. Hacia fuera siempre se trabaja con float: los
+         * valores se convierten al leerlos y al escribirlos (de forma exacta y determinista), así
+         * que quien calcula las velocidades debe hacerlo también con SCALAR para que no varíen
+         * entre plataformas (como la velocidad del barco con Fixed::atan2() y las predicciones de
+         * la IA de los submarinos con multiply_add()).
+         */
+        template< typename SCALAR >
+        class Basic_GameObject
         {
+        public:
+
+            typedef SCALAR Scalar;
+            typedef decltype(widen (Scalar())) Wide;   ///< Tipo en el que se calculan los bordes para las pruebas de colisión.
+
         protected:
 
             Texture_2D * texture;                   ///< Textura en la que está la imagen del sprite.
             int          anchor;                    ///< Indica qué punto de la textura se colocará en 'position' (x,y).
+            Scalar       anchor_offset_x;           ///< Distancia entre el borde izquierdo y 'position' (depende de anchor y del ancho).
+            Scalar       anchor_offset_y;           ///< Distancia entre el borde inferior y 'position' (depende de anchor y del alto).
 
-            Size2f       size;                      ///< Tamaño del game object (normalmente en coordenadas virtuales).
-            Point2f      position;                  ///< Posición del game object (normalmente en coordenadas virtuales).
+            Scalar       width;                     ///< Ancho del game object (normalmente en coordenadas virtuales).
+            Scalar       height;                    ///< Alto  del game object (normalmente en coordenadas virtuales).
+            Scalar       position_x;                ///< Posición del game object (normalmente en coordenadas virtuales).
+            Scalar       position_y;
             float        scale;                     ///< Escala el tamaño del sprite. Por defecto es 1.
 
-            Vector2f     speed;                     ///< Velocidad a la que se mueve el game object.
+            Scalar       speed_x;                   ///< Velocidad a la que se mueve el game object.
+            Scalar       speed_y;
 
             bool         visible;                   ///< Indica si el sprite se debe actualizar y dibujar o no. Por defecto es true.
 
@@ -47,51 +70,57 @@
              * Inicializa una nueva instancia de GameObject.
              * @param texture Puntero a la textura en la que está su imagen. No debe ser nullptr.
              */
-            GameObject(Texture_2D * texture);
+            Basic_GameObject(Texture_2D * texture);
+
+            /**
+             * Inicializa una nueva instancia de GameObject sin textura (por ejemplo, para simular
+             * sin contexto gráfico). No se dibuja con render().
+             * @param size Tamaño del game object.
+             */
+            Basic_GameObject(const Size2f & size);
 
             /**
              * Destructor virtual para facilitar heredar de esta clase si fuese necesario.
              */
-            virtual ~GameObject() = default;
+            virtual ~Basic_GameObject() = default;
 
         public:
 
             // Getters (con nombres autoexplicativos):
 
-            const Size2f   & get_size       () const { return  size;        }
-            const float    & get_width      () const { return  size.width;  }
-            const float    & get_height     () const { return  size.height; }
-            const Point2f  & get_position   () const { return  position;    }
-            const float    & get_position_x () const { return  position[0]; }
-            const float    & get_position_y () const { return  position[1]; }
-            const Vector2f & get_speed      () const { return  speed;       }
-            const float    & get_speed_x    () const { return  speed[0];    }
-            const float    & get_speed_y    () const { return  speed[1];    }
+            Size2f   get_size       () const { return { float(width), float(height) };        }
+            float    get_width      () const { return  float(width);                          }
+            float    get_height     () const { return  float(height);                         }
+            Point2f  get_position   () const { return { float(position_x), float(position_y) }; }
+            float    get_position_x () const { return  float(position_x);                     }
+            float    get_position_y () const { return  float(position_y);                     }
+            Vector2f get_speed      () const { return { float(speed_x), float(speed_y) };     }
+            float    get_speed_x    () const { return  float(speed_x);                        }
+            float    get_speed_y    () const { return  float(speed_y);                        }
+            const Texture_2D * get_texture  () const { return  texture;     }
+            int              get_anchor     () const { return  anchor;      }
+            float            get_scale      () const { return  scale;       }
+
+            // Los bordes se calculan sin saltos usando las distancias precalculadas en set_anchor():
 
             float get_left_x () const
             {
-                return
-                    (anchor & 0x3) == basics::LEFT  ? position[0] :
-                    (anchor & 0x3) == basics::RIGHT ? position[0] - size[0] :
-                     position[0] - size[0] * .5f;
+                return float(left_edge ());
             }
 
             float get_right_x () const
             {
-                return get_left_x () + size.width;
+                return float(left_edge () + width);
             }
 
             float get_bottom_y () const
             {
-                return
-                    (anchor & 0xC) == basics::BOTTOM ? position[1] :
-                    (anchor & 0xC) == basics::TOP    ? position[1] - size[1] :
-                     position[1] - size[1] * .5f;
+                return float(bottom_edge ());
             }
 
             float get_top_y () const
             {
-                return get_bottom_y () + size.height;
+                return float(bottom_edge () + height);
             }
 
             bool is_visible () const
@@ -111,21 +140,25 @@
             void set_anchor (int new_anchor)
             {
                 anchor = new_anchor;
+
+                anchor_offset_x = width  * Scalar((anchor & 0x3) == basics::LEFT   ? 0.f : (anchor & 0x3) == basics::RIGHT ? 1.f : .5f);
+                anchor_offset_y = height * Scalar((anchor & 0xC) == basics::BOTTOM ? 0.f : (anchor & 0xC) == basics::TOP   ? 1.f : .5f);
             }
 
             void set_position (const Point2f & new_position)
             {
-                position = new_position;
+                position_x = Scalar(new_position[0]);
+                position_y = Scalar(new_position[1]);
             }
 
             void set_position_x (const float & new_position_x)
             {
-                position.coordinates.x () = new_position_x;
+                position_x = Scalar(new_position_x);
             }
 
             void set_position_y (const float & new_position_y)
             {
-                position.coordinates.y () = new_position_y;
+                position_y = Scalar(new_position_y);
             }
 
             void set_scale (float new_scale)
@@ -135,17 +168,18 @@
 
             void set_speed (const Vector2f & new_speed)
             {
-                speed = new_speed;
+                speed_x = Scalar(new_speed[0]);
+                speed_y = Scalar(new_speed[1]);
             }
 
             void set_speed_x (const float & new_speed_x)
             {
-                speed.coordinates.x () = new_speed_x;
+                speed_x = Scalar(new_speed_x);
             }
 
             void set_speed_y (const float & new_speed_y)
             {
-                speed.coordinates.y () = new_speed_y;
+                speed_y = Scalar(new_speed_y);
             }
 
         public:
@@ -173,14 +207,14 @@
              * @param other Referencia al otro gameobject.
              * @return true si las áreas se solapan o false en caso contrario.
              */
-            bool intersects (const GameObject & other);
+            bool intersects (const Basic_GameObject & other) const;
 
             /**
              * Comprueba si un punto está dentro del gameobject.
              * @param point Referencia al punto que se comprobará.
              * @return true si el punto está dentro o false si está fuera.
              */
-            bool contains (const Point2f & point);
+            bool contains (const Point2f & point) const;
 
         public:
 
@@ -193,10 +227,10 @@
             {
                 if (visible)
                 {
-                    Vector2f displacement = speed * time;
+                    Scalar step (time);
 
-                    position.coordinates.x () += displacement.coordinates.x ();
-                    position.coordinates.y () += displacement.coordinates.y ();
+                    position_x = multiply_add (position_x, speed_x, step);
+                    position_y = multiply_add (position_y, speed_y, step);
                 }
             }
 
@@ -206,14 +240,40 @@
              */
             virtual void render (Canvas & canvas)
             {
-                if (visible)
+                if (visible && texture)
                 {
-                    canvas.fill_rectangle (position, size * scale, texture, anchor);
+                    canvas.fill_rectangle (get_position (), get_size () * scale, texture, anchor);
                 }
             }
 
+        protected:
+
+            Scalar left_edge () const
+            {
+                return position_x - anchor_offset_x;
+            }
+
+            Scalar bottom_edge () const
+            {
+                return position_y - anchor_offset_y;
+            }
+
         };
 
+        /**
+         * Tipo de game object que usa el juego. Definiendo SINKTHEMALL_FIXED_POINT al compilar la
+         * cinemática y las colisiones se calculan en coma fija (ver Basic_GameObject). Según
+         * Benchmark_Suite (gameobject_fixed_*), intersects() cuesta lo mismo o menos que con float;
+         * update() y contains() siguen costando entre 1 y 2.5 ns más por objeto en x86-64 (una
+         * saturación por eje y la conversión del punto), menos de 0.3 ms por fotograma con 100000
+         * entidades.
+         */
+        #if defined(SINKTHEMALL_FIXED_POINT)
+            typedef Basic_GameObject< Fixed > GameObject;
+        #else
+            typedef Basic_GameObject< float > GameObject;
+        #endif
+
     }
 
 #endif
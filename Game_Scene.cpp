@@ -20,8 +20,11 @@
  */
 
 #include "Game_Scene.hpp"
+#include "Texture_Cooker.hpp"
 
-#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
 #include <basics/Accelerometer>
 #include <basics/Canvas>
 #include <basics/Director>
@@ -31,39 +34,57 @@ using namespace std;
 
 namespace jesus_villar_examen
 {
-     constexpr float     Game_Scene::bullet_speed              ;     ///< Velocidad a la que se mueve el proyectil (en unideades virtuales por segundo).
-     constexpr float     Game_Scene::ship_speed                ;     ///< Velocidad a la que se mueve el barco (en unideades virtuales por segundo).
-     constexpr float     Game_Scene::submarine_speed           ;     ///< Velocidad a la que se mueven los submarinos (en unidades virtuales por segundo)
-     constexpr unsigned  Game_Scene::number_of_player_bullets  ;        ///< Número de balas
-     constexpr unsigned  Game_Scene::number_of_enemy_bullets   ;        ///< Número de balas
-     constexpr unsigned  Game_Scene::number_of_submarines      ;        ///< Número de submarinos
+     constexpr unsigned  Game_Scene::max_explosion_particles   ;        ///< Capacidad del pool de partículas de las explosiones
+     constexpr unsigned  Game_Scene::max_splash_particles      ;        ///< Capacidad del pool de partículas de las salpicaduras
+     constexpr unsigned  Game_Scene::max_wake_particles        ;        ///< Capacidad del pool de partículas de la estela del barco
+     constexpr unsigned  Game_Scene::max_scheduled_events      ;        ///< Número máximo de eventos programados a la vez
+     constexpr float     Game_Scene::ai_budget_microseconds    ;        ///< Tiempo por fotograma con el que se compara el de la IA de los submarinos
+     constexpr float     Game_Scene::ai_think_interval         ;        ///< Segundos entre decisiones de cada submarino
+     constexpr float     Game_Scene::preload_budget            ;        ///< Segundos por fotograma dedicados a precargar recursos de otras escenas
+     constexpr float     Game_Scene::submarine_animation_fps   ;        ///< Fotogramas por segundo de la animación de los submarinos
+     constexpr float     Game_Scene::min_spatial_cell_size     ;        ///< Lado mínimo de las celdas del índice espacial
+     constexpr float     Game_Scene::max_spatial_cell_size     ;        ///< Lado máximo de las celdas del índice espacial
+     constexpr float     Game_Scene::entities_per_cell         ;        ///< Entidades que se busca que haya en cada celda del índice espacial
+     constexpr float     Game_Scene::hud_margin                ;        ///< Separación entre el panel de rendimiento y la esquina superior izquierda
 
 
     // ---------------------------------------------------------------------------------------------
-    // ID y ruta de las texturas que se deben cargar para esta escena.
+    // ID y ruta de las texturas que se deben cargar para esta escena (ver Game_Scene.hpp).
 
-    Game_Scene::Texture_Data Game_Scene::textures_data[] =
-    {
-        { ID(ship),      "game-scene/boat.png"},
-        { ID(submarine),  "game-scene/submarine.png"},
-        { ID(bullet),  "game-scene/bullet.png"},
-        { ID(water),  "game-scene/water.png"},
-
-        //...
+    constexpr decltype(Game_Scene::textures_data) Game_Scene::textures_data;
+    constexpr unsigned Game_Scene::textures_count;
 
-    };
+    // ---------------------------------------------------------------------------------------------
+    // Parámetros de los sistemas de partículas (color, tamaño, velocidad mínima y máxima, apertura,
+    // gravedad, rozamiento y vida).
 
-    // Para determinar el número de items en el array textures_data, se divide el tamaño en bytes
-    // del array completo entre el tamaño en bytes de un item:
+    static const Particle_System::Settings explosion_settings { 1.f,  .55f, .1f,  { 14.f, 14.f }, 60.f, 320.f, 6.2832f,    0.f, 1.5f, .8f };
+    static const Particle_System::Settings splash_settings    { .8f,  .9f,  1.f,  { 10.f, 10.f }, 150.f, 380.f, 1.2f,  -600.f, .5f,  .9f };
+    static const Particle_System::Settings wake_settings      { .95f, .97f, 1.f,  {  8.f,  8.f }, 10.f,  60.f,  .8f,     0.f, 2.f, 1.2f };
 
-    unsigned Game_Scene::textures_count = sizeof(textures_data) / sizeof(Texture_Data);
+    // ---------------------------------------------------------------------------------------------
+    // Resolución dinámica del Software_Canvas (escala mínima y máxima, milisegundos objetivo para
+    // rasterizar un fotograma, margen para subir, paso y fotogramas para bajar y para subir).
 
+    static const Dynamic_Resolution::Settings resolution_settings { .5f, 1.f, 8.f, .25f, .05f, 10, 60 };
 
 
 
     // ---------------------------------------------------------------------------------------------
 
-    Game_Scene::Game_Scene()
+    Game_Scene::Game_Scene(Render_Backend render_backend, const Scenario & scenario)
+    :
+        collisions (scenario.contact_capacity ()),
+        explosions (explosion_settings, render_backend == HEADLESS ? 0 : max_explosion_particles),
+        splashes   (splash_settings,    render_backend == HEADLESS ? 0 : max_splash_particles   ),
+        wake       (wake_settings,      render_backend == HEADLESS ? 0 : max_wake_particles     ),
+        timers     (max_scheduled_events),
+        enemy_ai   (scenario.ai_agents_per_step, ai_budget_microseconds, ai_think_interval),
+        render_backend      (render_backend),
+        frame_dump_interval (0),
+        frames_rendered     (0),
+        resolution          (resolution_settings),
+        scenario            (scenario)
     {
         // Se establece la resolución virtual (independiente de la resolución virtual del dispositivo).
         // En este caso no se hace ajuste de aspect ratio, por lo que puede haber distorsión cuando
@@ -74,13 +95,74 @@ namespace jesus_villar_examen
 
         aspect_ratio_adjusted = false;
 
+        textures_loaded        = 0;
+        textures_were_resident = true;
+
+        front_output          = 0;
+        step_in_flight        = false;
+        step_latency_recorded = false;
+        late_latching         = true;
+        hud_visible           = false;
+        update_milliseconds   = 0.f;
+        pending_input         = Input_Frame {};
+        input_latency         = Latency_Metrics {};
+        statistics            = Statistics  {};
+
+        this->scenario.validate ();
+
+        next_player_bullet = 0;
+        next_enemy_bullet  = 0;
+
+        // Pares de categorías que pueden chocar. Los demás nunca se comprueban:
+
+        collisions.enable (CATEGORY_PLAYER_BULLET, CATEGORY_SUBMARINE);
+        collisions.enable (CATEGORY_ENEMY_BULLET,  CATEGORY_SHIP     );
+
+        for (auto & output : outputs)
+        {
+            output.snapshot.clear ();
+            output.ai_metrics       = enemy_ai.get_metrics ();
+            output.ship_command     = Render_Snapshot::no_command;
+            output.playing          = false;
+            output.input            = Input_Frame {};
+            output.latency_recorded = true;
+            output.performance      = Performance_Hud::Frame_Sample {};
+        }
+
+        // Se inicia la semilla del generador de números aleatorios. Sin semilla en el escenario se
+        // mezcla la hora con un contador de escenas para que dos escenas creadas a la vez (por
+        // ejemplo, en un Batch_Runner) no repitan la partida:
+
+        static std::atomic< uint64_t > scenes_created (0);
+
+        uint64_t seed = this->scenario.random_seed;
 
-        // Se inicia la semilla del generador de números aleatorios:
-        srand (unsigned(time(nullptr)));
+        if (seed == 0)
+        {
+            seed  = uint64_t(chrono::system_clock::now ().time_since_epoch ().count ());
+            seed ^= (scenes_created++ + 1) * 0x9E3779B97F4A7C15ull;
+        }
+
+        random.set_seed (seed);
+
+        simulation_frame = 0;
+        spawn_random     = Random_Stream(random, RANDOM_SPAWN, simulation_frame);
 
         // Se inicializan otros atributos:
 
         initialize ();
+
+        // Solo el Canvas de la GPU carga texturas. En las demás escenas los gameobjects se crean
+        // con su tamaño nominal y se empieza a simular directamente:
+
+        if (render_backend != GPU_CANVAS)
+        {
+            create_gameobjects ();
+            restart_game       ();
+
+            state     = RUNNING;
+            suspended = false;
+        }
     }
 
     // ---------------------------------------------------------------------------------------------
@@ -103,6 +185,8 @@ namespace jesus_villar_examen
 
     void Game_Scene::suspend ()
     {
+        if (simulation_thread) simulation_thread->wait ();  // No se puede pausar a mitad de un paso de simulación
+
         suspended = true;               // Se marca que la escena ha pasado a primer plano
 
         Accelerometer * accelerometer = Accelerometer::get_instance ();
@@ -123,21 +207,20 @@ namespace jesus_villar_examen
 
     // ---------------------------------------------------------------------------------------------
 
+    // La simulación puede estar ejecutándose en el otro hilo, por lo que aquí los eventos solo se
+    // anotan. Se aplican al comienzo del siguiente paso de simulación (ver apply_input()).
+
     void Game_Scene::handle (Event & event)
     {
         if (state == RUNNING)               // Se descartan los eventos cuando la escena está LOADING
         {
-            if (gameplay == WAITING_TO_START)
-            {
-                start_playing ();           // Se empieza a jugar cuando el usuario toca la pantalla
-                                            // por primera vez
-            }
-            else switch (event.id)
+            pending_input.events++;
+
+            switch (event.id)
             {
                 case ID(touch-started):     // El usuario toca la pantalla
                 {
-
-                    spawn_bullet();
+                    record_touch ();
 
                     break;
                 }
@@ -158,21 +241,65 @@ namespace jesus_villar_examen
 
     // ---------------------------------------------------------------------------------------------
 
+    void Game_Scene::touch ()
+    {
+        if (state == RUNNING)
+        {
+            pending_input.events++;
+
+            record_touch ();
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::set_submarine_frames (unsigned columns, unsigned rows)
+    {
+        auto clip = animations.add_clip (animations.add_grid_frames (columns, rows), uint16_t(columns * rows), submarine_animation_fps, true);
+
+        for (auto animation : submarine_animations)
+        {
+            animations.play (animation, clip);
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::record_touch ()
+    {
+        if (pending_input.touches++ == 0)
+        {
+            pending_input.first_touch_time = std::chrono::steady_clock::now ();
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
     void Game_Scene::update (float time)
     {
+        auto start = std::chrono::steady_clock::now ();
+
         if (!suspended) switch (state)
         {
             case LOADING: load_textures  ();     break;
-            case RUNNING: run_simulation (time); break;
+            case RUNNING: pipeline_step  (time); break;
             case ERROR:   break;
         }
+
+        update_milliseconds = std::chrono::duration< float, std::milli >(std::chrono::steady_clock::now () - start).count ();
     }
 
     // ---------------------------------------------------------------------------------------------
 
     void Game_Scene::render (Context & context)
     {
-        if (!suspended)
+        auto start = std::chrono::steady_clock::now ();
+
+        if (!suspended && render_backend == SOFTWARE_CANVAS)
+        {
+            render_software ();
+        }
+        else if (!suspended && render_backend == GPU_CANVAS)
         {
             // El canvas se puede haber creado previamente, en cuyo caso solo hay que pedirlo:
 
@@ -197,8 +324,30 @@ namespace jesus_villar_examen
                     case RUNNING: render_playfield (*canvas); break;
                     case ERROR:   break;
                 }
+
+                if (state == RUNNING)
+                {
+                    record_input_latency ();
+
+                    // El panel de rendimiento se dibuja encima de todo y fuera del tiempo medido:
+
+                    if (hud_visible)
+                    {
+                        record_performance_sample (start);
+
+                        performance_hud.draw (*canvas, hud_margin, canvas_height - hud_margin);
+                    }
+                }
             }
         }
+
+        // Una vez en juego, el tiempo que sobra de cada fotograma se aprovecha para ir cargando los
+        // recursos que otras escenas hayan pedido precargar:
+
+        if (!suspended && state == RUNNING && render_backend != HEADLESS && context)
+        {
+            Resource_Cache::get_instance ().preload_step (context, preload_budget);
+        }
     }
 
     // ---------------------------------------------------------------------------------------------
@@ -210,7 +359,7 @@ namespace jesus_villar_examen
 
     void Game_Scene::load_textures ()
     {
-        if (textures.size () < textures_count)          // Si quedan texturas por cargar...
+        if (textures_loaded < textures_count)           // Si quedan texturas por cargar...
         {
             // Las texturas se cargan y se suben al contexto gráfico, por lo que es necesario disponer
             // de uno:
@@ -227,25 +376,29 @@ namespace jesus_villar_examen
                 // Se ajusta el aspect ratio si este no se ha ajustado
 
 
-                // Se carga la siguiente textura (textures.size() indica cuántas llevamos cargadas):
-
-                Texture_Data   & texture_data = textures_data[textures.size ()];
-                Texture_Handle & texture      = textures[texture_data.id] = Texture_2D::create (texture_data.id, context, texture_data.path);
+                // Se toman de la caché compartida las texturas siguientes (textures_loaded indica
+                // cuántas llevamos). Las que ya están residentes no cuestan nada, así que solo se
+                // para después de la primera que haya que cargar de disco. Si alguna no se ha podido
+                // cargar correctamente se pasa al estado ERROR:
 
-                // Se comprueba si la textura se ha podido cargar correctamente:
-
-                if (texture) context->add (texture); else state = ERROR;
+                if (!Resource_Cache::get_instance ().acquire_next (textures_data, textures_loaded, textures, context, textures_were_resident))
+                {
+                    state = ERROR;
+                }
 
                 // Cuando se han terminado de cargar todas las texturas se pueden crear los gameobjects que
                 // las usarán e iniciar el juego:
             }
         }
-        else
-        if (timer.get_elapsed_seconds () > 1.f)         // Si las texturas se han cargado muy rápido
+        else                                            // Si todas estaban ya en la caché se pasa al
+        if (textures_were_resident ||                   // juego sin esperar.
+            timer.get_elapsed_seconds () > 1.f)         // Si las texturas se han cargado muy rápido
         {                                               // se espera un segundo desde el inicio de
             create_gameobjects();                          // la carga antes de pasar al juego para que
             restart_game   ();                          // el mensaje de carga no aparezca y desaparezca
                                                         // demasiado rápido.
+            build_output (outputs[front_output]);       // Primer snapshot que se dibuja
+
             state = RUNNING;
         }
     }
@@ -261,8 +414,8 @@ namespace jesus_villar_examen
         //GameObject_Handle  nombre_objeto(new GameObject (textures[ID(nombre_ID)].get() ));
         //...
 
-        GameObject_Handle barco     (new GameObject (textures[ID(ship)]   .get() ));
-        GameObject_Handle water     (new GameObject (textures[ID(water)]  .get() ));
+        GameObject_Handle barco     = create_gameobject< ID(ship)  > ();
+        GameObject_Handle water     = create_gameobject< ID(water) > ();
 
         //Se establecen los anchor y position de los GameObject
 
@@ -279,7 +432,7 @@ namespace jesus_villar_examen
         //Se añaden a la lista de game objects
         //gameobjects.push_back (nombre_objeto);
 
-        gameobjects.push_back (barco);
+        add_gameobject (barco, ID(ship));
 
         // Se guardan punteros a los gameobjects que se van a usar frecuentemente:
 
@@ -289,40 +442,65 @@ namespace jesus_villar_examen
 
 
         // Se crean los proyectiles del jugador
-        for(unsigned iterator = 0; iterator < number_of_player_bullets; iterator++)
+        for(unsigned iterator = 0; iterator < scenario.player_bullets; iterator++)
         {
-            GameObject_Handle bullet (new GameObject (textures[ID(bullet)]. get() ));
+            GameObject_Handle bullet = create_gameobject< ID(bullet) > ();
 
             bullet -> hide ();
 
             player_bullets.    push_back(bullet);
-            gameobjects.push_back(bullet);
+            add_gameobject (bullet, ID(bullet));
         }
 
         // Se crean los proyectiles del enemigo
-        for(unsigned iterator = 0; iterator < number_of_enemy_bullets; iterator++)
+        for(unsigned iterator = 0; iterator < scenario.enemy_bullets; iterator++)
         {
-            GameObject_Handle bullet (new GameObject (textures[ID(bullet)]. get() ));
+            GameObject_Handle bullet = create_gameobject< ID(bullet) > ();
 
             bullet -> hide ();
 
             enemy_bullets.    push_back(bullet);
-            gameobjects.push_back(bullet);
+            add_gameobject (bullet, ID(bullet));
         }
 
         // Se crean los submarinos
-        for (unsigned iterator = 0; iterator < number_of_submarines; iterator++)
+        for (unsigned iterator = 0; iterator < scenario.submarines; iterator++)
         {
 
-            GameObject_Handle submarine(new GameObject(textures[ID(submarine)].get()));
+            GameObject_Handle submarine = create_gameobject< ID(submarine) > ();
 
             random_submarine_values(*submarine);
 
             submarines.push_back(submarine);
-            gameobjects.push_back(submarine);
+            add_gameobject (submarine, ID(submarine));
+
+        }
+
+        // El pool de scripts de comportamiento se reserva entero para que empezarlos no reserve memoria
+        behaviors.reset (scenario.behavior_scripts ? unsigned(submarines.size ()) : 0u);
+
+        // Puntos de disparo: siguen al barco y a cada submarino desde su borde hacia el otro
+
+        ship_cannon = transforms.attach (nullptr, transforms.attach (player_ship_pointer), { 0.f, -player_ship_pointer -> get_height() * 0.5f });
 
+        // Los submarinos empiezan con un único fotograma (la textura completa, que es lo que dibuja
+        // el Canvas de la GPU). load_texture_images() cambia el clip si su imagen es una rejilla:
+
+        auto submarine_clip = animations.add_clip (animations.add_grid_frames (1, 1), 1, submarine_animation_fps, true);
+
+        for (auto & submarine : submarines)
+        {
+            submarine_animations.push_back (animations.add_animation (submarine_clip));
+            submarine_launchers.push_back (transforms.attach (nullptr, transforms.attach (submarine.get ()), { 0.f, submarine -> get_height() * 0.5f }));
         }
 
+        // El índice espacial cubre la zona visible (lo que se salga cae en las celdas del borde).
+        // Las celdas se achican cuando hay muchas entidades para que cada una tenga unas pocas:
+
+        float cell_size = std::sqrt (float(canvas_width) * canvas_height * entities_per_cell / scenario.entities ());
+
+        spatial_index.reset (float(canvas_width), float(canvas_height), std::min (std::max (cell_size, min_spatial_cell_size), max_spatial_cell_size));
+
     }
 
     // ---------------------------------------------------------------------------------------------
@@ -350,6 +528,48 @@ namespace jesus_villar_examen
 
         }
 
+        explosions.clear ();
+        splashes  .clear ();
+        wake      .clear ();
+
+        // Se descartan los eventos pendientes y se programa el primer disparo enemigo. Con una
+        // línea de tiempo los disparos y las apariciones los marca ella, así que se vuelve a su
+        // comienzo y los submarinos esperan ocultos a su primer SPAWN:
+
+        timers.clear ();
+
+        if (wave_timeline)
+        {
+            waves.rewind ();
+
+            for (auto & submarine : submarines) recycle_submarine (*submarine);
+        }
+        else
+        {
+            timers.schedule (scenario.enemy_fire_interval, ID(enemy_fire));
+        }
+
+        if (scenario.auto_fire_interval > 0.f)
+        {
+            timers.schedule (scenario.auto_fire_interval, ID(auto_fire));
+        }
+
+        next_player_bullet = 0;
+        next_enemy_bullet  = 0;
+
+        enemy_ai.reset (unsigned(submarines.size ()));
+
+        // Los scripts de comportamiento vuelven a empezar desde el principio
+
+        behaviors.clear ();
+
+        for (unsigned submarine = 0; submarine < behaviors.get_capacity (); ++submarine)
+        {
+            behaviors.start (submarine_patrol, submarine);
+        }
+
+        transforms.update ();
+
         gameplay = WAITING_TO_START;
     }
 
@@ -364,11 +584,153 @@ namespace jesus_villar_examen
 
     // ---------------------------------------------------------------------------------------------
 
-    void Game_Scene::run_simulation (float time)
+    // El paso N+1 se simula en el hilo de simulación mientras el hilo principal dibuja el snapshot
+    // del paso N. Antes de lanzar un paso se espera al anterior, así que nunca hay dos a la vez y
+    // el buffer que se dibuja no se modifica hasta el siguiente update.
+
+    void Game_Scene::pipeline_step (float time)
+    {
+        if (!simulation_thread)
+        {
+            simulation_thread.reset (new Worker_Thread);
+        }
+
+        simulation_thread->wait ();
+
+        if (step_in_flight)
+        {
+            front_output  ^= 1;
+            step_in_flight = false;
+
+            // Si los toques de ese paso ya se mostraron adelantados, su latencia ya está medida:
+
+            outputs[front_output].latency_recorded = step_latency_recorded;
+        }
+
+        // El acelerómetro se lee en el hilo principal y se entrega junto con el resto de la entrada:
+
+        Accelerometer * accelerometer = Accelerometer::get_instance ();
+
+        pending_input.has_acceleration = accelerometer != nullptr;
+
+        if (accelerometer) pending_input.acceleration = accelerometer->get_state ();
+
+        step_input     = pending_input;
+        step_time      = time;
+        pending_input  = Input_Frame {};
+        step_in_flight = true;
+
+        step_latency_recorded = false;
+
+        simulation_thread->run ([this] { simulate_step (); });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::step (float time, const Input_Frame & input)
+    {
+        if (state == RUNNING)
+        {
+            apply_input    (input);
+            run_simulation (time );
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::set_wave_timeline (std::shared_ptr< const Wave_Timeline > timeline)
+    {
+        if (simulation_thread) simulation_thread->wait ();  // El paso en curso puede estar leyendo la anterior
+
+        wave_timeline = std::move (timeline);
+        waves         = wave_timeline ? Wave_Timeline::Cursor(*wave_timeline) : Wave_Timeline::Cursor();
+
+        if (state == RUNNING) restart_game ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::simulate_step ()
+    {
+        auto start = std::chrono::steady_clock::now ();
+
+        apply_input    (step_input);
+        run_simulation (step_time );
+
+        Simulation_Output & output = outputs[front_output ^ 1];
+
+        build_output (output);
+
+        output.input = step_input;
+
+        output.snapshot.simulation_microseconds = std::chrono::duration< float, std::micro >(std::chrono::steady_clock::now () - start).count ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::apply_input (const Input_Frame & input)
     {
+        if (gameplay == WAITING_TO_START)
+        {
+            if (input.events > 0)
+            {
+                start_playing ();           // Se empieza a jugar cuando el usuario toca la pantalla
+                                            // por primera vez
+            }
+        }
+        else for (unsigned touch = 0; touch < input.touches; ++touch)
+        {
+            spawn_bullet();
+        }
 
         // Calculamos la velocidad del barco en función del acelerómetro
-        ship_movement();
+        ship_movement(input);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::run_simulation (float time)
+    {
+        // Cada paso usa sus propios números aleatorios, que solo dependen de la semilla y del número
+        // de paso:
+
+        simulation_frame++;
+
+        spawn_random    = Random_Stream(random, RANDOM_SPAWN,    simulation_frame);
+        behavior_random = Random_Stream(random, RANDOM_BEHAVIOR, simulation_frame);
+
+        explosions.set_random (Random_Stream(random, RANDOM_EXPLOSIONS, simulation_frame));
+        splashes  .set_random (Random_Stream(random, RANDOM_SPLASHES,   simulation_frame));
+        wake      .set_random (Random_Stream(random, RANDOM_WAKE,       simulation_frame));
+
+        // Se notifican los eventos programados que vencen en este paso
+        timers.advance (time, [this] (Id event, uint32_t data) { handle_scheduled_event (event, data); });
+
+        // Y los de la línea de tiempo del nivel, si la hay, que vuelve a empezar al terminar
+        if (wave_timeline)
+        {
+            waves.advance (time, [this] (const Wave_Timeline::Event & event) { handle_wave_event (event); });
+
+            if (waves.is_finished ()) waves.rewind ();
+        }
+
+        // Se reanudan los scripts de comportamiento que han terminado de esperar
+        if (behaviors.get_count () > 0)
+        {
+            behaviors.update (time, *this);
+
+            const auto & metrics = behaviors.get_metrics ();
+
+            statistics.script_updates += metrics.scripts;
+            statistics.script_resumes += metrics.resumed;
+            statistics.script_seconds += metrics.microseconds * 1e-6;
+        }
+
+        if (gameplay == PLAYING)
+        {
+            statistics.survival_time     += time;
+            statistics.best_survival_time = std::max (statistics.best_survival_time, statistics.survival_time);
+        }
 
         // Evitamos que el barco salga de los límites
         fix_ship_position();
@@ -379,50 +741,34 @@ namespace jesus_villar_examen
             gameobject->update (time);
         }
 
-        // Comprobamos si las balas del jugador se salen de rango
-        // o si chocan con un submarino
+        // Se reconstruye el índice espacial con las posiciones de este paso
+        build_spatial_index ();
+
+        // Se buscan los contactos entre los pares de categorías habilitados y después se procesan
+        // todos a la vez, de modo que las respuestas no afectan a la detección
+        collisions.detect (spatial_index);
+
+        statistics.overflowed_contacts += collisions.get_overflowed_contacts ();
 
+        handle_collisions ();
+
+        // Comprobamos si las balas del jugador se salen de rango
         for (auto & gameobject : player_bullets)
         {
-            if(gameobject -> is_visible())
+            if(gameobject -> is_visible() && gameobject -> get_top_y() <= 0)
             {
-                if(gameobject -> get_top_y() <= 0)
-                {
-                    gameobject -> hide();
-                    gameobject -> set_speed_y(0);
-                }
-
-                for (auto & submarine : submarines)
-                {
-                    if (gameobject -> intersects(*submarine))
-                    {
-                        gameobject -> hide();
-                        gameobject -> set_speed_y(0);
-
-                        random_submarine_values(*submarine);
-                    }
-                }
+                gameobject -> hide();
+                gameobject -> set_speed_y(0);
             }
         }
 
-        // Comprobamos si las balas del enemigo se salen de rango
-        // o si chocan con el jugador
+        // Comprobamos si las balas del enemigo llegan a la superficie
         for (auto & gameobject : enemy_bullets)
         {
-            if (gameobject -> is_visible())
+            if (gameobject -> is_visible() && gameobject -> get_top_y() >= canvas_height * 0.5f)
             {
-                if(gameobject -> get_top_y() >= canvas_height * 0.5f)
-                {
-                    gameobject -> hide();
-                    gameobject -> set_speed_y(0);
-
-                    if(gameobject -> intersects(*player_ship_pointer))
-                    {
-                        player_ship_pointer -> set_speed_y(-300);
-
-                    }
-                }
-
+                gameobject -> hide();
+                gameobject -> set_speed_y(0);
             }
         }
 
@@ -430,23 +776,41 @@ namespace jesus_villar_examen
         // Comprobamos si los submarinos salen de la pantalla
         for (auto & submarine : submarines)
         {
-            if(submarine -> get_speed_x() > 0 && submarine -> get_left_x() >= canvas_width){
-                random_submarine_values( *submarine);
+            if((submarine -> get_speed_x() > 0 && submarine -> get_left_x() >= canvas_width) ||
+               (submarine -> get_speed_x() < 0 && submarine -> get_right_x() <= 0)){
+                recycle_submarine( *submarine);
             }
 
-        }
+            // Evitamos que las maniobras de la IA los saquen del agua o del fondo
+            if(submarine -> get_bottom_y() < 0)
+            {
+                submarine -> set_position_y(submarine -> get_height() * 0.5f);
+                submarine -> set_speed_y(0);
+            }
+            else if(submarine -> get_top_y() > canvas_height * 0.5f)
+            {
+                submarine -> set_position_y(canvas_height * 0.5f - submarine -> get_height() * 0.5f);
+                submarine -> set_speed_y(0);
+            }
 
-        // Dispara el enemigo
-        if(timer.get_elapsed_seconds () > 2.f)
-        {
-            spawn_enemy_bullet();
-            timer.reset();
         }
 
+        // Se actualizan los efectos de partículas
+        update_particles (time);
+
+        // Se actualiza la IA de los submarinos sin pasar de su presupuesto de tiempo
+        enemy_ai.update (time, { player_ship_pointer, &player_bullets, scenario.bullet_speed, 0.f, &spatial_index, CATEGORY_PLAYER_BULLET }, submarines);
 
-        //TODO: implementación de la IA
+        // Las partes de las entidades compuestas siguen a sus padres
+        transforms.update ();
 
-        //TODO: implementación de posibles colisiones
+        // Se avanzan todas las animaciones de sprites a la vez
+        auto animations_start = std::chrono::steady_clock::now ();
+
+        animations.update (time, [] (Sprite_Animator::Animation, Id) { });
+
+        statistics.animation_updates += animations.size ();
+        statistics.animation_seconds += std::chrono::duration< double >(std::chrono::steady_clock::now () - animations_start).count ();
     }
 
 
@@ -455,7 +819,7 @@ namespace jesus_villar_examen
     void Game_Scene::render_loading (Canvas & canvas)
     {
         //TODO: tiene que haber alguna textura con ID loading para la carga
-        /*Texture_2D * loading_texture = textures[ID(loading)].get ();
+        /*Texture_2D * loading_texture = get_texture< ID(loading) > ();
 
         if (loading_texture)
         {
@@ -469,64 +833,470 @@ namespace jesus_villar_examen
     }
 
     // ---------------------------------------------------------------------------------------------
-    // Simplemente se dibujan todos los gameobjects que conforman la escena.
 
-    void Game_Scene::render_playfield (Canvas & canvas)
+    void Game_Scene::handle_scheduled_event (Id event, uint32_t)
     {
-        for (auto & gameobject : gameobjects)
+        switch (event)
         {
-            gameobject->render (canvas);
-        }
-    }
+            case ID(enemy_fire):            // Dispara el enemigo y se programa el siguiente disparo
+            {
+                spawn_enemy_bullet(scenario.enemy_volley);
 
-    // ---------------------------------------------------------------------------------------------
-    // Ajusta el aspect ratio
+                timers.schedule (scenario.enemy_fire_interval, ID(enemy_fire));
 
-    void Game_Scene::adjust_aspect_ratio(Context & context)
-    {
+                break;
+            }
 
+            case ID(auto_fire):             // Disparo automático del barco (escenarios de estrés)
+            {
+                // Las balas de una ráfaga se reparten a lo ancho del agua: si salieran todas del
+                // cañón volarían apiladas y cada una chocaría con todo lo que choca la ráfaga
 
+                if (gameplay == PLAYING)
+                {
+                    unsigned volley   = scenario.auto_fire_volley;
+                    float    cannon_x = transforms.get_world_position (ship_cannon)[0];
 
-        float real_aspect_ratio = float( context->get_surface_width () ) / context->get_surface_height ();
+                    for (unsigned bullet = 0; bullet < volley; ++bullet)
+                    {
+                        float offset_x = volley > 1 ? canvas_width * (bullet + .5f) / volley - cannon_x : 0.f;
 
-        canvas_width = unsigned ( canvas_height * real_aspect_ratio);
+                        if (!spawn_bullet (offset_x)) break;
+                    }
+                }
 
-        aspect_ratio_adjusted = true;
+                timers.schedule (scenario.auto_fire_interval, ID(auto_fire));
+
+                break;
+            }
+        }
     }
 
     // ---------------------------------------------------------------------------------------------
-    // Ajusta la velocidad del barco
 
-    void Game_Scene::ship_movement() {
+    // Los contactos llegan con el objeto de la categoría de bit más bajo en 'first'. El índice solo
+    // guarda punteros const, pero los gameobjects son de la escena.
 
-        Accelerometer * accelerometer = Accelerometer::get_instance ();
-
-        if (accelerometer) {
-            const Accelerometer::State &acceleration = accelerometer->get_state();
-
-            float pitch = atan2f(-acceleration.x, sqrtf(acceleration.y * acceleration.y +
-                                                        acceleration.z * acceleration.z)) * ship_speed;
+    void Game_Scene::handle_collisions ()
+    {
+        collisions.dispatch ([this] (const Collision_System::Contact & contact)
+        {
+            GameObject & first  = const_cast< GameObject & >(*contact.first );
+            GameObject & second = const_cast< GameObject & >(*contact.second);
 
-            player_ship_pointer->set_speed_x(pitch);
-        }
+            switch (contact.first_layer | contact.second_layer)
+            {
+                case CATEGORY_PLAYER_BULLET | CATEGORY_SUBMARINE: check_bullet_hit (first,  second); break;
+                case CATEGORY_SHIP | CATEGORY_ENEMY_BULLET:       check_ship_hit   (second, first ); break;
+            }
+        });
     }
 
     // ---------------------------------------------------------------------------------------------
-    // Ajusta la posición del barco
+    // Se confirma con intersects() porque la bala puede haber alcanzado ya otro submarino o el
+    // submarino haber sido alcanzado (y recolocado) por otra bala en este mismo paso.
 
-    void Game_Scene::fix_ship_position(){
+    void Game_Scene::check_bullet_hit (GameObject & bullet, GameObject & submarine)
+    {
+        statistics.collision_pairs++;
 
-        if( player_ship_pointer -> get_right_x() >= canvas_width)
+        if (bullet.is_visible () && bullet.intersects(submarine))
         {
-            player_ship_pointer -> set_position_x(canvas_width - player_ship_pointer -> get_width() * 0.5f);
+            bullet.hide();
+            bullet.set_speed_y(0);
+
+            explosions.emit (submarine.get_position(), 96, 0.f);
 
+            statistics.hits++;
+
+            recycle_submarine(submarine);
         }
-        else if( player_ship_pointer -> get_left_x() <= 0)
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::check_ship_hit (GameObject & bullet, GameObject & ship)
+    {
+        statistics.collision_pairs++;
+
+        if (bullet.is_visible () && bullet.intersects(ship))
+        {
+            bullet.hide();
+            bullet.set_speed_y(0);
+
+            ship.set_speed_y(-300);
+
+            splashes.emit (bullet.get_position(), 64, 1.5708f);
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::build_spatial_index ()
+    {
+        spatial_index.clear ();
+
+        spatial_index.insert (*player_ship_pointer, CATEGORY_SHIP);
+
+        for (auto & bullet    : player_bullets) spatial_index.insert (*bullet,    CATEGORY_PLAYER_BULLET);
+        for (auto & bullet    : enemy_bullets ) spatial_index.insert (*bullet,    CATEGORY_ENEMY_BULLET );
+        for (auto & submarine : submarines    ) spatial_index.insert (*submarine, CATEGORY_SUBMARINE    );
+
+        spatial_index.build ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // La estela se emite en proporción a la velocidad del barco, en sentido contrario a su avance y
+    // a la altura de su línea de flotación.
+
+    void Game_Scene::update_particles (float time)
+    {
+        float ship_speed_x = player_ship_pointer -> get_speed_x();
+
+        if (ship_speed_x != 0.f)
+        {
+            unsigned amount = unsigned(fabsf(ship_speed_x) * time * .25f) + 1;
+            float    stern  = ship_speed_x > 0 ? player_ship_pointer -> get_left_x() : player_ship_pointer -> get_right_x();
+
+            wake.emit ({ stern, player_ship_pointer -> get_bottom_y() }, amount, ship_speed_x > 0 ? 3.1416f : 0.f);
+        }
+
+        explosions.update (time);
+        splashes  .update (time);
+        wake      .update (time);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Se generan los comandos de todos los gameobjects que conforman la escena y después los de las
+    // partículas, ya ordenados por capa.
+
+    void Game_Scene::build_output (Simulation_Output & output)
+    {
+        output.snapshot.clear ();
+
+        output.ship_command = Render_Snapshot::no_command;
+        output.playing      = gameplay == PLAYING;
+
+        // Los submarinos aparecen en gameobjects en el mismo orden que en submarines, así que su
+        // animación se localiza avanzando un índice a la par:
+
+        size_t submarine = 0;
+
+        for (size_t index = 0; index < gameobjects.size (); ++index)
+        {
+            const GameObject_Handle & gameobject = gameobjects[index];
+
+            if (gameobject.get () == player_ship_pointer && gameobject->is_visible ())
+            {
+                output.ship_command = output.snapshot.commands.size ();
+            }
+
+            if (submarine < submarines.size () && gameobject == submarines[submarine])
+            {
+                output.snapshot.add (*gameobject, gameobject_textures[index], LAYER_WORLD, animations.get_uv (submarine_animations[submarine++]));
+            }
+            else
+            {
+                output.snapshot.add (*gameobject, gameobject_textures[index], LAYER_WORLD);
+            }
+        }
+
+        Performance_Hud::Frame_Sample & performance = output.performance;
+
+        performance = Performance_Hud::Frame_Sample {};
+
+        performance.entities               = unsigned(output.snapshot.commands.size ());
+        performance.player_bullet_capacity = unsigned(player_bullets.size ());
+        performance.enemy_bullet_capacity  = unsigned(enemy_bullets .size ());
+        performance.particles              = explosions.get_count    () + splashes.get_count    () + wake.get_count    ();
+        performance.particle_capacity      = explosions.get_capacity () + splashes.get_capacity () + wake.get_capacity ();
+        performance.timers                 = timers.get_active_count ();
+        performance.timer_capacity         = timers.get_capacity     ();
+
+        for (auto & bullet : player_bullets) if (bullet->is_visible ()) performance.player_bullets++;
+        for (auto & bullet : enemy_bullets ) if (bullet->is_visible ()) performance.enemy_bullets++;
+
+        wake      .snapshot (output.snapshot, LAYER_WAKE      );
+        explosions.snapshot (output.snapshot, LAYER_EXPLOSIONS);
+        splashes  .snapshot (output.snapshot, LAYER_SPLASHES  );
+
+        output.ai_metrics = enemy_ai.get_metrics ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Los píxeles se leen de los mismos TGA de los que parte Texture_Cooker al cocinar las texturas.
+
+    bool Game_Scene::load_texture_images (const std::string & root)
+    {
+        if (!software_canvas)
+        {
+            software_canvas.reset (new Software_Canvas(canvas_width, canvas_height));
+        }
+
+        bool complete = true;
+
+        for (unsigned index = 0; index < textures_count; ++index)
+        {
+            const Asset_Data     & texture_data = textures_data[index];
+            Software_Canvas::Image image;
+
+            if (Texture_Cooker::load_tga (root + "/" + Texture_Cooker::replace_extension (texture_data.path, ".tga"), image))
+            {
+                if (texture_data.id == ID(submarine))
+                {
+                    unsigned columns = std::max (unsigned(image.width  / texture_data.width  + .5f), 1u);
+                    unsigned rows    = std::max (unsigned(image.height / texture_data.height + .5f), 1u);
+
+                    if (columns * rows > 1) set_submarine_frames (columns, rows);
+                }
+
+                software_canvas->set_texture_image (texture_data.id, std::move (image));
+            }
+            else
+            {
+                complete = false;
+            }
+        }
+
+        return complete;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // El framebuffer se crea al empezar a jugar, cuando ya se conoce la resolución virtual definitiva
+    // (el ancho se ajusta al aspect ratio durante la carga).
+
+    void Game_Scene::render_software ()
+    {
+        if (state != RUNNING) return;
+
+        if (!software_canvas)
+        {
+            software_canvas.reset (new Software_Canvas(canvas_width, canvas_height));
+        }
+
+        // Se rasteriza a la escala que decidió el fotograma anterior y se amplía a la resolución
+        // virtual. Lo que tarda todo ello decide la escala del siguiente:
+
+        auto start = std::chrono::steady_clock::now ();
+
+        size_t skipped_command = latch_input ();
+
+        software_canvas->set_render_scale (resolution.get_scale ());
+        software_canvas->clear   ();
+        software_canvas->render  (outputs[front_output].snapshot, skipped_command);
+        software_canvas->render  (latched_overlay);
+
+        // El panel de rendimiento se dibuja antes de ampliar el framebuffer, por lo que también se
+        // ve a la escala de este fotograma, pero no cuenta para decidir la siguiente:
+
+        float hud_milliseconds = 0.f;
+
+        if (hud_visible)
+        {
+            record_performance_sample (start);
+
+            performance_hud.draw (*software_canvas, hud_margin, canvas_height - hud_margin);
+
+            hud_milliseconds = performance_hud.get_cost_milliseconds ();
+        }
+
+        software_canvas->resolve ();
+
+        resolution.update (std::chrono::duration< float, std::milli >(std::chrono::steady_clock::now () - start).count () - hud_milliseconds);
+
+        record_input_latency ();
+
+        if (frame_dump_interval > 0 && frames_rendered % frame_dump_interval == 0)
+        {
+            software_canvas->save_tga (frame_dump_prefix + to_string (frames_rendered) + ".tga");
+        }
+
+        frames_rendered++;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Se dibuja el último snapshot publicado por la simulación. No se toca el estado de la escena
+    // porque el siguiente paso se puede estar simulando a la vez en el otro hilo.
+
+    void Game_Scene::render_playfield (Canvas & canvas)
+    {
+        size_t skipped_command = latch_input ();
+
+        outputs[front_output].snapshot.render (canvas, skipped_command);
+        latched_overlay              .render (canvas);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Las entidades y los pools los cuenta la simulación al generar el snapshot (build_output());
+    // aquí se añaden los tiempos y las llamadas de dibujado del fotograma. Si el overlay corregido
+    // tiene comandos, sustituye al comando del barco del snapshot.
+
+    void Game_Scene::record_performance_sample (std::chrono::steady_clock::time_point render_start)
+    {
+        const Simulation_Output & output = outputs[front_output];
+
+        Performance_Hud::Frame_Sample sample = output.performance;
+
+        sample.update_milliseconds     = update_milliseconds;
+        sample.simulation_milliseconds = output.snapshot.simulation_microseconds * .001f;
+        sample.render_milliseconds     = std::chrono::duration< float, std::milli >(std::chrono::steady_clock::now () - render_start).count ();
+        sample.draw_calls              = unsigned(output.snapshot.commands.size () + latched_overlay.commands.size ()) - (latched_overlay.commands.empty () ? 0 : 1);
+
+        performance_hud.record (sample);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // El snapshot refleja la entrada de hace un paso. Para reducir la latencia percibida se vuelve
+    // a leer el acelerómetro y se desplaza el barco lo que avanzará en el paso que se está
+    // simulando, y se dibujan ya las balas de los toques que ese paso está procesando. Solo se
+    // leen datos que no cambian durante la simulación (tamaños y la entrada del paso en curso).
+
+    size_t Game_Scene::latch_input ()
+    {
+        latched_overlay.clear ();
+
+        const Simulation_Output & output = outputs[front_output];
+
+        if (!late_latching || !step_in_flight || output.ship_command == Render_Snapshot::no_command)
+        {
+            return Render_Snapshot::no_command;
+        }
+
+        Render_Command ship = output.snapshot.commands[output.ship_command];
+
+        Accelerometer * accelerometer = Accelerometer::get_instance ();
+
+        if (accelerometer)
+        {
+            float half_width = player_ship_pointer -> get_width() * 0.5f;
+
+            ship.x += ship_speed_for (accelerometer->get_state ()) * step_time;
+            ship.x  = std::min (std::max (ship.x, half_width), canvas_width - half_width);
+        }
+
+        latched_overlay.commands.push_back (ship);
+
+        if (output.playing && step_input.touches > 0)
+        {
+            const GameObject & bullet = *player_bullets.front ();
+
+            for (unsigned touch = 0; touch < step_input.touches; ++touch)
+            {
+                latched_overlay.commands.push_back
+                ({
+                    ship.x, ship.y - player_ship_pointer -> get_height() * 0.5f,
+                    bullet.get_width () * bullet.get_scale (), bullet.get_height () * bullet.get_scale (),
+                    bullet.get_texture (),
+                    ID(bullet),
+                    1.f, 1.f, 1.f,
+                    bullet.get_anchor (),
+                    LAYER_WORLD,
+                    UV_Rect::full ()
+                });
+            }
+
+            step_latency_recorded = true;
+        }
+
+        return output.ship_command;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::record_input_latency ()
+    {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now ();
+
+        Simulation_Output & output = outputs[front_output];
+
+        const Input_Frame * shown = nullptr;
+
+        if (step_latency_recorded && step_in_flight && !latched_overlay.commands.empty ())
+        {
+            shown = &step_input;                        // Toques adelantados con late latching
+        }
+        else if (!output.latency_recorded && output.input.touches > 0)
+        {
+            shown = &output.input;                      // Toques que aparecen ya simulados
+        }
+
+        output.latency_recorded = true;
+
+        if (shown && shown->touches > 0)
+        {
+            float milliseconds = std::chrono::duration< float, std::milli >(now - shown->first_touch_time).count ();
+
+            input_latency.samples++;
+            input_latency.last_milliseconds     = milliseconds;
+            input_latency.average_milliseconds += (milliseconds - input_latency.average_milliseconds) / input_latency.samples;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Ajusta el aspect ratio
+
+    void Game_Scene::adjust_aspect_ratio(Context & context)
+    {
+
+
+
+        float real_aspect_ratio = float( context->get_surface_width () ) / context->get_surface_height ();
+
+        canvas_width = unsigned ( canvas_height * real_aspect_ratio);
+
+        aspect_ratio_adjusted = true;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Ajusta la velocidad del barco
+
+    void Game_Scene::ship_movement(const Input_Frame & input) {
+
+        if (input.has_acceleration) {
+            player_ship_pointer->set_speed_x(ship_speed_for(input.acceleration));
+        }
+    }
+
+    float Game_Scene::ship_speed_for(const Accelerometer::State & acceleration) const {
+
+    #if defined(SINKTHEMALL_FIXED_POINT)
+
+        // En coma fija la inclinación se calcula solo con enteros para que la misma entrada dé la
+        // misma velocidad en cualquier plataforma:
+
+        Fixed x (acceleration.x);
+        Fixed y (acceleration.y);
+        Fixed z (acceleration.z);
+
+        return float(Fixed::atan2 (-x, Fixed::sqrt (y * y + z * z)) * Fixed(scenario.ship_speed));
+
+    #else
+
+        return atan2f(-acceleration.x, sqrtf(acceleration.y * acceleration.y +
+                                             acceleration.z * acceleration.z)) * scenario.ship_speed;
+
+    #endif
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Ajusta la posición del barco
+
+    void Game_Scene::fix_ship_position(){
+
+        if( player_ship_pointer -> get_right_x() >= canvas_width)
+        {
+            player_ship_pointer -> set_position_x(canvas_width - player_ship_pointer -> get_width() * 0.5f);
+
+        }
+        else if( player_ship_pointer -> get_left_x() <= 0)
         {
             player_ship_pointer -> set_position_x(player_ship_pointer -> get_width() * 0.5f);
         }
 
         if( player_ship_pointer -> get_top_y() <= 0){
+            statistics.deaths++;
+            statistics.survival_time = 0;
+
             restart_game();
         }
     }
@@ -534,20 +1304,22 @@ namespace jesus_villar_examen
     // ---------------------------------------------------------------------------------------------
     // Spawnea una bala del jugador
 
-    void Game_Scene::spawn_bullet ()
+    bool Game_Scene::spawn_bullet (float offset_x)
     {
-        unsigned iterator;
-        for(iterator = 0; iterator < player_bullets.size() && player_bullets[iterator] -> is_visible(); iterator++)
-        {};
+        size_t iterator = find_free_bullet(player_bullets, next_player_bullet);
 
         if(iterator < player_bullets.size())
         {
+            Point2f cannon = transforms.get_world_position(ship_cannon);
 
-            player_bullets[iterator] -> set_position({player_ship_pointer -> get_position_x(), (player_ship_pointer -> get_position_y()) - (player_ship_pointer -> get_height() * 0.5f)});
-            player_bullets[iterator] -> set_speed({0, -bullet_speed});
+            player_bullets[iterator] -> set_position({ cannon[0] + offset_x, cannon[1] });
+            player_bullets[iterator] -> set_speed({0, -scenario.bullet_speed});
             player_bullets[iterator] -> show();
+
+            return true;
         }
 
+        return false;
     }
 
     // ---------------------------------------------------------------------------------------------
@@ -555,32 +1327,194 @@ namespace jesus_villar_examen
 
     void Game_Scene::random_submarine_values(GameObject & submarine){
 
-        float speed = submarine_speed + (-100 + float((rand () % int (100))));
-        float y  = submarine.get_height()*0.5f + float(rand () % int((canvas_height * 0.5f) - submarine.get_height()));
-        submarine.set_position({-20,y});
+        float speed = scenario.submarine_speed + (-100 + float(spawn_random.next_below (100)));
+        float y  = submarine.get_height()*0.5f + float(spawn_random.next_below (unsigned((canvas_height * 0.5f) - submarine.get_height())));
+
+        place_submarine(submarine, y, speed);
+
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::place_submarine(GameObject & submarine, float y, float speed)
+    {
+        submarine.set_position({speed < 0 ? canvas_width + 20.f : -20.f, y});
         submarine.set_speed_x(speed);
+        submarine.set_speed_y(0);
+        submarine.show();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::recycle_submarine(GameObject & submarine)
+    {
+        if (wave_timeline)
+        {
+            submarine.hide();
+            submarine.set_speed({0, 0});
+        }
+        else
+        {
+            random_submarine_values(submarine);
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Los eventos que nombran un submarino que no existe en este escenario se ignoran, igual que
+    // los disparos de submarinos ocultos.
+
+    void Game_Scene::handle_wave_event(const Wave_Timeline::Event & event)
+    {
+        switch (event.kind)
+        {
+            case Wave_Timeline::SPAWN:
+            {
+                if (event.submarine < submarines.size())
+                {
+                    place_submarine(*submarines[event.submarine], event.y, event.speed);
+                }
 
+                break;
+            }
+
+            case Wave_Timeline::FIRE:
+            {
+                if (event.submarine == Wave_Timeline::any_submarine)
+                {
+                    spawn_enemy_bullet(event.volley);
+                }
+                else if (event.submarine < submarines.size() && submarines[event.submarine] -> is_visible())
+                {
+                    fire_volley(event.submarine, event.volley);
+                }
+
+                break;
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Lo que debe sobrevivir a las esperas se guarda en el frame: 'value' es la velocidad con la
+    // que se ha buceado y 'counter' el disparo de la ráfaga. Un submarino oculto (a la espera de
+    // su SPAWN) sigue el script pero no dispara.
+
+    Behavior_Status Game_Scene::submarine_patrol(Behavior_Frame & frame, Game_Scene & scene)
+    {
+        static constexpr float    dive_speed     = 80.f;
+        static constexpr float    dive_duration  = 1.f;
+        static constexpr float    burst_interval = .2f;
+        static constexpr unsigned burst_shots    = 3;
+
+        GameObject & submarine = *scene.submarines[frame.entity];
+
+        BEHAVIOR_BEGIN(frame);
+
+        for (;;)
+        {
+            BEHAVIOR_WAIT(frame, scene.behavior_random.next_float (1.5f, 4.f));
+
+            frame.value = submarine.get_bottom_y() - dive_speed * dive_duration > 0.f ? -dive_speed : dive_speed;
+
+            submarine.set_speed_y(frame.value);
+
+            BEHAVIOR_WAIT(frame, dive_duration);
+
+            submarine.set_speed_y(0);
+
+            BEHAVIOR_WAIT(frame, scene.behavior_random.next_float (.5f, 1.5f));
+
+            submarine.set_speed_y(-frame.value);
+
+            BEHAVIOR_WAIT(frame, dive_duration);
+
+            submarine.set_speed_y(0);
+
+            for (frame.counter = 0; frame.counter < burst_shots; ++frame.counter)
+            {
+                if (submarine.is_visible()) scene.fire_volley(frame.entity, 1);
+
+                BEHAVIOR_WAIT(frame, burst_interval);
+            }
+        }
+
+        BEHAVIOR_END(frame);
     }
 
     // ---------------------------------------------------------------------------------------------
     // Genera las balas del enemigo
 
-    void Game_Scene::spawn_enemy_bullet()
+    void Game_Scene::spawn_enemy_bullet(unsigned volley)
+    {
+        // Se empieza a buscar en un submarino al azar y se elige el primero visible que la IA
+        // considere alineado con el barco. Si no hay ninguno dispara el primero visible:
+
+        unsigned count    = unsigned(submarines.size());
+        unsigned first    = spawn_random.next_below (count);
+        unsigned position = count;
+
+        for (unsigned offset = 0; offset < count; offset++)
+        {
+            unsigned candidate = (first + offset) % count;
+
+            if (submarines[candidate] -> is_not_visible()) continue;
+
+            if (position == count) position = candidate;
+
+            if (enemy_ai.wants_to_fire(candidate))
+            {
+                position = candidate;
+                break;
+            }
+        }
+
+        if (position < count) fire_volley(position, volley);
+
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Game_Scene::fire_volley(unsigned submarine, unsigned volley)
     {
-        int position = rand () % int (submarines.size());
+        unsigned count = unsigned(submarines.size());
 
-        unsigned iterator;
-        for(iterator = 0; iterator < enemy_bullets.size() && enemy_bullets[iterator] -> is_visible(); iterator++)
-        {};
+        // El resto de la ráfaga sale de los submarinos visibles siguientes (el primero lo es, así
+        // que el recorrido siempre termina):
 
-        if(iterator < enemy_bullets.size())
+        for (unsigned shot = 0; shot < volley; submarine = (submarine + 1) % count)
         {
+            if (submarines[submarine] -> is_not_visible()) continue;
+
+            size_t iterator = find_free_bullet(enemy_bullets, next_enemy_bullet);
+
+            if(iterator == enemy_bullets.size()) break;
 
-            enemy_bullets[iterator] -> set_position({submarines[iterator] -> get_position_x(), (submarines [iterator] -> get_position_y()) + (submarines [iterator] -> get_height() * 0.5f)});
-            enemy_bullets[iterator] -> set_speed({0, bullet_speed});
+            enemy_bullets[iterator] -> set_position(transforms.get_world_position(submarine_launchers[submarine]));
+            enemy_bullets[iterator] -> set_speed({0, scenario.bullet_speed});
             enemy_bullets[iterator] -> show();
+
+            shot++;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    size_t Game_Scene::find_free_bullet(const GameObject_List & bullets, unsigned & cursor)
+    {
+        size_t count = bullets.size();
+
+        for (size_t offset = 0; offset < count; offset++)
+        {
+            size_t iterator = (cursor + offset) % count;
+
+            if (bullets[iterator] -> is_not_visible())
+            {
+                cursor = unsigned((iterator + 1) % count);
+
+                return iterator;
+            }
         }
 
+        return count;
     }
 
 }
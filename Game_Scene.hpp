@@ -22,10 +22,14 @@
 #ifndef GAME_SCENE_HEADER
 #define GAME_SCENE_HEADER
 
-    #include <map>
     #include <list>
+    #include <array>
     #include <memory>
+    #include <string>
+    #include <chrono>
+    #include <type_traits>
 
+    #include <basics/Accelerometer>
     #include <basics/Canvas>
     #include <basics/Id>
     #include <basics/Scene>
@@ -33,6 +37,25 @@
     #include <basics/Timer>
 
     #include "GameObject.hpp"
+    #include "Asset_Manifest.hpp"
+    #include "Particle_System.hpp"
+    #include "Timer_Wheel.hpp"
+    #include "Enemy_AI.hpp"
+    #include "Render_Snapshot.hpp"
+    #include "Worker_Thread.hpp"
+    #include "Software_Canvas.hpp"
+    #include "Resource_Cache.hpp"
+    #include "Transform_Hierarchy.hpp"
+    #include "Sprite_Animator.hpp"
+    #include "Dynamic_Resolution.hpp"
+    #include "Spatial_Index.hpp"
+    #include "Scenario.hpp"
+    #include "Memory_Tracker.hpp"
+    #include "Performance_Hud.hpp"
+    #include "Collision_System.hpp"
+    #include "Counter_Random.hpp"
+    #include "Wave_Timeline.hpp"
+    #include "Behavior_Scheduler.hpp"
 
     namespace jesus_villar_examen
     {
@@ -45,12 +68,82 @@
         class Game_Scene : public basics::Scene
         {
 
+            // Los benchmarks miden spawn_bullet() y el resto de operaciones privadas de la escena:
+
+            friend class Benchmark_Suite;
+
+        public:
+
+            /**
+             * Forma de dibujar la escena. Se elige al crearla.
+             */
+            enum Render_Backend
+            {
+                GPU_CANVAS,                 ///< Canvas del contexto gráfico (OpenGL ES).
+                SOFTWARE_CANVAS,            ///< Software_Canvas en memoria, sin GPU ni Director (ver load_texture_images()).
+                HEADLESS,                   ///< Sin dibujar ni cargar texturas: la simulación se avanza con step().
+            };
+
+            /**
+             * Entrada acumulada en el hilo principal que se entrega a la simulación al comienzo de
+             * cada paso (la simulación puede estar ejecutándose en otro hilo mientras llegan eventos).
+             */
+            struct Input_Frame
+            {
+                unsigned                      events;               ///< Número de eventos recibidos.
+                unsigned                      touches;              ///< Número de toques (touch-started) recibidos.
+                bool                          has_acceleration;     ///< Si se ha podido leer el acelerómetro.
+                basics::Accelerometer::State  acceleration;         ///< Última lectura del acelerómetro.
+                std::chrono::steady_clock::time_point first_touch_time; ///< Momento en que llegó el primero de los toques.
+            };
+
+            /**
+             * Latencia desde que llega un toque hasta que se envía el primer fotograma que lo muestra.
+             */
+            struct Latency_Metrics
+            {
+                float     last_milliseconds;
+                float     average_milliseconds;
+                unsigned  samples;
+            };
+
+            /**
+             * Categorías (bits) con las que se registran los gameobjects en el índice espacial.
+             */
+            enum Entity_Category
+            {
+                CATEGORY_SHIP           = 1 << 0,
+                CATEGORY_PLAYER_BULLET  = 1 << 1,
+                CATEGORY_ENEMY_BULLET   = 1 << 2,
+                CATEGORY_SUBMARINE      = 1 << 3,
+            };
+
+            /**
+             * Resultados acumulados de la partida.
+             */
+            struct Statistics
+            {
+                unsigned  hits;                         ///< Submarinos alcanzados.
+                unsigned  deaths;                       ///< Veces que se ha hundido el barco.
+                float     survival_time;                ///< Segundos jugados desde el último hundimiento.
+                float     best_survival_time;           ///< Mayor survival_time alcanzado.
+                uint64_t  collision_pairs;              ///< Pares de gameobjects comprobados con intersects().
+                uint64_t  overflowed_contacts;          ///< Contactos descartados porque no cabían en el buffer del Collision_System.
+                uint64_t  script_updates;               ///< Suma de los scripts de comportamiento en marcha en cada paso.
+                uint64_t  script_resumes;               ///< Veces que se ha reanudado algún script.
+                double    script_seconds;               ///< Tiempo total gastado en avanzar los scripts.
+                uint64_t  animation_updates;            ///< Suma de las animaciones de sprites avanzadas en cada paso.
+                double    animation_seconds;            ///< Tiempo total gastado en avanzar las animaciones.
+            };
+
+        private:
+
             // Estos typedefs pueden ayudar a hacer el código más compacto y claro:
 
             typedef std::shared_ptr < GameObject >         GameObject_Handle;
-            typedef std::vector< GameObject_Handle >         GameObject_List;
+            typedef Tracked_Vector< GameObject_Handle, MEMORY_ENTITIES > GameObject_List;
+            typedef Tracked_Allocator< GameObject, MEMORY_ENTITIES >     GameObject_Allocator;
             typedef std::shared_ptr< Texture_2D  >         Texture_Handle;
-            typedef std::map< Id, Texture_Handle >         Texture_Map;
             typedef basics::Graphics_Context::Accessor     Context;
 
             /**
@@ -74,26 +167,69 @@
                 ENDING,
             };
 
+            /**
+             * Flujos de números aleatorios. Cada uso tiene el suyo para que lo que consume uno no
+             * cambie los números que recibe otro.
+             */
+            enum Random_Stream_Id
+            {
+                RANDOM_SPAWN,                           ///< Posición y velocidad de los submarinos y elección del que dispara.
+                RANDOM_EXPLOSIONS,
+                RANDOM_SPLASHES,
+                RANDOM_WAKE,
+                RANDOM_BEHAVIOR,                        ///< Esperas de los scripts de comportamiento.
+            };
+
+            /**
+             * Resultado de un paso de simulación que consume el hilo principal: los comandos de
+             * dibujado y las métricas que se quieran consultar sin tocar el estado de la simulación.
+             */
+            struct Simulation_Output
+            {
+                Render_Snapshot    snapshot;
+                Enemy_AI::Metrics  ai_metrics;
+                size_t             ship_command;            ///< Índice del comando que dibuja el barco (o no_command).
+                bool               playing;                 ///< Si al terminar el paso se estaba jugando.
+                Input_Frame        input;                   ///< Entrada que aplicó el paso.
+                bool               latency_recorded;        ///< Si ya se ha medido la latencia de los toques de 'input'.
+                Performance_Hud::Frame_Sample performance;  ///< Entidades y ocupación de los pools al terminar el paso (los tiempos los completa el render).
+            };
+
         private:
 
             /**
-             * Array de estructuras con la información de las texturas (Id y ruta) que hay que cargar.
+             * Manifiesto con la información de las texturas (Id y ruta) que hay que cargar. Cada Id
+             * tiene asignado en tiempo de compilación su índice en el array de texturas.
              */
-            static struct   Texture_Data { Id id; const char * path; } textures_data[];
+            static constexpr auto textures_data = make_asset_manifest
+            ({
+                { ID(ship),      "game-scene/boat.png",       256.f,  128.f },
+                { ID(submarine), "game-scene/submarine.png",  200.f,   80.f },
+                { ID(bullet),    "game-scene/bullet.png",      24.f,   24.f },
+                { ID(water),     "game-scene/water.png",     1280.f,  720.f },
+            });
 
             /**
-             * Número de items que hay en el array textures_data.
+             * Número de items que hay en el manifiesto textures_data.
              */
-            static unsigned textures_count;
+            static constexpr unsigned textures_count = textures_data.size ();
+
+            typedef std::array< Texture_Handle, textures_count > Texture_Map;
 
         private:
 
-            static constexpr float    bullet_speed              = 400.f;     ///< Velocidad a la que se mueve el proyectil (en unideades virtuales por segundo).
-            static constexpr float    ship_speed                = 600.f;     ///< Velocidad a la que se mueve el barco (en unideades virtuales por segundo).
-            static constexpr float    submarine_speed           = 200.f;     ///< Velocidad a la que se mueven los submarinos (en unidades virtuales por segundo)
-            static constexpr unsigned number_of_player_bullets  = 50;        ///< Número de balas
-            static constexpr unsigned number_of_enemy_bullets   = 10;        ///< Número de balas
-            static constexpr unsigned number_of_submarines      = 4;        ///< Número de submarinos
+            static constexpr unsigned max_explosion_particles   = 16384;    ///< Capacidad del pool de partículas de las explosiones
+            static constexpr unsigned max_splash_particles      = 8192;     ///< Capacidad del pool de partículas de las salpicaduras
+            static constexpr unsigned max_wake_particles        = 8192;     ///< Capacidad del pool de partículas de la estela del barco
+            static constexpr unsigned max_scheduled_events      = 256;      ///< Número máximo de eventos programados a la vez
+            static constexpr float    ai_budget_microseconds    = 500.f;    ///< Tiempo por fotograma con el que se compara el de la IA de los submarinos
+            static constexpr float    ai_think_interval         = .1f;      ///< Segundos entre decisiones de cada submarino
+            static constexpr float    preload_budget            = .004f;    ///< Segundos por fotograma dedicados a precargar recursos de otras escenas
+            static constexpr float    submarine_animation_fps   = 8.f;      ///< Fotogramas por segundo de la animación de los submarinos
+            static constexpr float    min_spatial_cell_size     = 16.f;     ///< Lado mínimo de las celdas del índice espacial
+            static constexpr float    max_spatial_cell_size     = 128.f;    ///< Lado máximo de las celdas del índice espacial
+            static constexpr float    entities_per_cell         = 4.f;      ///< Entidades que se busca que haya en cada celda del índice espacial
+            static constexpr float    hud_margin                = 8.f;      ///< Separación entre el panel de rendimiento y la esquina superior izquierda
 
 
         private:
@@ -106,8 +242,11 @@
             unsigned       canvas_height;                       ///< Alto  de la resolución virtual usada para dibujar.
             bool           aspect_ratio_adjusted;               ///< False hasta que se ajuste el aspect ratio de la resolución.
 
-            Texture_Map        textures;                        ///< Mapa  en el que se guardan shared_ptr a las texturas cargadas.
+            Texture_Map        textures;                        ///< Array en el que se guardan shared_ptr a las texturas cargadas (indexado según textures_data).
+            unsigned           textures_loaded;                 ///< Número de texturas de textures_data que se han cargado.
+            bool               textures_were_resident;          ///< true mientras todas las texturas se hayan obtenido de la caché sin cargarlas.
             GameObject_List    gameobjects;                     ///< Lista en la que se guardan shared_ptr a los gameobject creados.
+            Tracked_Vector< Id, MEMORY_ENTITIES > gameobject_textures;  ///< Id de la textura de cada gameobject de gameobjects (en el mismo orden).
             GameObject_List    player_bullets;                  ///< Lista de balas del jugador
             GameObject_List    enemy_bullets;                   ///< Lista de balas de los submarinos
             GameObject_List    submarines;                      ///< Lista de submarinos
@@ -118,16 +257,73 @@
 
             GameObject       * player_ship_pointer;             ///< Puntero al game object de la lista de game objects que representa el barco del jugador.
 
+            Transform_Hierarchy                                           transforms;           ///< Jerarquía de las partes de las entidades compuestas.
+            Transform_Hierarchy::Node                                     ship_cannon;          ///< Punto desde el que dispara el barco.
+            Tracked_Vector< Transform_Hierarchy::Node, MEMORY_ENTITIES >  submarine_launchers;  ///< Punto desde el que dispara cada submarino.
+
+            Sprite_Animator                                               animations;           ///< Animaciones de los sprites.
+            Tracked_Vector< Sprite_Animator::Animation, MEMORY_ENTITIES > submarine_animations; ///< Animación de cada submarino (en el orden de submarines).
+
+            Spatial_Index      spatial_index;                   ///< Índice espacial de los gameobjects visibles (se reconstruye en cada paso).
+            Collision_System   collisions;                      ///< Pares de categorías que chocan y contactos de cada paso.
 
-            Timer          timer;                               ///< Cronómetro usado para medir intervalos de tiempo
+            Particle_System    explosions;                      ///< Partículas de los submarinos alcanzados.
+            Particle_System    splashes;                        ///< Partículas de las balas enemigas que alcanzan al barco.
+            Particle_System    wake;                            ///< Partículas de la estela que deja el barco al moverse.
+
+            Timer          timer;                               ///< Cronómetro usado para medir el tiempo de carga
+            Timer_Wheel    timers;                              ///< Eventos de juego programados en tiempo de simulación
+            Enemy_AI       enemy_ai;                            ///< IA de los submarinos
+
+            Behavior_Scheduler< Game_Scene > behaviors;         ///< Scripts de comportamiento de los submarinos (uno por submarino).
+
+            Simulation_Output outputs[2];                       ///< Doble buffer: uno lo escribe la simulación y el otro se dibuja.
+            unsigned          front_output;                     ///< Índice del buffer que se dibuja.
+            bool              step_in_flight;                   ///< true si se ha lanzado un paso cuyo resultado aún no se ha publicado.
+            Input_Frame       pending_input;                    ///< Entrada recibida desde que se lanzó el último paso.
+            Input_Frame       step_input;                       ///< Entrada que consume el paso en curso.
+            float             step_time;                        ///< Tiempo que avanza el paso en curso.
+            bool              step_latency_recorded;            ///< Si la latencia de los toques del paso en curso ya se midió al adelantarlos.
+
+            bool              late_latching;                    ///< Si se corrige el snapshot con la entrada más reciente justo antes de dibujar.
+            Render_Snapshot   latched_overlay;                  ///< Comandos corregidos que se dibujan encima del snapshot.
+            Latency_Metrics   input_latency;                    ///< Latencia medida de los toques.
+
+            Render_Backend                      render_backend;         ///< Forma de dibujar elegida al crear la escena.
+            std::unique_ptr< Software_Canvas >  software_canvas;        ///< Framebuffer en memoria cuando render_backend es SOFTWARE_CANVAS.
+            std::string                         frame_dump_prefix;      ///< Prefijo de los ficheros TGA en los que se vuelcan fotogramas.
+            unsigned                            frame_dump_interval;    ///< Cada cuántos fotogramas se vuelca uno (0 para no volcar).
+            unsigned                            frames_rendered;        ///< Fotogramas dibujados con el Software_Canvas.
+            Dynamic_Resolution                  resolution;             ///< Escala a la que rasteriza el Software_Canvas según lo que tarda.
+
+            Performance_Hud                     performance_hud;        ///< Panel de métricas que se dibuja encima de la escena.
+            bool                                hud_visible;            ///< Si se dibuja el panel de métricas.
+            float                               update_milliseconds;    ///< Lo que tardó el último update() en el hilo principal.
+
+            Scenario          scenario;                         ///< Número de entidades, ritmo de disparo y velocidades.
+            Counter_Random    random;                           ///< Generador de números aleatorios con la semilla de la partida.
+            uint32_t          simulation_frame;                 ///< Pasos de simulación ejecutados (forma parte del contador de random).
+            Random_Stream     spawn_random;                     ///< Números del paso en curso para RANDOM_SPAWN.
+            Random_Stream     behavior_random;                  ///< Números del paso en curso para RANDOM_BEHAVIOR.
+
+            std::shared_ptr< const Wave_Timeline > wave_timeline;   ///< Nivel diseñado que controla a los submarinos (nulo para que aparezcan y disparen al azar).
+            Wave_Timeline::Cursor                  waves;           ///< Posición de la partida en wave_timeline.
+            unsigned          next_player_bullet;               ///< Bala del jugador por la que se empieza a buscar una libre.
+            unsigned          next_enemy_bullet;                ///< Bala enemiga por la que se empieza a buscar una libre.
+
+            Statistics        statistics;                       ///< Resultados acumulados de la partida.
+
+            std::unique_ptr< Worker_Thread > simulation_thread; ///< Hilo en el que se simula (se crea al empezar a jugar y se destruye el primero).
 
         public:
 
             /**
              * Solo inicializa los atributos que deben estar inicializados la primera vez, cuando se
              * crea la escena desde cero.
+             * @param render_backend Forma en la que se dibujará la escena.
+             * @param scenario Número de entidades, ritmo de disparo y velocidades.
              */
-            Game_Scene();
+            Game_Scene(Render_Backend render_backend = GPU_CANVAS, const Scenario & scenario = Scenario::defaults ());
 
             /**
              * Este método lo llama Director para conocer la resolución virtual con la que está
@@ -173,19 +369,243 @@
              */
             void render (Context & context) override;
 
+            /**
+             * Avanza un paso de simulación en el hilo llamador con la entrada indicada. Es la forma
+             * de avanzar una escena HEADLESS, que no depende del Director ni de un contexto gráfico.
+             * @param time Fracción de tiempo que se debe avanzar.
+             * @param input Entrada que se aplica al comienzo del paso.
+             */
+            void step (float time, const Input_Frame & input);
+
+            /**
+             * Añade un toque en la pantalla a la entrada del siguiente paso, igual que el evento
+             * touch-started (por ejemplo, para jugar sin ventana).
+             */
+            void touch ();
+
+            /**
+             * Registra en el Software_Canvas los píxeles de todas las texturas del manifiesto, que
+             * se leen de un TGA con el mismo nombre que cada PNG. Una escena SOFTWARE_CANVAS no
+             * necesita contexto gráfico ni Director: empieza a jugar al crearla, se avanza con
+             * update() y se dibuja con render_software(). Si el TGA de los submarinos es una rejilla
+             * de fotogramas del tamaño indicado en el manifiesto, se animan recorriéndola.
+             * @param root Carpeta de los recursos a la que son relativas las rutas de textures_data.
+             * @return false si falta alguna textura (los comandos que la usan se dibujan lisos).
+             */
+            bool load_texture_images (const std::string & root);
+
+            /**
+             * Dibuja el último snapshot con el Software_Canvas y vuelca el fotograma si toca.
+             */
+            void render_software ();
+
+            /**
+             * Activa o desactiva la corrección del último momento (late latching): justo antes de
+             * dibujar se vuelve a leer el acelerómetro para recolocar el barco y se dibujan las balas
+             * de los toques que aún se están simulando.
+             */
+            void set_late_latching (bool enabled)
+            {
+                late_latching = enabled;
+            }
+
+            const Latency_Metrics & get_input_latency () const
+            {
+                return input_latency;
+            }
+
+            const Statistics & get_statistics () const
+            {
+                return statistics;
+            }
+
+            const Scenario & get_scenario () const
+            {
+                return scenario;
+            }
+
+            /**
+             * Semilla de los números aleatorios. Con un escenario cuya random_seed sea esta y la
+             * misma entrada, la partida se repite igual.
+             */
+            uint64_t get_random_seed () const
+            {
+                return random.get_seed ();
+            }
+
+            /**
+             * Hace que los submarinos aparezcan y disparen cuando indica una línea de tiempo en
+             * lugar de al azar. Al empezar cada partida todos esperan ocultos a su primer SPAWN y,
+             * cuando uno es alcanzado o sale de la pantalla, a su siguiente SPAWN. Al terminar la
+             * línea de tiempo vuelve a empezar. Si la partida ya ha empezado, se reinicia.
+             * @param timeline Línea de tiempo abierta (nula para volver al comportamiento al azar).
+             */
+            void set_wave_timeline (std::shared_ptr< const Wave_Timeline > timeline);
+
+            /**
+             * Hace que cada 'interval' fotogramas dibujados con el Software_Canvas se guarden en
+             * '<path_prefix><número de fotograma>.tga' (por ejemplo, para compararlos con imágenes
+             * de referencia). Un intervalo 0 desactiva el volcado.
+             */
+            void set_frame_dump (const std::string & path_prefix, unsigned interval)
+            {
+                frame_dump_prefix   = path_prefix;
+                frame_dump_interval = interval;
+            }
+
+            /**
+             * Cambia los límites y la histéresis de la escala de resolución dinámica del
+             * Software_Canvas.
+             */
+            void set_resolution_settings (const Dynamic_Resolution::Settings & settings)
+            {
+                resolution.set_settings (settings);
+            }
+
+            const Dynamic_Resolution::Settings & get_resolution_settings () const
+            {
+                return resolution.get_settings ();
+            }
+
+            /**
+             * Escala actual de resolución, tiempo por fotograma y número de ajustes.
+             */
+            const Dynamic_Resolution::Metrics & get_resolution_metrics () const
+            {
+                return resolution.get_metrics ();
+            }
+
+            /**
+             * Muestra u oculta el panel de rendimiento (Performance_Hud) encima de la escena.
+             */
+            void set_performance_hud (bool visible)
+            {
+                if (visible && !hud_visible) performance_hud.reset ();
+
+                hud_visible = visible;
+            }
+
+            bool is_performance_hud_visible () const
+            {
+                return hud_visible;
+            }
+
+            /**
+             * Lo que tardó el panel de rendimiento en dibujarse en el último fotograma (no se
+             * incluye en el tiempo de render que muestra el propio panel).
+             */
+            float get_performance_hud_milliseconds () const
+            {
+                return hud_visible ? performance_hud.get_cost_milliseconds () : 0.f;
+            }
+
+            /**
+             * Índice espacial tal y como quedó en el último paso de simulación. Solo se debe consultar
+             * cuando no hay un paso en curso en el hilo de simulación.
+             */
+            Spatial_Index & get_spatial_index ()
+            {
+                return spatial_index;
+            }
+
+            /**
+             * Devuelve el Software_Canvas (para consultar su framebuffer o su tasa de relleno) o
+             * nullptr si la escena no lo usa o aún no lo ha creado.
+             */
+            Software_Canvas * get_software_canvas ()
+            {
+                return software_canvas.get ();
+            }
+
+            /**
+             * Permite consultar el consumo del presupuesto de la IA y lo desactualizadas que están
+             * sus decisiones (según el último paso de simulación publicado).
+             */
+            const Enemy_AI::Metrics & get_ai_metrics () const
+            {
+                return outputs[front_output].ai_metrics;
+            }
+
+            /**
+             * Encola en la caché compartida las texturas de esta escena para que la escena que se
+             * esté ejecutando las vaya cargando antes de cambiar a ella.
+             */
+            static void preload_assets ()
+            {
+                Resource_Cache::get_instance ().preload (textures_data);
+            }
+
+            /**
+             * Manifiesto de las texturas de la escena, para las herramientas que las preparan fuera
+             * del juego (ver Texture_Cooker::cook()).
+             */
+            static const Asset_Manifest< textures_count > & get_textures_data ()
+            {
+                return textures_data;
+            }
+
         private:
 
             /**
              * En este método se cargan las texturas (una cada fotograma para facilitar que la
-             * propia carga se pueda pausar cuando la aplicación pasa a segundo plano).
+             * propia carga se pueda pausar cuando la aplicación pasa a segundo plano). Las que ya
+             * están en la caché compartida se toman todas en el mismo fotograma.
              */
             void load_textures ();
 
+            /**
+             * Devuelve la textura con el Id indicado. El índice se resuelve en tiempo de compilación,
+             * por lo que un Id que no esté en textures_data produce un error de compilación.
+             */
+            template< Id TEXTURE_ID >
+            Texture_2D * get_texture ()
+            {
+                return textures[std::integral_constant< unsigned, textures_data.index_of (TEXTURE_ID) >::value].get ();
+            }
+
+            /**
+             * Crea un gameobject con la textura indicada o, si la textura no se ha cargado (escena
+             * HEADLESS), con el tamaño nominal que indica textures_data. Se reserva junto con el
+             * bloque de control del shared_ptr a cuenta de MEMORY_ENTITIES.
+             */
+            template< Id TEXTURE_ID >
+            GameObject_Handle create_gameobject ()
+            {
+                Texture_2D * texture = get_texture< TEXTURE_ID > ();
+
+                if (texture) return std::allocate_shared< GameObject > (GameObject_Allocator(), texture);
+
+                const Asset_Data & data = textures_data[std::integral_constant< unsigned, textures_data.index_of (TEXTURE_ID) >::value];
+
+                return std::allocate_shared< GameObject > (GameObject_Allocator(), Size2f{ data.width, data.height });
+            }
+
             /**
              * En este método se crean los gameobjects cuando termina la carga de texturas.
              */
             void create_gameobjects();
 
+            /**
+             * Añade un gameobject a la lista de los que se simulan y se dibujan.
+             * @param texture_id Id de su textura en textures_data.
+             */
+            void add_gameobject (const GameObject_Handle & gameobject, Id texture_id)
+            {
+                gameobjects        .push_back (gameobject);
+                gameobject_textures.push_back (texture_id);
+            }
+
+            /**
+             * Hace que todos los submarinos reproduzcan en bucle los fotogramas de una rejilla que
+             * ocupa toda su textura.
+             */
+            void set_submarine_frames (unsigned columns, unsigned rows);
+
+            /**
+             * Anota un toque en la entrada del siguiente paso.
+             */
+            void record_touch ();
+
             /**
              * Se llama cada vez que se debe reiniciar el juego. En concreto la primera vez y cada
              * vez que un jugador pierde.
@@ -198,11 +618,33 @@
              */
             void start_playing ();
 
+            /**
+             * Espera a que termine el paso de simulación anterior, publica su snapshot para que se
+             * dibuje y lanza el siguiente paso en el hilo de simulación.
+             */
+            void pipeline_step (float time);
+
+            /**
+             * Paso de simulación que se ejecuta en el hilo de simulación: aplica la entrada, simula
+             * y escribe el snapshot en el buffer que no se está dibujando.
+             */
+            void simulate_step ();
+
+            /**
+             * Aplica la entrada acumulada desde el paso anterior.
+             */
+            void apply_input (const Input_Frame & input);
+
             /**
              * Actualiza el estado del juego cuando el estado de la escena es RUNNING.
              */
             void run_simulation (float time);
 
+            /**
+             * Escribe en el buffer indicado los comandos de dibujado del estado actual.
+             */
+            void build_output (Simulation_Output & output);
+
 
             /**
              * Dibuja la textura con el mensaje de carga mientras el estado de la escena es LOADING.
@@ -211,12 +653,65 @@
              */
             void render_loading (Canvas & canvas);
 
+            /**
+             * Se invoca al comienzo de cada paso de simulación por cada evento programado que ha vencido.
+             * @param event Id con el que se programó el evento.
+             * @param data Dato con el que se programó el evento.
+             */
+            void handle_scheduled_event (Id event, uint32_t data);
+
+            /**
+             * Procesa los contactos que ha encontrado collisions en este paso.
+             */
+            void handle_collisions ();
+
+            /**
+             * Si la bala alcanza al submarino, la oculta, hace explotar el submarino y lo recoloca.
+             */
+            void check_bullet_hit (GameObject & bullet, GameObject & submarine);
+
+            /**
+             * Si la bala enemiga alcanza al barco, la oculta y empuja al barco hacia abajo.
+             */
+            void check_ship_hit (GameObject & bullet, GameObject & ship);
+
+            /**
+             * Vuelve a llenar el índice espacial con los gameobjects visibles del barco, las balas y
+             * los submarinos.
+             */
+            void build_spatial_index ();
+
+            /**
+             * Actualiza los sistemas de partículas y emite la estela del barco.
+             */
+            void update_particles (float time);
+
+            /**
+             * Prepara en latched_overlay el barco recolocado con la lectura más reciente del
+             * acelerómetro y las balas de los toques que aún se están simulando.
+             * @return Índice del comando del snapshot que sustituye el overlay o no_command.
+             */
+            size_t latch_input ();
+
+            /**
+             * Mide la latencia de los toques que se muestran por primera vez en el fotograma que se
+             * acaba de enviar.
+             */
+            void record_input_latency ();
+
             /**
              * Dibuja la escena de juego cuando el estado de la escena es RUNNING.
              * @param canvas Referencia al Canvas con el que dibujar.
              */
             void render_playfield (Canvas & canvas);
 
+            /**
+             * Completa las medidas del fotograma que se está dibujando y se las pasa al panel de
+             * rendimiento, que se dibuja a continuación.
+             * @param render_start Momento en el que empezó el render del fotograma.
+             */
+            void record_performance_sample (std::chrono::steady_clock::time_point render_start);
+
             /**
              * Ajusta el aspect ratio
              */
@@ -225,7 +720,12 @@
             /**
              * Se mueve al barco en función del acelerómetro
              */
-            void ship_movement();
+            void ship_movement(const Input_Frame & input);
+
+            /**
+             * Calcula la velocidad horizontal del barco para una lectura del acelerómetro
+             */
+            float ship_speed_for(const basics::Accelerometer::State & acceleration) const;
 
             /**
              * Método que controla que el barco no se salga de la pantalla
@@ -234,19 +734,60 @@
 
             /**
              * Método que genera una bala del jugador en la escena
+             * @param offset_x Desplazamiento horizontal respecto al cañón del barco.
+             * @return false si no queda ninguna bala libre.
+             */
+            bool spawn_bullet(float offset_x = 0.f);
+
+            /**
+             * Método que genera balas de los enemigos en la escena. Dispara preferentemente un
+             * submarino que la IA considere alineado con el barco y, si la ráfaga tiene más de una
+             * bala, los siguientes submarinos.
+             * @param volley Número de balas de la ráfaga.
+             */
+            void spawn_enemy_bullet(unsigned volley = 1);
+
+            /**
+             * Dispara una ráfaga desde un submarino y, si tiene más de una bala, desde los
+             * siguientes submarinos visibles.
+             * @param submarine Índice de un submarino visible.
              */
-            void spawn_bullet();
+            void fire_volley(unsigned submarine, unsigned volley);
 
             /**
-             * Método que genera una bala de los enemigos en la escena
+             * Busca una bala oculta empezando por 'cursor' y dejando este en la siguiente, de modo
+             * que disparar muchas seguidas no recorre una y otra vez las que ya están en vuelo.
+             * @return Índice de la bala o bullets.size() si están todas en vuelo.
              */
-            void spawn_enemy_bullet();
+            static size_t find_free_bullet(const GameObject_List & bullets, unsigned & cursor);
 
             /**
              * Método que da unos valores random a los submarinos
              */
             void random_submarine_values(GameObject & submarine);
 
+            /**
+             * Coloca un submarino en el borde por el que entra según el sentido de su velocidad.
+             */
+            void place_submarine(GameObject & submarine, float y, float speed);
+
+            /**
+             * Se llama cuando un submarino es alcanzado o sale de la pantalla: reaparece al azar o,
+             * si hay una línea de tiempo, se oculta hasta su siguiente SPAWN.
+             */
+            void recycle_submarine(GameObject & submarine);
+
+            /**
+             * Aplica un evento de wave_timeline.
+             */
+            void handle_wave_event(const Wave_Timeline::Event & event);
+
+            /**
+             * Script de patrulla de un submarino: espera un tiempo al azar, bucea (o sube si no
+             * tiene sitio debajo) y vuelve a su altura, y dispara una ráfaga. Se repite siempre.
+             */
+            static Behavior_Status submarine_patrol(Behavior_Frame & frame, Game_Scene & scene);
+
 
 
         };
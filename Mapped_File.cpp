@@ -0,0 +1,126 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Mapped_File.hpp"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace jesus_villar_examen
+{
+
+    Mapped_File::Mapped_File()
+    :
+        data (nullptr),
+        size (0)
+    {
+        #if defined(_WIN32)
+        file    = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+        #endif
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    #if defined(_WIN32)
+
+        bool Mapped_File::open (const std::string & path)
+        {
+            close ();
+
+            file = CreateFileA (path.c_str (), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+            LARGE_INTEGER file_size;
+
+            if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx (file, &file_size) || file_size.QuadPart == 0)
+            {
+                close ();
+                return false;
+            }
+
+            mapping = CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            data    = mapping ? static_cast< const uint8_t * >(MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            size    = size_t(file_size.QuadPart);
+
+            if (!data)
+            {
+                close ();
+                return false;
+            }
+
+            return true;
+        }
+
+        void Mapped_File::close ()
+        {
+            if (data                        ) UnmapViewOfFile (data);
+            if (mapping                     ) CloseHandle     (mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle     (file);
+
+            data    = nullptr;
+            size    = 0;
+            file    = INVALID_HANDLE_VALUE;
+            mapping = nullptr;
+        }
+
+    #else
+
+        // El descriptor se puede cerrar en cuanto existe la proyección, que lo mantiene abierto.
+        // Se avisa de que el acceso será secuencial para que el sistema lea por adelantado.
+
+        bool Mapped_File::open (const std::string & path)
+        {
+            close ();
+
+            int descriptor = ::open (path.c_str (), O_RDONLY);
+
+            if (descriptor < 0) return false;
+
+            struct stat status;
+
+            if (fstat (descriptor, &status) != 0 || status.st_size <= 0)
+            {
+                ::close (descriptor);
+                return false;
+            }
+
+            void * mapped = mmap (nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+            ::close (descriptor);
+
+            if (mapped == MAP_FAILED) return false;
+
+            madvise (mapped, size_t(status.st_size), MADV_SEQUENTIAL);
+
+            data = static_cast< const uint8_t * >(mapped);
+            size = size_t(status.st_size);
+
+            return true;
+        }
+
+        void Mapped_File::close ()
+        {
+            if (data) munmap (const_cast< uint8_t * >(data), size);
+
+            data = nullptr;
+            size = 0;
+        }
+
+    #endif
+
+}
@@ -0,0 +1,80 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef MAPPED_FILE_HEADER
+#define MAPPED_FILE_HEADER
+
+    #include <string>
+    #include <cstddef>
+    #include <cstdint>
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Fichero proyectado en memoria en modo de solo lectura (mmap en POSIX y Android,
+         * MapViewOfFile en Windows). El contenido no se copia: el sistema carga las páginas a
+         * medida que se leen y las puede descartar cuando falta memoria, así que leer un fichero
+         * grande no ocupa memoria del proceso en proporción a su tamaño.
+         */
+        class Mapped_File
+        {
+
+            const uint8_t * data;
+            size_t          size;
+
+            #if defined(_WIN32)
+            void          * file;                       ///< HANDLE del fichero.
+            void          * mapping;                    ///< HANDLE de la proyección.
+            #endif
+
+        public:
+
+            Mapped_File();
+
+           ~Mapped_File()
+            {
+                close ();
+            }
+
+            Mapped_File(const Mapped_File & ) = delete;
+            Mapped_File & operator = (const Mapped_File & ) = delete;
+
+        public:
+
+            /**
+             * Proyecta un fichero (cerrando antes el que hubiera).
+             * @return false si no se ha podido abrir o está vacío.
+             */
+            bool open (const std::string & path);
+
+            void close ();
+
+            bool is_open () const
+            {
+                return data != nullptr;
+            }
+
+            const uint8_t * get_data () const
+            {
+                return data;
+            }
+
+            size_t get_size () const
+            {
+                return size;
+            }
+
+        };
+
+    }
+
+#endif
@@ -0,0 +1,213 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Memory_Tracker.hpp"
+
+#include <cstdio>
+#include <limits>
+
+namespace jesus_villar_examen
+{
+
+    // No se destruye nunca para que los objetos estáticos que se destruyan después (como las
+    // texturas retenidas por Resource_Cache) puedan seguir anotando lo que liberan.
+
+    Memory_Tracker & Memory_Tracker::get_instance ()
+    {
+        static Memory_Tracker * instance = new Memory_Tracker;
+
+        return *instance;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    const char * Memory_Tracker::get_name (Memory_Tag tag)
+    {
+        switch (tag)
+        {
+            case MEMORY_ENTITIES:       return "entities";
+            case MEMORY_TEXTURES_CPU:   return "textures_cpu";
+            case MEMORY_TEXTURES_GPU:   return "textures_gpu";
+            case MEMORY_POOLS:          return "pools";
+            case MEMORY_RENDER_BUFFERS: return "render_buffers";
+            case MEMORY_SPATIAL_INDEX:  return "spatial_index";
+            case MEMORY_CONTACTS:       return "contacts";
+            default:                    return "?";
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Memory_Tracker::Memory_Tracker()
+    {
+        for (Counter & counter : counters)
+        {
+            counter.current    .store (0);
+            counter.peak       .store (0);
+            counter.budget     .store (0);
+            counter.allocations.store (0);
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Los contadores se actualizan sin bloquear. El pico se sube con compare_exchange solo si el
+    // nuevo valor lo supera, así que puede quedarse ligeramente por debajo del real si dos hilos
+    // reservan y liberan a la vez, pero nunca por encima.
+
+    void Memory_Tracker::allocate (Memory_Tag tag, size_t bytes)
+    {
+        Counter & counter = counters[tag];
+
+        size_t current = counter.current.fetch_add (bytes, std::memory_order_relaxed) + bytes;
+        size_t peak    = counter.peak.load (std::memory_order_relaxed);
+
+        while (current > peak && !counter.peak.compare_exchange_weak (peak, current, std::memory_order_relaxed));
+
+        counter.allocations.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    void Memory_Tracker::release (Memory_Tag tag, size_t bytes)
+    {
+        counters[tag].current.fetch_sub (bytes, std::memory_order_relaxed);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    size_t Memory_Tracker::get_remaining_budget (Memory_Tag tag) const
+    {
+        size_t budget  = counters[tag].budget .load (std::memory_order_relaxed);
+        size_t current = counters[tag].current.load (std::memory_order_relaxed);
+
+        if (budget == 0) return std::numeric_limits< size_t >::max ();
+
+        return current < budget ? budget - current : 0;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Memory_Tracker::Tag_Statistics Memory_Tracker::get_statistics (Memory_Tag tag) const
+    {
+        const Counter & counter = counters[tag];
+
+        return Tag_Statistics
+        {
+            get_name (tag),
+            counter.current    .load (std::memory_order_relaxed),
+            counter.peak       .load (std::memory_order_relaxed),
+            counter.budget     .load (std::memory_order_relaxed),
+            counter.allocations.load (std::memory_order_relaxed)
+        };
+    }
+
+    size_t Memory_Tracker::get_total_bytes () const
+    {
+        size_t total = 0;
+
+        for (const Counter & counter : counters) total += counter.current.load (std::memory_order_relaxed);
+
+        return total;
+    }
+
+    uint64_t Memory_Tracker::get_total_allocations () const
+    {
+        uint64_t total = 0;
+
+        for (const Counter & counter : counters) total += counter.allocations.load (std::memory_order_relaxed);
+
+        return total;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Memory_Tracker::reset_peaks ()
+    {
+        for (Counter & counter : counters)
+        {
+            counter.peak.store (counter.current.load (std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    std::string Memory_Tracker::format_report () const
+    {
+        std::string report = "subsistema          actual KB    pico KB  límite KB     reservas\n";
+        char        line[128];
+
+        for (unsigned tag = 0; tag < MEMORY_TAG_COUNT; ++tag)
+        {
+            Tag_Statistics statistics = get_statistics (Memory_Tag(tag));
+
+            snprintf
+            (
+                line, sizeof(line), "%-16s %12.1f %10.1f %10.1f %12llu%s\n",
+                statistics.name, statistics.current_bytes / 1024.0, statistics.peak_bytes / 1024.0, statistics.budget_bytes / 1024.0,
+                (unsigned long long)statistics.allocations, is_within_budget (Memory_Tag(tag)) ? "" : "  SUPERA EL LÍMITE"
+            );
+
+            report += line;
+        }
+
+        snprintf (line, sizeof(line), "%-16s %12.1f\n", "total", get_total_bytes () / 1024.0);
+
+        return report += line;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Memory_Counter::Memory_Counter(Memory_Tag tag, size_t bytes)
+    :
+        tag  (tag),
+        bytes(0)
+    {
+        set_bytes (bytes);
+    }
+
+    Memory_Counter::Memory_Counter(const Memory_Counter & other)
+    :
+        tag  (other.tag),
+        bytes(0)
+    {
+        set_bytes (other.bytes);
+    }
+
+    Memory_Counter & Memory_Counter::operator = (const Memory_Counter & other)
+    {
+        if (this != &other)
+        {
+            set_bytes (0);
+
+            tag = other.tag;
+
+            set_bytes (other.bytes);
+        }
+
+        return *this;
+    }
+
+    Memory_Counter::~Memory_Counter()
+    {
+        set_bytes (0);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Memory_Counter::set_bytes (size_t new_bytes)
+    {
+        Memory_Tracker & tracker = Memory_Tracker::get_instance ();
+
+        if      (new_bytes > bytes) tracker.allocate (tag, new_bytes - bytes);
+        else if (new_bytes < bytes) tracker.release  (tag, bytes - new_bytes);
+
+        bytes = new_bytes;
+    }
+
+}
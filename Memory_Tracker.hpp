@@ -0,0 +1,214 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef MEMORY_TRACKER_HEADER
+#define MEMORY_TRACKER_HEADER
+
+    #include <atomic>
+    #include <string>
+    #include <vector>
+    #include <memory>
+    #include <cstddef>
+    #include <cstdint>
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Subsistemas a los que se atribuye la memoria.
+         */
+        enum Memory_Tag
+        {
+            MEMORY_ENTITIES,                ///< Gameobjects (incluido el bloque de control de sus shared_ptr), listas, jerarquía, animaciones e IA.
+            MEMORY_TEXTURES_CPU,            ///< Copias en CPU de las texturas (Software_Canvas).
+            MEMORY_TEXTURES_GPU,            ///< Estimación de lo que ocupan en GPU las texturas residentes (RGBA8).
+            MEMORY_POOLS,                   ///< Pools de partículas y de temporizadores.
+            MEMORY_RENDER_BUFFERS,          ///< Snapshots de comandos y framebuffers del Software_Canvas.
+            MEMORY_SPATIAL_INDEX,           ///< Índice espacial.
+            MEMORY_CONTACTS,                ///< Contactos que guarda el Collision_System en cada paso.
+            MEMORY_TAG_COUNT
+        };
+
+        /**
+         * Contabilidad de memoria por subsistema compartida por todo el proceso (se puede usar
+         * desde cualquier hilo). Cada subsistema informa de lo que reserva y libera mediante
+         * Tracked_Allocator (contenedores y shared_ptr) o Memory_Counter (bloques cuyo tamaño se
+         * conoce, como las texturas). Se guardan los bytes actuales, el pico y el número de
+         * reservas, y se puede fijar un presupuesto por subsistema que consultan los que pueden
+         * renunciar a memoria (por ejemplo, la precarga de texturas).
+         */
+        class Memory_Tracker
+        {
+        public:
+
+            struct Tag_Statistics
+            {
+                const char * name;
+                size_t       current_bytes;
+                size_t       peak_bytes;                ///< Máximo desde el inicio o desde reset_peaks().
+                size_t       budget_bytes;              ///< 0 si no tiene presupuesto.
+                uint64_t     allocations;               ///< Reservas hechas desde el inicio.
+            };
+
+        private:
+
+            struct Counter
+            {
+                std::atomic< size_t   > current;
+                std::atomic< size_t   > peak;
+                std::atomic< size_t   > budget;
+                std::atomic< uint64_t > allocations;
+            };
+
+            Counter counters[MEMORY_TAG_COUNT];
+
+        public:
+
+            /**
+             * Devuelve la contabilidad compartida por todo el proceso.
+             */
+            static Memory_Tracker & get_instance ();
+
+            static const char * get_name (Memory_Tag tag);
+
+            Memory_Tracker();
+
+            Memory_Tracker(const Memory_Tracker & ) = delete;
+            Memory_Tracker & operator = (const Memory_Tracker & ) = delete;
+
+        public:
+
+            void allocate (Memory_Tag tag, size_t bytes);
+            void release  (Memory_Tag tag, size_t bytes);
+
+            /**
+             * Fija el presupuesto de un subsistema (0 para quitarlo). No impide reservar: son los
+             * subsistemas los que deben consultar is_within_budget() antes de crecer.
+             */
+            void set_budget (Memory_Tag tag, size_t bytes)
+            {
+                counters[tag].budget.store (bytes, std::memory_order_relaxed);
+            }
+
+            bool is_within_budget (Memory_Tag tag) const
+            {
+                size_t budget = counters[tag].budget.load (std::memory_order_relaxed);
+
+                return budget == 0 || counters[tag].current.load (std::memory_order_relaxed) <= budget;
+            }
+
+            /**
+             * Cuánto se puede reservar aún sin pasar del presupuesto (SIZE_MAX si no tiene).
+             */
+            size_t get_remaining_budget (Memory_Tag tag) const;
+
+            Tag_Statistics get_statistics (Memory_Tag tag) const;
+
+            size_t   get_total_bytes       () const;
+            uint64_t get_total_allocations () const;
+
+            /**
+             * Hace que el pico de cada subsistema vuelva a ser su valor actual.
+             */
+            void reset_peaks ();
+
+            /**
+             * Tabla con los bytes actuales, el pico, el presupuesto y las reservas de cada subsistema.
+             */
+            std::string format_report () const;
+
+        };
+
+        /**
+         * Allocator estándar que anota en Memory_Tracker todo lo que reserva con la etiqueta TAG.
+         * Sirve para contenedores y para std::allocate_shared (que así cuenta también el bloque de
+         * control del shared_ptr).
+         */
+        template< typename TYPE, Memory_Tag TAG >
+        class Tracked_Allocator
+        {
+        public:
+
+            typedef TYPE value_type;
+
+            template< typename OTHER >
+            struct rebind
+            {
+                typedef Tracked_Allocator< OTHER, TAG > other;
+            };
+
+            Tracked_Allocator() = default;
+
+            template< typename OTHER >
+            Tracked_Allocator(const Tracked_Allocator< OTHER, TAG > & )
+            {
+            }
+
+            TYPE * allocate (size_t count)
+            {
+                Memory_Tracker::get_instance ().allocate (TAG, count * sizeof(TYPE));
+
+                return std::allocator< TYPE >().allocate (count);
+            }
+
+            void deallocate (TYPE * pointer, size_t count)
+            {
+                Memory_Tracker::get_instance ().release (TAG, count * sizeof(TYPE));
+
+                std::allocator< TYPE >().deallocate (pointer, count);
+            }
+
+            template< typename OTHER >
+            bool operator == (const Tracked_Allocator< OTHER, TAG > & ) const { return true;  }
+
+            template< typename OTHER >
+            bool operator != (const Tracked_Allocator< OTHER, TAG > & ) const { return false; }
+        };
+
+        template< typename TYPE, Memory_Tag TAG >
+        using Tracked_Vector = std::vector< TYPE, Tracked_Allocator< TYPE, TAG > >;
+
+        /**
+         * Bytes atribuidos a un subsistema mientras exista el objeto, para memoria que no pasa por
+         * un Tracked_Allocator. Al copiarlo se cuentan también los bytes de la copia.
+         */
+        class Memory_Counter
+        {
+            Memory_Tag tag;
+            size_t     bytes;
+
+        public:
+
+            explicit Memory_Counter(Memory_Tag tag, size_t bytes = 0);
+
+            Memory_Counter(const Memory_Counter & other);
+
+            Memory_Counter & operator = (const Memory_Counter & other);
+
+           ~Memory_Counter();
+
+        public:
+
+            size_t get_bytes () const
+            {
+                return bytes;
+            }
+
+            /**
+             * Cambia los bytes atribuidos (anotando solo la diferencia).
+             */
+            void set_bytes (size_t new_bytes);
+
+        };
+
+    }
+
+#endif
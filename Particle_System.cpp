@@ -0,0 +1,187 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Particle_System.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define PARTICLES_USE_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define PARTICLES_USE_NEON
+#endif
+
+using namespace basics;
+
+namespace jesus_villar_examen
+{
+
+    Particle_System::Particle_System(const Settings & settings, unsigned capacity)
+    :
+        settings (settings),
+        capacity ((capacity + 3) & ~3u),
+        count    (0)
+    {
+        // Se reserva todo el pool de golpe para que emitir nunca tenga que reservar memoria:
+
+        position_x.resize (this->capacity);
+        position_y.resize (this->capacity);
+        speed_x   .resize (this->capacity);
+        speed_y   .resize (this->capacity);
+        life      .resize (this->capacity);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Particle_System::emit (const Point2f & origin, unsigned amount, float direction)
+    {
+        // Cada partícula necesita tres números aleatorios (ángulo, velocidad y vida). Se generan
+        // por tandas en un buffer de la pila para aprovechar que fill_uniform() usa SIMD:
+
+        static constexpr unsigned batch_size = 64;
+
+        float uniforms[3 * batch_size];
+
+        amount = std::min (amount, capacity - count);
+
+        while (amount > 0)
+        {
+            unsigned batch = std::min (amount, batch_size);
+
+            random.fill_uniform (uniforms, 3 * batch);
+
+            for (const float * uniform = uniforms, * end = uniforms + 3 * batch; uniform < end; uniform += 3, ++count)
+            {
+                float angle = direction + settings.spread * (uniform[0] - .5f);
+                float speed = settings.min_speed + (settings.max_speed - settings.min_speed) * uniform[1];
+
+                position_x[count] = origin[0];
+                position_y[count] = origin[1];
+                speed_x   [count] = cosf (angle) * speed;
+                speed_y   [count] = sinf (angle) * speed;
+                life      [count] = settings.life * (.5f + .5f * uniform[2]);
+            }
+
+            amount -= batch;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // La integración se hace de cuatro en cuatro partículas. Como la capacidad es múltiplo de 4 se
+    // puede procesar el último bloque entero aunque no esté completo: las partículas muertas que
+    // quedan al final se actualizan también, pero su resultado se ignora.
+
+    void Particle_System::update (float time)
+    {
+        const float damping = std::max (0.f, 1.f - settings.drag * time);
+        const float gravity = settings.gravity * time;
+
+        float * px = position_x.data ();
+        float * py = position_y.data ();
+        float * vx = speed_x   .data ();
+        float * vy = speed_y   .data ();
+        float * lf = life      .data ();
+
+        unsigned index = 0;
+
+        #if defined(PARTICLES_USE_SSE)
+
+            const __m128 t = _mm_set1_ps (time   );
+            const __m128 d = _mm_set1_ps (damping);
+            const __m128 g = _mm_set1_ps (gravity);
+
+            for ( ; index < count; index += 4)
+            {
+                __m128 sx = _mm_mul_ps (_mm_loadu_ps (vx + index), d);
+                __m128 sy = _mm_add_ps (_mm_mul_ps (_mm_loadu_ps (vy + index), d), g);
+
+                _mm_storeu_ps (vx + index, sx);
+                _mm_storeu_ps (vy + index, sy);
+                _mm_storeu_ps (px + index, _mm_add_ps (_mm_loadu_ps (px + index), _mm_mul_ps (sx, t)));
+                _mm_storeu_ps (py + index, _mm_add_ps (_mm_loadu_ps (py + index), _mm_mul_ps (sy, t)));
+                _mm_storeu_ps (lf + index, _mm_sub_ps (_mm_loadu_ps (lf + index), t));
+            }
+
+        #elif defined(PARTICLES_USE_NEON)
+
+            const float32x4_t t = vdupq_n_f32 (time   );
+            const float32x4_t d = vdupq_n_f32 (damping);
+            const float32x4_t g = vdupq_n_f32 (gravity);
+
+            for ( ; index < count; index += 4)
+            {
+                float32x4_t sx = vmulq_f32 (vld1q_f32 (vx + index), d);
+                float32x4_t sy = vmlaq_f32 (g, vld1q_f32 (vy + index), d);
+
+                vst1q_f32 (vx + index, sx);
+                vst1q_f32 (vy + index, sy);
+                vst1q_f32 (px + index, vmlaq_f32 (vld1q_f32 (px + index), sx, t));
+                vst1q_f32 (py + index, vmlaq_f32 (vld1q_f32 (py + index), sy, t));
+                vst1q_f32 (lf + index, vsubq_f32 (vld1q_f32 (lf + index), t));
+            }
+
+        #endif
+
+        // Implementación escalar para plataformas sin SIMD:
+
+        for ( ; index < count; ++index)
+        {
+            vx[index]  = vx[index] * damping;
+            vy[index]  = vy[index] * damping + gravity;
+            px[index] += vx[index] * time;
+            py[index] += vy[index] * time;
+            lf[index] -= time;
+        }
+
+        // Se eliminan las partículas muertas moviendo la última viva a su hueco para que el pool
+        // siga siendo contiguo:
+
+        for (index = 0; index < count; )
+        {
+            if (lf[index] <= 0.f)
+            {
+                --count;
+
+                px[index] = px[count];
+                py[index] = py[count];
+                vx[index] = vx[count];
+                vy[index] = vy[count];
+                lf[index] = lf[count];
+            }
+            else
+                ++index;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Particle_System::snapshot (Render_Snapshot & snapshot, uint8_t layer) const
+    {
+        const float inverse_life = 1.f / settings.life;
+
+        for (unsigned index = 0; index < count; ++index)
+        {
+            float scale = life[index] * inverse_life;
+
+            snapshot.add
+            (
+                position_x[index], position_y[index],
+                settings.size.width * scale, settings.size.height * scale,
+                settings.red, settings.green, settings.blue,
+                layer
+            );
+        }
+    }
+
+}
@@ -0,0 +1,130 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef PARTICLE_SYSTEM_HEADER
+#define PARTICLE_SYSTEM_HEADER
+
+    #include <vector>
+    #include <basics/Vector>
+
+    #include "Render_Snapshot.hpp"
+    #include "Memory_Tracker.hpp"
+    #include "Counter_Random.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        using basics::Size2f;
+        using basics::Point2f;
+        using basics::Vector2f;
+
+        /**
+         * Sistema de partículas con un pool de tamaño fijo. El estado de las partículas se guarda
+         * como estructura de arrays (SoA) para poder actualizarlo de cuatro en cuatro con SIMD
+         * (SSE o NEON según la plataforma). Las partículas vivas siempre ocupan las primeras
+         * posiciones de los arrays, por lo que actualizarlas y generar sus comandos de dibujado
+         * solo recorre memoria contigua.
+         */
+        class Particle_System
+        {
+        public:
+
+            /**
+             * Parámetros con los que se emiten y dibujan las partículas de un sistema.
+             */
+            struct Settings
+            {
+                float    red, green, blue;              ///< Color con el que se dibujan las partículas.
+                Size2f   size;                          ///< Tamaño de cada partícula al nacer (se reduce con la vida restante).
+                float    min_speed;                     ///< Velocidad mínima al emitirse (en unidades virtuales por segundo).
+                float    max_speed;                     ///< Velocidad máxima al emitirse (en unidades virtuales por segundo).
+                float    spread;                        ///< Apertura en radianes del cono de emisión alrededor de la dirección dada.
+                float    gravity;                       ///< Aceleración vertical aplicada a todas las partículas.
+                float    drag;                          ///< Fracción de velocidad que se pierde por segundo (en [0, 1]).
+                float    life;                          ///< Duración de cada partícula en segundos.
+            };
+
+        private:
+
+            Settings            settings;
+
+            unsigned            capacity;               ///< Número máximo de partículas vivas (múltiplo de 4).
+            unsigned            count;                  ///< Número de partículas vivas.
+
+            Random_Stream       random;                 ///< Números con los que se reparten velocidades y vidas al emitir.
+
+            Tracked_Vector< float, MEMORY_POOLS > position_x;
+            Tracked_Vector< float, MEMORY_POOLS > position_y;
+            Tracked_Vector< float, MEMORY_POOLS > speed_x;
+            Tracked_Vector< float, MEMORY_POOLS > speed_y;
+            Tracked_Vector< float, MEMORY_POOLS > life;        ///< Tiempo de vida restante de cada partícula.
+
+        public:
+
+            /**
+             * Inicializa el pool reservando toda la memoria de una vez.
+             * @param settings Parámetros de emisión y dibujado.
+             * @param capacity Número máximo de partículas vivas a la vez. Se redondea a múltiplo de 4.
+             */
+            Particle_System(const Settings & settings, unsigned capacity);
+
+        public:
+
+            unsigned get_count    () const { return count;    }
+            unsigned get_capacity () const { return capacity; }
+
+            /**
+             * Cambia la secuencia de números aleatorios que usa emit(). Quien controla la
+             * simulación la renueva en cada paso para que las emisiones sean reproducibles.
+             */
+            void set_random (const Random_Stream & random)
+            {
+                this->random = random;
+            }
+
+        public:
+
+            /**
+             * Emite partículas desde un punto. Si el pool está lleno se emiten solo las que caben,
+             * de modo que el coste por fotograma nunca supera el de 'capacity' partículas.
+             * @param origin Punto desde el que salen las partículas.
+             * @param amount Número de partículas a emitir.
+             * @param direction Ángulo en radianes alrededor del cual se reparten las velocidades.
+             */
+            void emit (const Point2f & origin, unsigned amount, float direction);
+
+            /**
+             * Elimina todas las partículas vivas.
+             */
+            void clear ()
+            {
+                count = 0;
+            }
+
+            /**
+             * Avanza la simulación de todas las partículas vivas y descarta las que han muerto.
+             * @param time Fracción de tiempo que se debe avanzar.
+             */
+            void update (float time);
+
+            /**
+             * Añade al snapshot un comando por partícula viva. Como todas comparten color, al
+             * dibujarlas solo hay un cambio de color por sistema.
+             * @param snapshot Snapshot en el que se escriben los comandos.
+             * @param layer Capa en la que se dibujan las partículas.
+             */
+            void snapshot (Render_Snapshot & snapshot, uint8_t layer) const;
+
+        };
+
+    }
+
+#endif
@@ -0,0 +1,291 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Performance_Hud.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "Memory_Tracker.hpp"
+
+namespace jesus_villar_examen
+{
+
+    constexpr unsigned Performance_Hud::history_size;               ///< Fotogramas que muestra la gráfica.
+    constexpr float    Performance_Hud::pixel_size;                 ///< Lado en unidades virtuales de cada píxel de los glifos.
+    constexpr float    Performance_Hud::graph_height;               ///< Alto de la gráfica en unidades virtuales.
+    constexpr float    Performance_Hud::graph_milliseconds;         ///< Tiempo por fotograma que corresponde a la altura completa de la gráfica.
+    constexpr float    Performance_Hud::target_milliseconds;        ///< Tiempo por fotograma objetivo (línea de referencia).
+    constexpr float    Performance_Hud::text_interval;              ///< Segundos entre regeneraciones de los textos.
+
+    // ---------------------------------------------------------------------------------------------
+    // Atlas de glifos de 3x5 píxeles. Cada glifo ocupa 15 bits: una fila de 3 bits por cada una de
+    // las 5 filas, de arriba a abajo, con el píxel izquierdo en el bit de mayor peso. Los
+    // caracteres que no aparecen se dibujan como espacios.
+
+    static const char     glyph_characters[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.:/%-";
+    static const uint16_t glyph_atlas     [] =
+    {
+        0b111'101'101'101'111, 0b010'110'010'010'111, 0b111'001'111'100'111, 0b111'001'111'001'111,     // 0 1 2 3
+        0b101'101'111'001'001, 0b111'100'111'001'111, 0b111'100'111'101'111, 0b111'001'001'001'001,     // 4 5 6 7
+        0b111'101'111'101'111, 0b111'101'111'001'111,                                                   // 8 9
+        0b010'101'111'101'101, 0b110'101'110'101'110, 0b011'100'100'100'011, 0b110'101'101'101'110,     // A B C D
+        0b111'100'110'100'111, 0b111'100'110'100'100, 0b011'100'101'101'011, 0b101'101'111'101'101,     // E F G H
+        0b111'010'010'010'111, 0b001'001'001'101'010, 0b101'101'110'101'101, 0b100'100'100'100'111,     // I J K L
+        0b101'111'111'101'101, 0b110'101'101'101'101, 0b010'101'101'101'010, 0b110'101'110'100'100,     // M N O P
+        0b010'101'101'110'011, 0b110'101'110'101'101, 0b011'100'010'001'110, 0b111'010'010'010'010,     // Q R S T
+        0b101'101'101'101'111, 0b101'101'101'101'010, 0b101'101'111'111'101, 0b101'101'010'101'101,     // U V W X
+        0b101'101'010'010'010, 0b111'001'010'100'111,                                                   // Y Z
+        0b000'000'000'000'010, 0b000'010'000'010'000, 0b001'001'010'100'100, 0b101'001'010'100'101,     // . : / %
+        0b000'000'111'000'000,                                                                          // -
+    };
+
+    static_assert (sizeof(glyph_atlas) / sizeof(glyph_atlas[0]) == sizeof(glyph_characters) - 1, "Falta algún glifo en el atlas");
+
+    static uint16_t glyph_of (char character)
+    {
+        const char * found = character ? strchr (glyph_characters, toupper (character)) : nullptr;
+
+        return found ? glyph_atlas[found - glyph_characters] : 0;
+    }
+
+    // Medidas del panel en unidades virtuales:
+
+    static constexpr unsigned text_lines    = 7;
+    static constexpr unsigned text_columns  = 30;
+    static constexpr float    glyph_advance = 4 * Performance_Hud::pixel_size;     // 3 píxeles y 1 de separación
+    static constexpr float    line_height   = 7 * Performance_Hud::pixel_size;     // 5 píxeles y 2 de separación
+    static constexpr float    padding       = 4.f;
+    static constexpr float    bar_width     = 2.f;
+    static constexpr float    panel_width   = std::max (text_columns * glyph_advance, Performance_Hud::history_size * bar_width) + 2 * padding;
+    static constexpr float    panel_height  = text_lines * line_height + Performance_Hud::graph_height + 3 * padding;
+
+    // ---------------------------------------------------------------------------------------------
+
+    Performance_Hud::Performance_Hud()
+    {
+        text_quads .commands.reserve (1024);
+        graph_quads.commands.reserve (history_size + 1);
+
+        reset ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Performance_Hud::reset ()
+    {
+        std::fill_n (frame_history, history_size, 0.f);
+
+        history_next      = 0;
+        has_last_frame    = false;
+        sample            = Frame_Sample {};
+        last_allocations  = Memory_Tracker::get_instance ().get_total_allocations ();
+        frame_allocations = 0;
+        text_age          = text_interval;              // Para que los textos se generen en el primer draw()
+        cost_milliseconds = 0.f;
+
+        text_quads .clear ();
+        graph_quads.clear ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Performance_Hud::record (const Frame_Sample & frame_sample)
+    {
+        Clock::time_point now = Clock::now ();
+
+        if (has_last_frame)
+        {
+            float frame_milliseconds = std::chrono::duration< float, std::milli >(now - last_frame).count ();
+
+            frame_history[history_next] = frame_milliseconds;
+            history_next                = (history_next + 1) % history_size;
+            text_age                   += frame_milliseconds * .001f;
+        }
+
+        last_frame     = now;
+        has_last_frame = true;
+        sample         = frame_sample;
+
+        uint64_t allocations = Memory_Tracker::get_instance ().get_total_allocations ();
+
+        frame_allocations = allocations - last_allocations;
+        last_allocations  = allocations;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // En ambos casos el tiempo medido incluye regenerar los rectángulos y dibujarlos.
+
+    void Performance_Hud::draw (Canvas & canvas, float left, float top)
+    {
+        Clock::time_point start = Clock::now ();
+
+        build (left, top);
+
+        text_quads .render (canvas);
+        graph_quads.render (canvas);
+
+        cost_milliseconds = std::chrono::duration< float, std::milli >(Clock::now () - start).count ();
+    }
+
+    void Performance_Hud::draw (Software_Canvas & canvas, float left, float top)
+    {
+        Clock::time_point start = Clock::now ();
+
+        build (left, top);
+
+        canvas.render (text_quads );
+        canvas.render (graph_quads);
+
+        cost_milliseconds = std::chrono::duration< float, std::milli >(Clock::now () - start).count ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Performance_Hud::build (float left, float top)
+    {
+        if (text_age >= text_interval)
+        {
+            build_text (left, top);
+
+            text_age = 0.f;
+        }
+
+        build_graph (left + padding, top - panel_height + padding);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Se muestra el coste del panel medido en el fotograma anterior, ya que el del actual no se
+    // conoce hasta terminar de dibujarlo.
+
+    void Performance_Hud::build_text (float left, float top)
+    {
+        text_quads.clear ();
+
+        text_quads.add (left + panel_width * .5f, top - panel_height * .5f, panel_width, panel_height, .08f, .08f, .1f, LAYER_HUD);
+
+        float total_milliseconds = 0.f;
+        float worst_milliseconds = 0.f;
+        unsigned frames          = 0;
+
+        for (float frame_milliseconds : frame_history)
+        {
+            if (frame_milliseconds > 0.f)
+            {
+                total_milliseconds += frame_milliseconds;
+                worst_milliseconds  = std::max (worst_milliseconds, frame_milliseconds);
+                frames++;
+            }
+        }
+
+        float average_milliseconds = frames > 0 ? total_milliseconds / frames : 0.f;
+
+        char lines[text_lines][64];
+
+        snprintf (lines[0], sizeof(lines[0]), "FPS %.0f FT %.2f MAX %.2f", average_milliseconds > 0.f ? 1000.f / average_milliseconds : 0.f, average_milliseconds, worst_milliseconds);
+        snprintf (lines[1], sizeof(lines[1]), "UPD %.2f SIM %.2f REN %.2f", sample.update_milliseconds, sample.simulation_milliseconds, sample.render_milliseconds);
+        snprintf (lines[2], sizeof(lines[2]), "HUD %.3f MS", cost_milliseconds);
+        snprintf (lines[3], sizeof(lines[3]), "ENT %u DRAW %u", sample.entities, sample.draw_calls);
+        snprintf (lines[4], sizeof(lines[4]), "BUL %u/%u ENE %u/%u", sample.player_bullets, sample.player_bullet_capacity, sample.enemy_bullets, sample.enemy_bullet_capacity);
+        snprintf (lines[5], sizeof(lines[5]), "PART %u/%u TIM %u/%u", sample.particles, sample.particle_capacity, sample.timers, sample.timer_capacity);
+        snprintf (lines[6], sizeof(lines[6]), "ALLOC %llu MEM %zuKB", (unsigned long long)frame_allocations, Memory_Tracker::get_instance ().get_total_bytes () / 1024);
+
+        for (unsigned line = 0; line < text_lines; ++line)
+        {
+            // El coste del propio panel se destaca en otro color:
+
+            bool highlighted = line == 2;
+
+            add_text (lines[line], left + padding, top - padding - line * line_height, highlighted ? .4f : .9f, .9f, highlighted ? 1.f : .9f);
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Una barra por fotograma, de la más antigua a la más reciente, verde si llega a tiempo,
+    // amarilla si tarda hasta el doble y roja si tarda más. Encima, una línea marca el objetivo.
+
+    void Performance_Hud::build_graph (float left, float bottom)
+    {
+        graph_quads.clear ();
+
+        for (unsigned bar = 0; bar < history_size; ++bar)
+        {
+            float frame_milliseconds = frame_history[(history_next + bar) % history_size];
+
+            if (frame_milliseconds <= 0.f) continue;
+
+            float height = std::min (frame_milliseconds / graph_milliseconds, 1.f) * graph_height;
+            float x      = left + (bar + .5f) * bar_width;
+
+            if (frame_milliseconds <= target_milliseconds)
+            {
+                graph_quads.add (x, bottom + height * .5f, bar_width, height, .2f, .9f, .3f, LAYER_HUD);
+            }
+            else if (frame_milliseconds <= 2.f * target_milliseconds)
+            {
+                graph_quads.add (x, bottom + height * .5f, bar_width, height, 1.f, .85f, .2f, LAYER_HUD);
+            }
+            else
+            {
+                graph_quads.add (x, bottom + height * .5f, bar_width, height, 1.f, .25f, .2f, LAYER_HUD);
+            }
+        }
+
+        float target_y = bottom + target_milliseconds / graph_milliseconds * graph_height;
+
+        graph_quads.add (left + history_size * bar_width * .5f, target_y, history_size * bar_width, 1.f, .9f, .9f, .9f, LAYER_HUD);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Se recorre el texto fila a fila de píxeles y cada tramo de píxeles encendidos seguidos se
+    // dibuja con un solo rectángulo.
+
+    void Performance_Hud::add_text (const char * text, float left, float top, float red, float green, float blue)
+    {
+        size_t length = strlen (text);
+
+        for (unsigned row = 0; row < 5; ++row)
+        {
+            float    y          = top - (row + .5f) * pixel_size;
+            unsigned run_start  = 0;
+            unsigned run_length = 0;
+            unsigned column     = 0;
+
+            for (size_t character = 0; character <= length; ++character, column += 4)
+            {
+                unsigned bits = character < length ? (glyph_of (text[character]) >> ((4 - row) * 3)) & 7u : 0u;
+
+                for (unsigned pixel = 0; pixel < 4; ++pixel)
+                {
+                    if (pixel < 3 && bits & (4u >> pixel))
+                    {
+                        if (run_length++ == 0) run_start = column + pixel;
+                    }
+                    else if (run_length > 0)
+                    {
+                        text_quads.add
+                        (
+                            left + (run_start + run_length * .5f) * pixel_size, y,
+                            run_length * pixel_size, pixel_size,
+                            red, green, blue,
+                            LAYER_HUD
+                        );
+
+                        run_length = 0;
+                    }
+                }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,142 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef PERFORMANCE_HUD_HEADER
+#define PERFORMANCE_HUD_HEADER
+
+    #include <chrono>
+    #include <cstdint>
+
+    #include <basics/Canvas>
+
+    #include "Render_Snapshot.hpp"
+    #include "Software_Canvas.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        using basics::Canvas;
+
+        /**
+         * Panel con métricas de rendimiento que se dibuja encima de la escena para poder medir en
+         * el propio dispositivo: gráfica de los últimos tiempos por fotograma, reparto entre update,
+         * simulación y render, entidades, llamadas de dibujado, ocupación de los pools y reservas
+         * de memoria del último fotograma.
+         *
+         * No usa texturas: los textos se escriben con un atlas de glifos de 3x5 píxeles incluido en
+         * el código y cada tramo horizontal de píxeles encendidos se convierte en un único
+         * rectángulo. Todos los rectángulos van en un Render_Snapshot que se dibuja de una vez, y
+         * los textos solo se regeneran unas cuantas veces por segundo. Lo que tarda el propio panel
+         * se mide aparte para poder descontarlo del resto de medidas.
+         */
+        class Performance_Hud
+        {
+        public:
+
+            /**
+             * Medidas de un fotograma que proporciona la escena.
+             */
+            struct Frame_Sample
+            {
+                float    update_milliseconds;           ///< Lo que tardó update() (incluye esperar al paso de simulación anterior).
+                float    simulation_milliseconds;       ///< Lo que tardó el paso de simulación que se está dibujando.
+                float    render_milliseconds;           ///< Lo que tardó render() sin contar el panel.
+                unsigned draw_calls;                    ///< Rectángulos dibujados (sin contar el panel).
+                unsigned entities;                      ///< Gameobjects visibles.
+                unsigned player_bullets;                ///< Balas del jugador en vuelo.
+                unsigned player_bullet_capacity;
+                unsigned enemy_bullets;                 ///< Balas enemigas en vuelo.
+                unsigned enemy_bullet_capacity;
+                unsigned particles;                     ///< Partículas vivas de todos los sistemas.
+                unsigned particle_capacity;
+                unsigned timers;                        ///< Eventos programados.
+                unsigned timer_capacity;
+            };
+
+            static constexpr unsigned history_size        = 120;    ///< Fotogramas que muestra la gráfica.
+            static constexpr float    pixel_size          = 2.f;    ///< Lado en unidades virtuales de cada píxel de los glifos.
+            static constexpr float    graph_height        = 48.f;   ///< Alto de la gráfica en unidades virtuales.
+            static constexpr float    graph_milliseconds  = 50.f;   ///< Tiempo por fotograma que corresponde a la altura completa de la gráfica.
+            static constexpr float    target_milliseconds = 1000.f / 60.f;  ///< Tiempo por fotograma objetivo (línea de referencia).
+            static constexpr float    text_interval       = .25f;   ///< Segundos entre regeneraciones de los textos.
+
+        private:
+
+            typedef std::chrono::steady_clock Clock;
+
+            float             frame_history[history_size];  ///< Tiempo entre fotogramas en milisegundos (buffer circular).
+            unsigned          history_next;                 ///< Hueco de frame_history que se escribe a continuación.
+            Clock::time_point last_frame;
+            bool              has_last_frame;
+
+            Frame_Sample      sample;                       ///< Medidas del último fotograma.
+            uint64_t          last_allocations;             ///< Reservas totales de Memory_Tracker al registrar el fotograma anterior.
+            uint64_t          frame_allocations;            ///< Reservas hechas durante el último fotograma.
+
+            Render_Snapshot   text_quads;                   ///< Rectángulos del fondo y de los textos.
+            Render_Snapshot   graph_quads;                  ///< Rectángulos de la gráfica (se regeneran en cada fotograma).
+            float             text_age;                     ///< Segundos desde que se regeneraron los textos.
+
+            float             cost_milliseconds;            ///< Lo que tardó el panel en generarse y dibujarse la última vez.
+
+        public:
+
+            Performance_Hud();
+
+        public:
+
+            /**
+             * Registra las medidas de un fotograma. Se llama una vez por fotograma justo antes de
+             * draw(); el tiempo entre fotogramas se mide entre llamadas consecutivas.
+             */
+            void record (const Frame_Sample & frame_sample);
+
+            /**
+             * Dibuja el panel con su esquina superior izquierda en (left, top).
+             */
+            void draw (Canvas          & canvas, float left, float top);
+            void draw (Software_Canvas & canvas, float left, float top);
+
+            /**
+             * Lo que tardó el panel la última vez que se dibujó, que no se incluye en ninguna de
+             * las medidas que muestra.
+             */
+            float get_cost_milliseconds () const
+            {
+                return cost_milliseconds;
+            }
+
+            /**
+             * Olvida la gráfica (por ejemplo, tras un tiempo sin dibujar el panel).
+             */
+            void reset ();
+
+        private:
+
+            /**
+             * Regenera los rectángulos que lo necesiten: la gráfica siempre y los textos cada
+             * text_interval segundos.
+             */
+            void build (float left, float top);
+
+            void build_text  (float left, float top);
+            void build_graph (float left, float bottom);
+
+            /**
+             * Añade a text_quads una línea de texto con su esquina superior izquierda en (left, top).
+             */
+            void add_text (const char * text, float left, float top, float red, float green, float blue);
+
+        };
+
+    }
+
+#endif
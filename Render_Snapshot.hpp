@@ -0,0 +1,165 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef RENDER_SNAPSHOT_HEADER
+#define RENDER_SNAPSHOT_HEADER
+
+    #include <vector>
+    #include <cstddef>
+    #include <cstdint>
+
+    #include <basics/Id>
+    #include <basics/Canvas>
+    #include <basics/Texture_2D>
+
+    #include "GameObject.hpp"
+    #include "Memory_Tracker.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        using basics::Id;
+        using basics::Canvas;
+        using basics::Texture_2D;
+
+        /**
+         * Orden de dibujado de los comandos. Los comandos se generan ya ordenados por capa.
+         */
+        enum Render_Layer : uint8_t
+        {
+            LAYER_WORLD,
+            LAYER_WAKE,
+            LAYER_EXPLOSIONS,
+            LAYER_SPLASHES,
+            LAYER_HUD,                                  ///< Paneles de depuración, siempre encima de todo.
+        };
+
+        /**
+         * Región de una textura en coordenadas normalizadas (origen abajo a la izquierda).
+         */
+        struct UV_Rect
+        {
+            float u0, v0;
+            float u1, v1;
+
+            static constexpr UV_Rect full ()
+            {
+                return { 0.f, 0.f, 1.f, 1.f };
+            }
+        };
+
+        /**
+         * Comando de dibujado de un rectángulo (con textura o de color liso). Es POD para que el
+         * snapshot se pueda copiar y leer sin tocar el estado de la simulación.
+         */
+        struct Render_Command
+        {
+            float              x, y;                    ///< Posición en coordenadas virtuales.
+            float              width, height;           ///< Tamaño ya escalado en coordenadas virtuales.
+            const Texture_2D * texture;                 ///< Textura (cargada y sin cambios mientras dure la escena) o nullptr.
+            Id                 texture_id;              ///< Id de la textura en el manifiesto (o Id()). El Software_Canvas busca con él sus píxeles.
+            float              red, green, blue;        ///< Color usado cuando no hay textura.
+            int                anchor;                  ///< Punto del rectángulo que se coloca en (x, y).
+            uint8_t            layer;                   ///< Capa a la que pertenece (Render_Layer).
+            UV_Rect            uv;                      ///< Región de la textura que se dibuja (por ejemplo, un fotograma de un atlas).
+        };
+
+        /**
+         * Lista inmutable de comandos de dibujado que produce la simulación al terminar cada paso.
+         * Hay dos: mientras la simulación escribe en una, el render lee de la otra.
+         */
+        struct Render_Snapshot
+        {
+            static constexpr size_t                                 no_command = size_t(-1);  ///< Índice que no corresponde a ningún comando.
+
+            Tracked_Vector< Render_Command, MEMORY_RENDER_BUFFERS > commands;
+            float                                                   simulation_microseconds;  ///< Tiempo que tardó el paso que lo produjo.
+
+            /**
+             * Vacía la lista conservando la memoria reservada.
+             */
+            void clear ()
+            {
+                commands.clear ();
+                simulation_microseconds = 0.f;
+            }
+
+            /**
+             * Añade el comando que dibuja un gameobject (solo si es visible).
+             * @param texture_id Id de su textura en el manifiesto de la escena.
+             * @param uv Región de su textura que se dibuja.
+             */
+            void add (const GameObject & gameobject, Id texture_id, uint8_t layer, const UV_Rect & uv = UV_Rect::full ())
+            {
+                if (gameobject.is_visible ())
+                {
+                    commands.push_back
+                    ({
+                        gameobject.get_position_x (), gameobject.get_position_y (),
+                        gameobject.get_width () * gameobject.get_scale (), gameobject.get_height () * gameobject.get_scale (),
+                        gameobject.get_texture (),
+                        texture_id,
+                        1.f, 1.f, 1.f,
+                        gameobject.get_anchor (),
+                        layer,
+                        uv
+                    });
+                }
+            }
+
+            /**
+             * Añade el comando que dibuja un rectángulo de color liso centrado en (x, y).
+             */
+            void add (float x, float y, float width, float height, float red, float green, float blue, uint8_t layer)
+            {
+                commands.push_back ({ x, y, width, height, nullptr, Id(), red, green, blue, basics::CENTER, layer, UV_Rect::full () });
+            }
+
+            /**
+             * Dibuja todos los comandos en orden. Solo se cambia el color cuando cambia entre
+             * comandos consecutivos sin textura. El Canvas dibuja siempre la textura completa, por
+             * lo que aquí se ignora la región UV (el Software_Canvas sí la respeta).
+             * @param skipped_command Índice de un comando que no se debe dibujar (por ejemplo,
+             *      porque se va a dibujar corregido después) o no_command.
+             */
+            void render (Canvas & canvas, size_t skipped_command = no_command) const
+            {
+                const Render_Command * last_colored = nullptr;
+
+                for (const Render_Command & command : commands)
+                {
+                    if (&command - commands.data () == std::ptrdiff_t(skipped_command))
+                    {
+                        continue;
+                    }
+
+                    if (command.texture)
+                    {
+                        canvas.fill_rectangle ({ command.x, command.y }, { command.width, command.height }, command.texture, command.anchor);
+                    }
+                    else
+                    {
+                        if (!last_colored || last_colored->red != command.red || last_colored->green != command.green || last_colored->blue != command.blue)
+                        {
+                            canvas.set_color (command.red, command.green, command.blue);
+
+                            last_colored = &command;
+                        }
+
+                        canvas.fill_rectangle ({ command.x, command.y }, { command.width, command.height });
+                    }
+                }
+            }
+        };
+
+    }
+
+#endif
@@ -0,0 +1,297 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef RESOURCE_CACHE_HEADER
+#define RESOURCE_CACHE_HEADER
+
+    #include <map>
+    #include <array>
+    #include <mutex>
+    #include <deque>
+    #include <chrono>
+    #include <memory>
+
+    #include <basics/Id>
+    #include <basics/Graphics_Context>
+    #include <basics/Texture_2D>
+
+    #include "Asset_Manifest.hpp"
+    #include "Memory_Tracker.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        using basics::Id;
+
+        /**
+         * Caché de texturas compartida por todas las escenas. Cada textura se carga una sola vez y
+         * se añade al contexto gráfico, que conserva su propia referencia a ella, así que no hay
+         * forma de liberarla antes de que se destruya el contexto. Por eso la caché también la
+         * retiene: mientras dura el contexto todas las escenas reciben la misma textura sin volver
+         * a cargarla ni a añadirla al contexto.
+         *
+         * Además permite encolar los recursos de la siguiente escena para que se vayan cargando
+         * poco a poco mientras la escena actual se ejecuta, de modo que al cambiar de escena ya
+         * están disponibles y no hace falta mostrar otra pantalla de carga.
+         *
+         * Lo que ocupan en GPU las texturas cargadas se estima como ancho x alto x 4 bytes (RGBA8,
+         * sin mipmaps) y se anota en MEMORY_TEXTURES_GPU hasta que se destruye la caché. La
+         * precarga se detiene mientras ese subsistema supere su presupuesto.
+         *
+         * TEXTURE debe ofrecer create(id, context, ruta), get_width() y get_height() como
+         * basics::Texture_2D, y CONTEXT, add(textura) a través de -> como
+         * basics::Graphics_Context::Accessor (las comprobaciones de Self_Test.hpp usan sustitutos
+         * que no necesitan GPU).
+         */
+        template< typename TEXTURE, typename CONTEXT >
+        class Basic_Resource_Cache
+        {
+        public:
+
+            typedef std::shared_ptr< TEXTURE >          Texture_Handle;
+            typedef CONTEXT                             Context;
+
+            struct Statistics
+            {
+                unsigned resident;                      ///< Texturas cargadas.
+                unsigned pending;                       ///< Texturas encoladas para precargar.
+                unsigned loads;                         ///< Texturas que se han tenido que cargar de disco.
+                unsigned hits;                          ///< Peticiones servidas sin cargar nada.
+            };
+
+        private:
+
+            struct Entry
+            {
+                Texture_Handle texture;
+                Memory_Counter memory;                  ///< Lo que se le ha atribuido en MEMORY_TEXTURES_GPU.
+            };
+
+            std::map< Id, Entry >                       textures;          ///< Texturas cargadas.
+            std::deque< Asset_Data >                    preload_queue;     ///< Recursos pendientes de precargar.
+            std::mutex                                  mutex;
+            unsigned                                    loads;
+            unsigned                                    hits;
+
+        public:
+
+            /**
+             * Devuelve la caché compartida por todas las escenas.
+             */
+            static Basic_Resource_Cache & get_instance ()
+            {
+                static Basic_Resource_Cache instance;
+
+                return instance;
+            }
+
+            Basic_Resource_Cache() : loads(0), hits(0)
+            {
+            }
+
+            Basic_Resource_Cache(const Basic_Resource_Cache & ) = delete;
+            Basic_Resource_Cache & operator = (const Basic_Resource_Cache & ) = delete;
+
+        public:
+
+            /**
+             * Indica si una textura está cargada, de forma que acquire() no tendría que leerla.
+             */
+            bool is_resident (Id id)
+            {
+                std::lock_guard< std::mutex > lock (mutex);
+
+                return textures.count (id) > 0;
+            }
+
+            /**
+             * Devuelve la textura si está cargada o nullptr en caso contrario. No carga nada.
+             */
+            Texture_Handle find (Id id)
+            {
+                std::lock_guard< std::mutex > lock (mutex);
+
+                auto entry = textures.find (id);
+
+                return entry != textures.end () ? entry->second.texture : nullptr;
+            }
+
+            /**
+             * Devuelve la textura indicada cargándola y añadiéndola al contexto si no está residente.
+             * @return nullptr si no se ha podido cargar.
+             */
+            Texture_Handle acquire (const Asset_Data & asset, Context & context)
+            {
+                std::lock_guard< std::mutex > lock (mutex);
+
+                return load (asset, context);
+            }
+
+            /**
+             * Toma las texturas de un manifiesto a partir de la número loaded y avanza loaded. Las
+             * residentes no cuestan nada, así que solo se para después de la primera que haya que
+             * cargar de disco (para cargar una por fotograma) o de la primera que no se pueda cargar.
+             * @param handles Texturas del manifiesto, indexadas según manifest.index_of().
+             * @param resident Se pone a false si se ha tenido que cargar alguna de disco.
+             * @return false si una textura no se ha podido cargar (y se queda en nullptr).
+             */
+            template< unsigned COUNT >
+            bool acquire_next
+            (
+                const Asset_Manifest< COUNT > & manifest,
+                unsigned & loaded,
+                std::array< Texture_Handle, size_t(COUNT) > & handles,
+                Context & context,
+                bool & resident
+            )
+            {
+                std::lock_guard< std::mutex > lock (mutex);
+
+                while (loaded < COUNT)
+                {
+                    const Asset_Data & asset   = manifest[loaded];
+                    bool               cached  = textures.count (asset.id) > 0;
+                    Texture_Handle   & texture = handles[manifest.index_of (asset.id)] = load (asset, context);
+
+                    if (!texture) return false;
+
+                    ++loaded;
+
+                    if (!cached)
+                    {
+                        resident = false;
+                        break;
+                    }
+                }
+
+                return true;
+            }
+
+            /**
+             * Encola para precargar los recursos de un manifiesto que aún no están residentes.
+             */
+            template< unsigned COUNT >
+            void preload (const Asset_Manifest< COUNT > & manifest)
+            {
+                for (unsigned index = 0; index < COUNT; ++index)
+                {
+                    preload (manifest[index]);
+                }
+            }
+
+            void preload (const Asset_Data & asset)
+            {
+                std::lock_guard< std::mutex > lock (mutex);
+
+                if (textures.count (asset.id) > 0) return;
+
+                for (const Asset_Data & pending : preload_queue)
+                {
+                    if (pending.id == asset.id) return;
+                }
+
+                preload_queue.push_back (asset);
+            }
+
+            /**
+             * Carga recursos encolados hasta agotar el presupuesto de tiempo (al menos uno por
+             * llamada si hay alguno pendiente y las texturas residentes no superan el presupuesto de
+             * memoria de MEMORY_TEXTURES_GPU). Se llama desde el render de la escena activa, que es
+             * cuando se dispone del contexto gráfico.
+             * @return true si quedan recursos por precargar.
+             */
+            bool preload_step (Context & context, float budget_seconds)
+            {
+                typedef std::chrono::steady_clock Clock;
+
+                std::lock_guard< std::mutex > lock (mutex);
+
+                Clock::time_point start = Clock::now ();
+
+                while (!preload_queue.empty ())
+                {
+                    // Lo pendiente se queda en la cola: si se libera memoria se reanuda y, si no, la
+                    // escena que lo pida lo cargará igualmente con acquire().
+
+                    if (!Memory_Tracker::get_instance ().is_within_budget (MEMORY_TEXTURES_GPU)) break;
+
+                    // Si falla se deja para que la escena que la pida informe del error:
+
+                    load (preload_queue.front (), context);
+
+                    preload_queue.pop_front ();
+
+                    if (std::chrono::duration< float >(Clock::now () - start).count () >= budget_seconds) break;
+                }
+
+                return !preload_queue.empty ();
+            }
+
+            /**
+             * Vacía la cola de precarga (las texturas que ya se han precargado siguen residentes).
+             */
+            void release_preloaded ()
+            {
+                std::lock_guard< std::mutex > lock (mutex);
+
+                preload_queue.clear ();
+            }
+
+            Statistics get_statistics ()
+            {
+                std::lock_guard< std::mutex > lock (mutex);
+
+                return Statistics { unsigned(textures.size ()), unsigned(preload_queue.size ()), loads, hits };
+            }
+
+        private:
+
+            /**
+             * Se llama con el mutex bloqueado. Cada textura se añade al contexto una sola vez, cuando
+             * se carga, y su memoria se anota mientras la retenga la caché.
+             */
+            Texture_Handle load (const Asset_Data & asset, Context & context)
+            {
+                auto found = textures.find (asset.id);
+
+                if (found != textures.end ())
+                {
+                    hits++;
+
+                    return found->second.texture;
+                }
+
+                Texture_Handle texture = TEXTURE::create (asset.id, context, asset.path);
+
+                if (texture)
+                {
+                    context->add (texture);
+
+                    Entry & entry = textures.emplace (asset.id, Entry { texture, Memory_Counter(MEMORY_TEXTURES_GPU) }).first->second;
+
+                    entry.memory.set_bytes (size_t(texture->get_width ()) * size_t(texture->get_height ()) * 4);
+
+                    loads++;
+                }
+
+                return texture;
+            }
+
+        };
+
+        /**
+         * Caché de las texturas de basics que comparten las escenas del juego.
+         */
+        typedef Basic_Resource_Cache< basics::Texture_2D, basics::Graphics_Context::Accessor > Resource_Cache;
+
+    }
+
+#endif
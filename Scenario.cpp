@@ -0,0 +1,190 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Scenario.hpp"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+
+namespace jesus_villar_examen
+{
+
+    Scenario Scenario::defaults ()
+    {
+        Scenario scenario;
+
+        scenario.player_bullets      = 50;
+        scenario.enemy_bullets       = 10;
+        scenario.submarines          = 4;
+        scenario.enemy_fire_interval = 2.f;
+        scenario.enemy_volley        = 1;
+        scenario.auto_fire_interval  = 0.f;
+        scenario.auto_fire_volley    = 1;
+        scenario.bullet_speed        = 400.f;
+        scenario.ship_speed          = 600.f;
+        scenario.submarine_speed     = 200.f;
+        scenario.random_seed         = 0;
+        scenario.behavior_scripts    = 0;
+        scenario.ai_agents_per_step  = 256;
+        scenario.max_contacts        = 0;
+
+        return scenario;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Una bala del jugador tarda algo menos de un segundo en cruzar el agua y una enemiga como
+    // mucho eso mismo, así que disparando cada 0.05 s ráfagas de 1/20 y 1/10 de las balas casi
+    // todas están en vuelo a la vez.
+
+    Scenario Scenario::stress (unsigned entities)
+    {
+        Scenario scenario = defaults ();
+
+        scenario.player_bullets      = entities / 10 * 8;
+        scenario.enemy_bullets       = entities / 10;
+        scenario.submarines          = std::max (entities / 10, 1u);
+        scenario.enemy_fire_interval = .05f;
+        scenario.enemy_volley        = std::max (scenario.enemy_bullets  / 10, 1u);
+        scenario.auto_fire_interval  = .05f;
+        scenario.auto_fire_volley    = std::max (scenario.player_bullets / 20, 1u);
+        scenario.behavior_scripts    = 1;
+
+        return scenario;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Lectura de los valores. Los enteros se leen como enteros (un double no representa todas las
+    // semillas de 64 bits) y se rechazan los negativos, los que no caben en el campo y los que
+    // llevan algo detrás.
+
+    static bool parse_integer (const std::string & text, uint64_t maximum, uint64_t & value)
+    {
+        std::istringstream stream (text);
+        std::string        extra;
+        uint64_t           integer;
+
+        stream >> std::ws;
+
+        if (stream.peek () == '-' || !(stream >> integer) || stream >> extra || integer > maximum) return false;
+
+        value = integer;
+
+        return true;
+    }
+
+    static bool parse_integer (const std::string & text, unsigned & value)
+    {
+        uint64_t integer;
+
+        if (!parse_integer (text, std::numeric_limits< unsigned >::max (), integer)) return false;
+
+        value = unsigned(integer);
+
+        return true;
+    }
+
+    static bool parse_real (const std::string & text, float & value)
+    {
+        std::istringstream stream (text);
+        std::string        extra;
+        double             real;
+
+        if (!(stream >> real) || stream >> extra || !std::isfinite (real) || real < 0.0 || real > std::numeric_limits< float >::max ()) return false;
+
+        value = float(real);
+
+        return true;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    bool Scenario::load (const std::string & path)
+    {
+        std::ifstream file (path);
+
+        if (!file) return false;
+
+        bool        well_formed = true;
+        std::string line;
+
+        while (std::getline (file, line))
+        {
+            line = line.substr (0, line.find ('#'));
+
+            if (line.find_first_not_of (" \t\r") == std::string::npos) continue;
+
+            size_t equals = line.find ('=');
+
+            if (equals == std::string::npos)
+            {
+                well_formed = false;
+                continue;
+            }
+
+            std::istringstream key_stream (line.substr (0, equals));
+            std::string        key;
+            std::string        value = line.substr (equals + 1);
+            bool               valid = true;
+
+            if (!(key_stream >> key))
+            {
+                well_formed = false;
+                continue;
+            }
+
+            if      (key == "player_bullets"     ) valid = parse_integer (value, player_bullets);
+            else if (key == "enemy_bullets"      ) valid = parse_integer (value, enemy_bullets);
+            else if (key == "submarines"         ) valid = parse_integer (value, submarines);
+            else if (key == "enemy_fire_interval") valid = parse_real    (value, enemy_fire_interval);
+            else if (key == "enemy_volley"       ) valid = parse_integer (value, enemy_volley);
+            else if (key == "auto_fire_interval" ) valid = parse_real    (value, auto_fire_interval);
+            else if (key == "auto_fire_volley"   ) valid = parse_integer (value, auto_fire_volley);
+            else if (key == "bullet_speed"       ) valid = parse_real    (value, bullet_speed);
+            else if (key == "ship_speed"         ) valid = parse_real    (value, ship_speed);
+            else if (key == "submarine_speed"    ) valid = parse_real    (value, submarine_speed);
+            else if (key == "random_seed"        ) valid = parse_integer (value, std::numeric_limits< uint64_t >::max (), random_seed);
+            else if (key == "behavior_scripts"   ) valid = parse_integer (value, behavior_scripts);
+            else if (key == "ai_agents_per_step" ) valid = parse_integer (value, ai_agents_per_step);
+            else if (key == "max_contacts"       ) valid = parse_integer (value, max_contacts);
+
+            // Un valor mal formado deja el campo como estaba:
+
+            if (!valid) well_formed = false;
+        }
+
+        validate ();
+
+        return well_formed;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Scenario::validate ()
+    {
+        player_bullets   = std::max (player_bullets,   1u);
+        enemy_bullets    = std::max (enemy_bullets,    1u);
+        submarines       = std::max (submarines,       1u);
+        enemy_volley     = std::max (enemy_volley,     1u);
+        auto_fire_volley = std::max (auto_fire_volley, 1u);
+
+        ai_agents_per_step = std::max (ai_agents_per_step, 1u);
+
+        // Un intervalo nulo volvería a disparar en el mismo paso indefinidamente:
+
+        enemy_fire_interval = std::max (enemy_fire_interval, .001f);
+
+        if (auto_fire_interval > 0.f) auto_fire_interval = std::max (auto_fire_interval, .001f);
+    }
+
+}
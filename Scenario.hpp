@@ -0,0 +1,89 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef SCENARIO_HEADER
+#define SCENARIO_HEADER
+
+    #include <string>
+    #include <cstdint>
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Número de entidades, ritmo de disparo y velocidades con los que se crea una Game_Scene.
+         * Se puede leer de un fichero de texto con líneas 'clave = valor' (las claves son los
+         * nombres de los campos y lo que sigue a '#' se ignora), lo que permite medir cómo escala
+         * la escena sin recompilar.
+         */
+        struct Scenario
+        {
+            unsigned player_bullets;                    ///< Balas del jugador disponibles.
+            unsigned enemy_bullets;                     ///< Balas de los submarinos disponibles.
+            unsigned submarines;                        ///< Número de submarinos.
+            float    enemy_fire_interval;               ///< Segundos entre disparos de los submarinos.
+            unsigned enemy_volley;                      ///< Balas que se disparan en cada disparo de los submarinos.
+            float    auto_fire_interval;                ///< Segundos entre disparos automáticos del barco (0 para disparar solo al tocar).
+            unsigned auto_fire_volley;                  ///< Balas de cada disparo automático del barco.
+            float    bullet_speed;                      ///< Velocidad de las balas (en unidades virtuales por segundo).
+            float    ship_speed;                        ///< Velocidad máxima del barco (en unidades virtuales por segundo).
+            float    submarine_speed;                   ///< Velocidad media de los submarinos (en unidades virtuales por segundo).
+            uint64_t random_seed;                       ///< Semilla de los números aleatorios (0 para usar una distinta en cada partida).
+            unsigned behavior_scripts;                  ///< Si no es 0, cada submarino sigue un script de patrulla (bucear, subir y disparar ráfagas).
+            unsigned ai_agents_per_step;                ///< Número máximo de submarinos cuya IA piensa en cada paso.
+            unsigned max_contacts;                      ///< Contactos que se guardan en cada paso (0 para reservar tres por entidad).
+
+            /**
+             * Escenario con el que se juega normalmente.
+             */
+            static Scenario defaults ();
+
+            /**
+             * Escenario de estrés con aproximadamente 'entities' entidades: el 80 % son balas del
+             * jugador, que dispara automáticamente para mantenerlas casi todas en vuelo, y el
+             * resto se reparte entre submarinos (cada uno con su script de patrulla) y balas
+             * enemigas.
+             */
+            static Scenario stress (unsigned entities);
+
+            /**
+             * Sobrescribe los campos que aparezcan en el fichero. Los que no aparecen conservan su
+             * valor y las claves desconocidas se ignoran. Los campos enteros solo aceptan enteros
+             * no negativos que quepan en el campo; un valor mal formado no cambia el campo.
+             * @return false si no se ha podido abrir el fichero o alguna línea está mal formada.
+             */
+            bool load (const std::string & path);
+
+            /**
+             * Corrige los valores que la escena no puede usar (por ejemplo, ningún submarino o
+             * ninguna bala).
+             */
+            void validate ();
+
+            unsigned entities () const
+            {
+                return player_bullets + enemy_bullets + submarines + 1;
+            }
+
+            /**
+             * Tamaño del buffer de contactos del Collision_System. Por defecto se reservan tres
+             * contactos por entidad: con 100000 entidades el escenario de estrés llega a pasar de
+             * dos en algún paso.
+             */
+            unsigned contact_capacity () const
+            {
+                return max_contacts > 0 ? max_contacts : 3 * entities ();
+            }
+        };
+
+    }
+
+#endif
@@ -0,0 +1,1338 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Self_Test.hpp"
+#include "Counter_Random.hpp"
+#include "Fixed.hpp"
+#include "Texture_Cooker.hpp"
+#include "Software_Canvas.hpp"
+#include "Dynamic_Resolution.hpp"
+#include "Timer_Wheel.hpp"
+#include "Spatial_Index.hpp"
+#include "Wave_Timeline.hpp"
+#include "Resource_Cache.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <sstream>
+#include <fstream>
+
+namespace jesus_villar_examen
+{
+
+    // ---------------------------------------------------------------------------------------------
+    // Formatea el detalle de un fallo como printf.
+
+    template< typename ... ARGUMENTS >
+    static bool fail (std::string & detail, const char * format, ARGUMENTS ... arguments)
+    {
+        char buffer[256];
+
+        snprintf (buffer, sizeof(buffer), format, arguments...);
+
+        detail = buffer;
+
+        return false;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Self_Test::Self_Test()
+    {
+        add_random_checks     ();
+        add_fixed_checks      ();
+        add_texture_checks    ();
+        add_resolution_checks ();
+        add_timer_checks      ();
+        add_spatial_checks    ();
+        add_wave_checks       ();
+        add_resource_checks   ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Self_Test::Results Self_Test::run () const
+    {
+        Results results;
+
+        for (const Check & check : checks)
+        {
+            Result result { check.name, false, std::string() };
+
+            result.passed = check.run (result.detail);
+
+            results.push_back (result);
+        }
+
+        return results;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Counter_Random. El primer vector de referencia es el publicado con Philox4x32-10 (contador y
+    // clave a cero); el segundo, con clave y contador distintos de cero, se calculó con una
+    // implementación independiente y comprueba también el orden de las palabras del contador
+    // ({ índice, fotograma, flujo, 0 }) y de la clave ({ semilla baja, semilla alta }).
+
+    void Self_Test::add_random_checks ()
+    {
+        add
+        ({
+            "random_known_answer",
+            [] (std::string & detail)
+            {
+                struct Vector
+                {
+                    uint64_t seed;
+                    uint32_t stream, frame, index;
+                    uint32_t expected[Counter_Random::lanes];
+                };
+
+                static const Vector vectors[] =
+                {
+                    { 0x0000000000000000ull, 0x00000000u, 0x00000000u, 0x00000000u, { 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u } },
+                    { 0x299f31d0a4093822ull, 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, { 0x725d32f8u, 0x682ac0f5u, 0x32a76540u, 0x7d27a4deu } },
+                };
+
+                for (const Vector & vector : vectors)
+                {
+                    Counter_Random::Block block = Counter_Random(vector.seed).generate (vector.stream, vector.frame, vector.index);
+
+                    for (unsigned lane = 0; lane < Counter_Random::lanes; ++lane)
+                    {
+                        if (block.values[lane] != vector.expected[lane])
+                        {
+                            return fail (detail, "semilla %016llx, número %u: %08x en lugar de %08x", (unsigned long long)vector.seed, lane, block.values[lane], vector.expected[lane]);
+                        }
+                    }
+                }
+
+                return true;
+            }
+        });
+
+        // fill_uniform() calcula los bloques con SIMD y el resto con la ruta escalar. Se prueban
+        // varios índices iniciales y todas las longitudes hasta varios vectores completos, de modo
+        // que se pasa por todas las combinaciones de bloques enteros y colas:
+
+        add
+        ({
+            "random_simd_matches_scalar",
+            [] (std::string & detail)
+            {
+                const Counter_Random random (0x0123456789ABCDEFull);
+
+                float values[67];
+
+                for (uint32_t first_index : { 0u, 1u, 3u, 1000u, 0xFFFFFFF0u })
+                {
+                    for (size_t count = 0; count <= 67; ++count)
+                    {
+                        random.fill_uniform (7, 11, first_index, values, count);
+
+                        for (size_t item = 0; item < count; ++item)
+                        {
+                            uint32_t index    = first_index + uint32_t(item / Counter_Random::lanes);
+                            float    expected = Counter_Random::to_uniform (random.generate (7, 11, index).values[item % Counter_Random::lanes]);
+
+                            if (values[item] != expected)
+                            {
+                                return fail (detail, "índice %u, longitud %zu, número %zu: %.9g en lugar de %.9g", first_index, count, item, values[item], expected);
+                            }
+                        }
+                    }
+                }
+
+                // Random_Stream::fill_uniform() debe dar la misma secuencia que next_float():
+
+                Random_Stream stream (random, 3, 0);
+                Random_Stream filled (random, 3, 0);
+
+                std::vector< float > sequence (4096);
+
+                filled.fill_uniform (sequence.data (), sequence.size ());
+
+                for (size_t item = 0; item < sequence.size (); ++item)
+                {
+                    float expected = stream.next_float ();
+
+                    if (sequence[item] != expected)
+                    {
+                        return fail (detail, "Random_Stream, número %zu: %.9g en lugar de %.9g", item, sequence[item], expected);
+                    }
+                }
+
+                return true;
+            }
+        });
+
+        // Con 2^20 números de fill_uniform(): la media, la correlación entre números consecutivos
+        // (que salen de lanes y bloques vecinos) y la chi cuadrado de 64 intervalos iguales deben
+        // quedar dentro de lo esperable para una distribución uniforme. Los límites están muy por
+        // encima de la desviación típica (media: 0.0003, correlación: 0.001; chi cuadrado con 63
+        // grados de libertad: 103.4 al 0.1%), por lo que solo fallan si algo está roto.
+
+        add
+        ({
+            "random_uniformity",
+            [] (std::string & detail)
+            {
+                const size_t   count = size_t(1) << 20;
+                const unsigned bins  = 64;
+
+                std::vector< float    > values    (count);
+                std::vector< unsigned > histogram (bins, 0);
+
+                Counter_Random(42).fill_uniform (5, 0, 0, values.data (), count);
+
+                double sum = 0.0, product = 0.0, squares = 0.0;
+
+                for (size_t item = 0; item < count; ++item)
+                {
+                    float value = values[item];
+
+                    if (!(value >= 0.f && value < 1.f)) return fail (detail, "número %zu fuera de [0, 1): %.9g", item, value);
+
+                    histogram[unsigned(value * bins)]++;
+
+                    sum     += value;
+                    squares += double(value) * value;
+
+                    if (item > 0) product += (double(values[item - 1]) - .5) * (double(value) - .5);
+                }
+
+                double mean        = sum / count;
+                double variance    = squares / count - mean * mean;
+                double correlation = product / (count - 1) / variance;
+                double expected    = double(count) / bins;
+                double chi_square  = 0.0;
+
+                for (unsigned count_in_bin : histogram)
+                {
+                    chi_square += (count_in_bin - expected) * (count_in_bin - expected) / expected;
+                }
+
+                if (std::fabs (mean - .5) > .002) return fail (detail, "media %.6f", mean);
+                if (std::fabs (correlation) > .01) return fail (detail, "correlación entre consecutivos %.6f", correlation);
+                if (chi_square > 103.4           ) return fail (detail, "chi cuadrado %.2f con 63 grados de libertad", chi_square);
+
+                // next_below() no debe pasarse del límite ni favorecer ningún valor:
+
+                Random_Stream stream (Counter_Random(42), 5, 1);
+                unsigned      below[10] = { };
+
+                for (size_t item = 0; item < 100000; ++item)
+                {
+                    uint32_t value = stream.next_below (10);
+
+                    if (value >= 10) return fail (detail, "next_below(10) ha devuelto %u", value);
+
+                    below[value]++;
+                }
+
+                chi_square = 0.0;
+
+                for (unsigned count_in_bin : below) chi_square += (count_in_bin - 10000.0) * (count_in_bin - 10000.0) / 10000.0;
+
+                if (chi_square > 27.9) return fail (detail, "next_below(10): chi cuadrado %.2f con 9 grados de libertad", chi_square);
+
+                return true;
+            }
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Fixed. Las conversiones redondean al valor representable más cercano, las operaciones cuyo
+    // resultado no cabe en Q16.16 se saturan en lugar de desbordar y dividir entre cero da el
+    // extremo con el signo del dividendo.
+
+    void Self_Test::add_fixed_checks ()
+    {
+        add
+        ({
+            "fixed_conversion",
+            [] (std::string & detail)
+            {
+                struct Conversion
+                {
+                    float   value;
+                    int32_t expected;
+                };
+
+                static const Conversion conversions[] =
+                {
+                    {  0.f,                                                   0 },
+                    {  1.f,                                               65536 },
+                    { -1.5f,                                             -98304 },
+                    {  1.f / 131072.f,                                        1 },   // Medio paso: se redondea alejándose de cero.
+                    { -1.f / 131072.f,                                       -1 },
+                    {  1.f / 262144.f,                                        0 },
+                    {  128.0000152587890625f,                           8388609 },   // Impar por encima de 2^23: no pasa al par siguiente.
+                    { -128.0000152587890625f,                          -8388609 },
+                    {  32767.998046875f,                             2147483520 },   // El mayor float por debajo de 32768.
+                    {  32768.f,                                       INT32_MAX },
+                    {  1e30f,                                         INT32_MAX },
+                    { -32768.f,                                       INT32_MIN },
+                    { -1e30f,                                         INT32_MIN },
+                    {  std::numeric_limits< float >::quiet_NaN (),            0 },
+                };
+
+                for (const Conversion & conversion : conversions)
+                {
+                    int32_t raw = Fixed(conversion.value).get_raw ();
+
+                    if (raw != conversion.expected)
+                    {
+                        return fail (detail, "Fixed(%.9g): %d en lugar de %d", conversion.value, raw, conversion.expected);
+                    }
+                }
+
+                // Todos los valores con menos de 16 bits de parte fraccionaria vuelven a float sin cambios:
+
+                for (int32_t raw = -(1 << 20); raw <= (1 << 20); raw += 97)
+                {
+                    float value = float(Fixed::from_raw (raw));
+
+                    if (Fixed(value).get_raw () != raw) return fail (detail, "%d no vuelve igual desde float (%.9g)", raw, value);
+                }
+
+                return true;
+            }
+        });
+
+        add
+        ({
+            "fixed_arithmetic",
+            [] (std::string & detail)
+            {
+                const Fixed max = Fixed::from_raw (INT32_MAX);
+                const Fixed min = Fixed::from_raw (INT32_MIN);
+
+                struct Operation
+                {
+                    const char * name;
+                    Fixed        result;
+                    int32_t      expected;
+                };
+
+                const Operation operations[] =
+                {
+                    { "3.5 + 1.25",         Fixed(3.5f) + Fixed(1.25f),             int32_t(4.75 * 65536) },
+                    { "3.5 - 4.25",         Fixed(3.5f) - Fixed(4.25f),             int32_t(-.75 * 65536) },
+                    { "-1.5 * 2.25",        Fixed(-1.5f) * Fixed(2.25f),            int32_t(-3.375 * 65536) },
+                    { "-7 / 2",             Fixed(-7.f) / Fixed(2.f),               int32_t(-3.5 * 65536) },
+                    { "máximo + 1",         max + Fixed(1.f),                       INT32_MAX },
+                    { "mínimo - 1",         min - Fixed(1.f),                       INT32_MIN },
+                    { "-mínimo",            -min,                                   INT32_MAX },
+                    { "20000 * 3",          Fixed(20000.f) * Fixed(3.f),            INT32_MAX },
+                    { "-20000 * 3",         Fixed(-20000.f) * Fixed(3.f),           INT32_MIN },
+                    { "20000 / 0.25",       Fixed(20000.f) / Fixed(.25f),           INT32_MAX },
+                    { "mínimo / -1",        min / Fixed(-1.f),                      INT32_MAX },
+                    { "5 / 0",              Fixed(5.f) / Fixed(),                   INT32_MAX },
+                    { "-5 / 0",             Fixed(-5.f) / Fixed(),                  INT32_MIN },
+                    { "0 / 0",              Fixed() / Fixed(),                      0 },
+                };
+
+                for (const Operation & operation : operations)
+                {
+                    if (operation.result.get_raw () != operation.expected)
+                    {
+                        return fail (detail, "%s: %d en lugar de %d", operation.name, operation.result.get_raw (), operation.expected);
+                    }
+                }
+
+                Fixed accumulated (32000.f);
+
+                for (int step = 0; step < 100; ++step) accumulated += Fixed(100.f);
+
+                if (accumulated != max) return fail (detail, "+= no se satura: %d", accumulated.get_raw ());
+
+                for (int step = 0; step < 1000; ++step) accumulated -= Fixed(100.f);
+
+                if (accumulated != min) return fail (detail, "-= no se satura: %d", accumulated.get_raw ());
+
+                // multiply_add() solo satura el resultado final:
+
+                Fixed fused = multiply_add (Fixed(-30000.f), Fixed(20000.f), Fixed(2.f));
+
+                if (fused != Fixed(10000.f)) return fail (detail, "multiply_add (-30000, 20000, 2): %d", fused.get_raw ());
+
+                return true;
+            }
+        });
+
+        // sqrt() y atan2() se comparan con la biblioteca estándar en double sobre los mismos
+        // valores ya convertidos a Fixed: la raíz debe ser exactamente la redondeada hacia abajo y
+        // el ángulo no puede alejarse más de dos unidades de la última posición.
+
+        add
+        ({
+            "fixed_sqrt_atan2",
+            [] (std::string & detail)
+            {
+                Random_Stream random (Counter_Random(34), 0, 0);
+
+                for (unsigned sample = 0; sample < 20000; ++sample)
+                {
+                    float magnitude = sample % 4 == 0 ? .01f : sample % 4 == 1 ? 1.f : 300.f;
+                    Fixed x (random.next_float (-magnitude, magnitude));
+                    Fixed y (random.next_float (-magnitude, magnitude));
+                    Fixed square (float(x) * float(x));
+
+                    double root = std::floor (std::sqrt (double(square.get_raw ()) * Fixed::one));
+
+                    if (Fixed::sqrt (square).get_raw () != int32_t(root))
+                    {
+                        return fail (detail, "sqrt (%.9g): %d en lugar de %d", float(square), Fixed::sqrt (square).get_raw (), int32_t(root));
+                    }
+
+                    int32_t expected = int32_t(std::lround (std::atan2 (double(float(y)), double(float(x))) * Fixed::one));
+                    int32_t angle    = Fixed::atan2 (y, x).get_raw ();
+
+                    if (std::abs (angle - expected) > 2)
+                    {
+                        return fail (detail, "atan2 (%.9g, %.9g): %d en lugar de %d", float(y), float(x), angle, expected);
+                    }
+                }
+
+                const Fixed pi = Fixed::from_raw (205887);
+
+                if (Fixed::sqrt  (Fixed(-4.f))          != Fixed()) return fail (detail, "la raíz de un negativo no es 0");
+                if (Fixed::atan2 (Fixed(), Fixed())     != Fixed()) return fail (detail, "atan2 (0, 0) no es 0");
+                if (Fixed::atan2 (Fixed(), Fixed(-1.f)) != pi     ) return fail (detail, "atan2 (0, -1) no es pi");
+
+                return true;
+            }
+        });
+    }
+
+
+    // ---------------------------------------------------------------------------------------------
+    // Texture_Cooker. Una imagen sintética con degradados, bordes duros y alfa (con un tamaño que no
+    // es múltiplo de 4 para pasar por los bloques incompletos) debe comprimirse con una calidad
+    // razonable y llegar intacta a través de un fichero KTX.
+
+    void Self_Test::add_texture_checks ()
+    {
+        add
+        ({
+            "texture_ktx_round_trip",
+            [] (std::string & detail)
+            {
+                Texture_Cooker::Image image;
+
+                image.width  = 37;
+                image.height = 21;
+
+                for (unsigned y = 0; y < image.height; ++y)
+                {
+                    for (unsigned x = 0; x < image.width; ++x)
+                    {
+                        uint32_t red   = x * 255 / (image.width  - 1);
+                        uint32_t green = y * 255 / (image.height - 1);
+                        uint32_t blue  = (x / 8 + y / 8) % 2 ? 200 : 40;
+                        uint32_t alpha = x < 12 ? 255 : x < 24 ? 128 : 0;
+
+                        image.pixels.push_back (red | green << 8 | blue << 16 | alpha << 24);
+                    }
+                }
+
+                Texture_Cooker                   cooker (1);
+                Texture_Cooker::Compressed_Image compressed = cooker.encode (image);
+                Texture_Cooker::Image            decoded;
+
+                if (!Texture_Cooker::decode (compressed, decoded)) return fail (detail, "el decodificador no acepta lo que genera el codificador");
+
+                double psnr = Texture_Cooker::psnr (image, decoded);
+
+                if (psnr < 30.0) return fail (detail, "PSNR %.2f dB", psnr);
+
+                const char * path = "sinkthemall_self_test.ktx";
+
+                Texture_Cooker::Compressed_Image loaded;
+
+                bool saved = Texture_Cooker::save_ktx (path, compressed);
+                bool read  = saved && Texture_Cooker::load_ktx (path, loaded);
+
+                std::remove (path);
+
+                if (!saved) return fail (detail, "no se ha podido escribir %s", path);
+                if (!read ) return fail (detail, "load_ktx() no acepta lo que escribe save_ktx()");
+
+                if (loaded.width != compressed.width || loaded.height != compressed.height || loaded.blocks != compressed.blocks)
+                {
+                    return fail (detail, "el KTX leído no coincide con el escrito (%ux%u)", loaded.width, loaded.height);
+                }
+
+                return true;
+            }
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Dynamic_Resolution con tiempos de fotograma sintéticos: baja la escala un paso cada vez que
+    // se pasa del objetivo frames_to_decrease fotogramas seguidos, la sube mucho más despacio, no
+    // sale de sus límites, no se mueve mientras la media queda entre los dos umbrales y deshace
+    // una bajada que no reduce el tiempo. Después, el Software_Canvas dibujando a media resolución
+    // tiene que devolver la imagen a la resolución virtual con el mismo contenido.
+
+    void Self_Test::add_resolution_checks ()
+    {
+        add
+        ({
+            "dynamic_resolution_hysteresis",
+            [] (std::string & detail)
+            {
+                const Dynamic_Resolution::Settings settings { .5f, 1.f, 8.f, .25f, .1f, 3, 10 };
+
+                Dynamic_Resolution resolution (settings);
+
+                // Por encima del objetivo, con un tiempo proporcional a la escala: un paso cada 3
+                // fotogramas hasta la escala mínima.
+
+                for (unsigned frame = 1; frame <= 60; ++frame)
+                {
+                    float expected = std::max (1.f - .1f * float(frame / 3), .5f);
+                    float scale    = resolution.update (20.f * resolution.get_scale ());
+
+                    if (std::fabs (scale - expected) > 1e-4f)
+                    {
+                        return fail (detail, "con 20 ms a escala 1 la escala es %.2f en el fotograma %u en lugar de %.2f", scale, frame, expected);
+                    }
+                }
+
+                // Dentro de la banda [6, 8] ms la escala no cambia aunque la entrada oscile:
+
+                for (unsigned frame = 0; frame < 200; ++frame) resolution.update (7.f);
+
+                const Dynamic_Resolution::Metrics before = resolution.get_metrics ();
+
+                for (unsigned frame = 0; frame < 1000; ++frame)
+                {
+                    resolution.update (frame % 2 ? 7.8f : 6.2f);
+                }
+
+                if (resolution.get_metrics ().decreases != before.decreases || resolution.get_metrics ().increases != before.increases)
+                {
+                    return fail (detail, "la escala cambia con tiempos entre los dos umbrales (%.2f)", resolution.get_scale ());
+                }
+
+                // Con margen sobra: nunca más de un paso cada 10 fotogramas y hasta la escala máxima.
+
+                unsigned increases = resolution.get_metrics ().increases;
+                unsigned last      = 0;
+
+                for (unsigned frame = 1; frame <= 400; ++frame)
+                {
+                    resolution.update (1.f);
+
+                    if (resolution.get_metrics ().increases != increases)
+                    {
+                        if (last != 0 && frame - last < settings.frames_to_increase)
+                        {
+                            return fail (detail, "la escala sube dos veces en %u fotogramas", frame - last);
+                        }
+
+                        increases = resolution.get_metrics ().increases;
+                        last      = frame;
+                    }
+                }
+
+                if (resolution.get_scale () != settings.max_scale)
+                {
+                    return fail (detail, "con 1 ms la escala se queda en %.2f", resolution.get_scale ());
+                }
+
+                // Si bajar la escala hace el fotograma más lento, se baja una vez, se deshace y ya
+                // no se vuelve a intentar mientras no sobre margen:
+
+                Dynamic_Resolution costly (settings);
+
+                for (unsigned frame = 0; frame < 300; ++frame)
+                {
+                    costly.update (costly.get_scale () < 1.f ? 12.f : 10.f);
+                }
+
+                const Dynamic_Resolution::Metrics & metrics = costly.get_metrics ();
+
+                if (metrics.scale != 1.f || metrics.decreases != 1 || metrics.reverts != 1)
+                {
+                    return fail (detail, "bajando la escala cuesta más tiempo y queda en %.2f (%u bajadas, %u deshechas)", metrics.scale, metrics.decreases, metrics.reverts);
+                }
+
+                return true;
+            }
+        });
+
+        add
+        ({
+            "software_canvas_scaled_resolve",
+            [] (std::string & detail)
+            {
+                Software_Canvas canvas (64, 32);
+                Render_Snapshot snapshot;
+
+                snapshot.add (32.f, 16.f, 32.f, 16.f, 1.f, 0.f, 0.f, 0);
+
+                canvas.set_render_scale (.5f);
+                canvas.clear   ();
+                canvas.render  (snapshot);
+                canvas.resolve ();
+
+                const Software_Canvas::Image & image = canvas.get_framebuffer ();
+
+                if (image.width != 64 || image.height != 32)
+                {
+                    return fail (detail, "la imagen resuelta mide %ux%u en lugar de 64x32", image.width, image.height);
+                }
+
+                // El centro del rectángulo es rojo y en las esquinas no entra nada de él:
+
+                uint32_t center = image.pixels[16 * 64 + 32];
+
+                if ((center & 0xFF) < 0xF0 || (center >> 8 & 0xFF) > 0x0F || (center >> 16 & 0xFF) > 0x0F)
+                {
+                    return fail (detail, "el centro es 0x%08x en lugar de rojo", center);
+                }
+
+                for (uint32_t corner : { image.pixels[0], image.pixels[63], image.pixels[31 * 64], image.pixels[31 * 64 + 63] })
+                {
+                    if ((corner & 0xFF) > 0x0F)
+                    {
+                        return fail (detail, "una esquina es 0x%08x en lugar del color de borrado", corner);
+                    }
+                }
+
+                return true;
+            }
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Timer_Wheel. Cada temporizador lleva como dato el tick en el que debe vencer y se avanza de
+    // tick en tick, así que al entregarlo get_current_tick() tiene que coincidir con él. Los
+    // retardos se eligen para caer justo antes, en y después de cada cambio de nivel, que es
+    // donde actúa la cascada. Un retardo de (n - .5) ticks vence en el tick n sin depender del
+    // redondeo de n * tick_duration.
+
+    static float ticks_to_delay (uint32_t ticks)
+    {
+        return (float(ticks) - .5f) * Timer_Wheel::tick_duration;
+    }
+
+    void Self_Test::add_timer_checks ()
+    {
+        add
+        ({
+            "timer_wheel_cascade",
+            [] (std::string & detail)
+            {
+                static const uint32_t delays[] = { 1, 2, 63, 64, 65, 127, 4095, 4096, 4097, 4160, 262143, 262144, 262145, 300000 };
+
+                Timer_Wheel wheel (64);
+
+                // Se empieza en un tick que no es múltiplo de ningún nivel:
+
+                for (unsigned tick = 0; tick < 37; ++tick) wheel.advance (Timer_Wheel::tick_duration, [] (Id, uint32_t) { });
+
+                uint32_t start = wheel.get_current_tick ();
+
+                for (uint32_t delay : delays)
+                {
+                    if (wheel.schedule (ticks_to_delay (delay), ID(cascade), start + delay) == Timer_Wheel::invalid_handle)
+                    {
+                        return fail (detail, "no se ha podido programar el retardo %u", delay);
+                    }
+                }
+
+                unsigned fired = 0;
+                uint32_t wrong = 0;
+                uint32_t due   = 0;
+
+                while (wheel.get_active_count () > 0 && wheel.get_current_tick () <= start + 300000)
+                {
+                    wheel.advance
+                    (
+                        Timer_Wheel::tick_duration,
+                        [&] (Id, uint32_t data)
+                        {
+                            if (fired < sizeof(delays) / sizeof(delays[0]) && data != start + delays[fired] && wrong == 0) wrong = data;
+                            if (data != wheel.get_current_tick () && due == 0) due = data;
+
+                            ++fired;
+                        }
+                    );
+                }
+
+                if (fired != sizeof(delays) / sizeof(delays[0])) return fail (detail, "han vencido %u de %zu temporizadores", fired, sizeof(delays) / sizeof(delays[0]));
+                if (wrong != 0) return fail (detail, "el temporizador del tick %u ha vencido fuera de orden", wrong);
+                if (due   != 0) return fail (detail, "el temporizador del tick %u ha vencido en otro tick", due);
+
+                return true;
+            }
+        });
+
+        add
+        ({
+            "timer_wheel_stale_handle",
+            [] (std::string & detail)
+            {
+                Timer_Wheel wheel (1);
+                unsigned    fired = 0;
+
+                if (wheel.cancel (Timer_Wheel::invalid_handle)) return fail (detail, "se ha cancelado invalid_handle");
+
+                Timer_Wheel::Handle cancelled = wheel.schedule (.5f, ID(stale));
+
+                if (!wheel.cancel (cancelled)) return fail (detail, "no se ha cancelado un temporizador programado");
+                if ( wheel.cancel (cancelled)) return fail (detail, "se ha cancelado dos veces el mismo temporizador");
+
+                // Con capacidad 1 el siguiente reutiliza el mismo nodo, con otra generación:
+
+                Timer_Wheel::Handle expired = wheel.schedule (.05f, ID(stale), 1);
+
+                if (expired == cancelled) return fail (detail, "el nodo reutilizado tiene el mismo handle");
+                if (wheel.cancel (cancelled) || wheel.get_active_count () != 1)
+                {
+                    return fail (detail, "el handle antiguo ha cancelado el temporizador que reutiliza su nodo");
+                }
+
+                for (unsigned tick = 0; tick < 10; ++tick) wheel.advance (Timer_Wheel::tick_duration, [&] (Id, uint32_t) { ++fired; });
+
+                if (fired != 1) return fail (detail, "el temporizador ha vencido %u veces", fired);
+
+                Timer_Wheel::Handle pending = wheel.schedule (.5f, ID(stale), 2);
+
+                if (wheel.cancel (expired) || wheel.get_active_count () != 1)
+                {
+                    return fail (detail, "el handle de un temporizador vencido ha cancelado otro");
+                }
+
+                if (!wheel.cancel (pending)) return fail (detail, "no se ha cancelado el último temporizador");
+
+                return true;
+            }
+        });
+
+        add
+        ({
+            "timer_wheel_save_load",
+            [] (std::string & detail)
+            {
+                static const float delays[] = { .2f, .5f, .64f, 3.f, 41.f, 41.f, 700.f, 2700.f };
+
+                Timer_Wheel         original (16);
+                Timer_Wheel::Handle handles[sizeof(delays) / sizeof(delays[0])];
+
+                for (unsigned index = 0; index < sizeof(delays) / sizeof(delays[0]); ++index)
+                {
+                    handles[index] = original.schedule (delays[index], ID(saved), index);
+                }
+
+                // Estado a mitad de un tick y con un nodo liberado en medio de la lista libre:
+
+                original.advance (.123f, [] (Id, uint32_t) { });
+                original.cancel  (handles[2]);
+
+                std::stringstream stream;
+
+                original.save (stream);
+
+                std::string state = stream.str ();
+                Timer_Wheel restored (16);
+
+                std::istringstream input (state);
+
+                if (!restored.load (input)) return fail (detail, "load() no acepta lo que escribe save()");
+
+                Timer_Wheel         other_capacity (15);
+                std::istringstream  other_input    (state);
+                std::istringstream  truncated      (state.substr (0, state.size () - 1));
+
+                if (other_capacity.load (other_input)) return fail (detail, "se ha cargado el estado en una rueda de otra capacidad");
+                if (restored.load (truncated) || restored.get_active_count () != original.get_active_count ())
+                {
+                    return fail (detail, "un estado truncado se ha cargado o ha modificado la rueda");
+                }
+
+                // Los handles siguen valiendo después de cargar:
+
+                if (!original.cancel (handles[4]) || !restored.cancel (handles[4]))
+                {
+                    return fail (detail, "un handle vigente no cancela su temporizador después de cargar");
+                }
+
+                // Las dos ruedas tienen que entregar lo mismo en los mismos ticks:
+
+                std::vector< uint32_t > original_fired;
+                std::vector< uint32_t > restored_fired;
+
+                for (unsigned step = 0; step < 300000 && original.get_active_count () > 0; ++step)
+                {
+                    original.advance (Timer_Wheel::tick_duration, [&] (Id, uint32_t data)
+                    {
+                        original_fired.push_back (original.get_current_tick ());
+                        original_fired.push_back (data);
+                    });
+
+                    restored.advance (Timer_Wheel::tick_duration, [&] (Id, uint32_t data)
+                    {
+                        restored_fired.push_back (restored.get_current_tick ());
+                        restored_fired.push_back (data);
+                    });
+                }
+
+                if (original_fired.size () != 2 * (sizeof(delays) / sizeof(delays[0]) - 2))
+                {
+                    return fail (detail, "han vencido %zu temporizadores en la rueda original", original_fired.size () / 2);
+                }
+
+                if (original_fired != restored_fired) return fail (detail, "la rueda cargada no entrega lo mismo que la original");
+
+                return true;
+            }
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Spatial_Index. Las consultas se comparan con un recorrido de todas las cajas sobre cajas y
+    // consultas aleatorias, con parte de ellas fuera de la rejilla o atravesando sus bordes (que
+    // van a las celdas del borde) y algunos objetos ocultos (que no se insertan). Las cajas se
+    // leen igual que las lee insert(), así que los resultados tienen que coincidir exactamente,
+    // salvo las distancias, que se comparan con un margen porque el índice las calcula en otro
+    // orden. El rayo se recorta a la zona que cubre la rejilla, como hace ray_cast().
+
+    void Self_Test::add_spatial_checks ()
+    {
+        add
+        ({
+            "spatial_index_matches_brute_force",
+            [] (std::string & detail)
+            {
+                static const float    width      = 640.f;
+                static const float    height     = 384.f;
+                static const float    cell_size  = 64.f;
+                static const unsigned box_count  = 400;
+                static const float    tolerance  = 1e-3f;
+
+                struct Box
+                {
+                    GameObject object;
+                    uint32_t   categories;
+                };
+
+                Random_Stream      random (Counter_Random(41), 0, 0);
+                std::vector< Box > boxes;
+                Spatial_Index      index  (width, height, cell_size);
+
+                boxes.reserve (box_count);
+
+                for (unsigned count = 0; count < box_count; ++count)
+                {
+                    boxes.push_back ({ GameObject (Size2f{ random.next_float (2.f, 150.f), random.next_float (2.f, 150.f) }), 1u << (count % 3) });
+
+                    GameObject & object = boxes.back ().object;
+
+                    object.set_anchor   (count % 2 ? basics::CENTER : basics::BOTTOM | basics::LEFT);
+                    object.set_position ({ random.next_float (-200.f, width + 200.f), random.next_float (-200.f, height + 200.f) });
+
+                    if (count % 17 == 0) object.hide ();
+                }
+
+                for (const Box & box : boxes) index.insert (box.object, box.categories);
+
+                index.build ();
+
+                std::vector< const GameObject * > found    (box_count);
+                std::vector< const GameObject * > expected;
+
+                auto same_set = [&] (size_t count)
+                {
+                    found.resize (count);
+
+                    std::sort (found.begin (), found.end ());
+                    std::sort (expected.begin (), expected.end ());
+
+                    bool same = found == expected;
+
+                    found.resize (box_count);
+
+                    return same;
+                };
+
+                for (unsigned query = 0; query < 300; ++query)
+                {
+                    uint32_t categories = query % 4 == 3 ? 7u : 1u << (query % 3);
+                    float    x          = random.next_float (-300.f, width  + 300.f);
+                    float    y          = random.next_float (-300.f, height + 300.f);
+
+                    // Punto:
+
+                    expected.clear ();
+
+                    for (const Box & box : boxes)
+                    {
+                        const GameObject & object = box.object;
+
+                        if (object.is_visible () && (box.categories & categories)
+                            && x > object.get_left_x () && x < object.get_right_x () && y > object.get_bottom_y () && y < object.get_top_y ())
+                        {
+                            expected.push_back (&object);
+                        }
+                    }
+
+                    if (!same_set (index.query_point ({ x, y }, categories, found.data (), box_count)))
+                    {
+                        return fail (detail, "query_point (%.2f, %.2f) con categorías %u no coincide", x, y, categories);
+                    }
+
+                    // Rectángulo:
+
+                    float right = x + random.next_float (0.f, 400.f);
+                    float top   = y + random.next_float (0.f, 300.f);
+
+                    expected.clear ();
+
+                    for (const Box & box : boxes)
+                    {
+                        const GameObject & object = box.object;
+
+                        if (object.is_visible () && (box.categories & categories)
+                            && object.get_left_x () < right && object.get_right_x () > x && object.get_bottom_y () < top && object.get_top_y () > y)
+                        {
+                            expected.push_back (&object);
+                        }
+                    }
+
+                    if (!same_set (index.query_rectangle (x, y, right, top, categories, found.data (), box_count)))
+                    {
+                        return fail (detail, "query_rectangle (%.2f, %.2f, %.2f, %.2f) no coincide", x, y, right, top);
+                    }
+
+                    // Vecinos más cercanos (se comparan las distancias porque puede haber empates):
+
+                    static const size_t neighbours = 5;
+
+                    float              max_distance = query % 5 == 0 ? 80.f : 1e30f;
+                    Spatial_Index::Hit hits[neighbours];
+                    std::vector< float > distances;
+
+                    for (const Box & box : boxes)
+                    {
+                        const GameObject & object = box.object;
+
+                        if (!object.is_visible () || !(box.categories & categories)) continue;
+
+                        float dx       = std::max (std::max (object.get_left_x   () - x, x - object.get_right_x ()), 0.f);
+                        float dy       = std::max (std::max (object.get_bottom_y () - y, y - object.get_top_y   ()), 0.f);
+                        float distance = std::sqrt (dx * dx + dy * dy);
+
+                        if (distance <= max_distance) distances.push_back (distance);
+                    }
+
+                    std::sort (distances.begin (), distances.end ());
+
+                    size_t count = index.query_nearest ({ x, y }, categories, hits, neighbours, max_distance);
+
+                    if (count != std::min (neighbours, distances.size ()))
+                    {
+                        return fail (detail, "query_nearest (%.2f, %.2f) ha encontrado %zu vecinos en lugar de %zu", x, y, count, std::min (neighbours, distances.size ()));
+                    }
+
+                    for (size_t hit = 0; hit < count; ++hit)
+                    {
+                        if (std::fabs (hits[hit].distance - distances[hit]) > tolerance)
+                        {
+                            return fail (detail, "query_nearest (%.2f, %.2f): vecino %zu a %.4f en lugar de %.4f", x, y, hit, hits[hit].distance, distances[hit]);
+                        }
+                    }
+
+                    // Rayo (recortado a la rejilla):
+
+                    float angle      = random.next_float (0.f, 6.2831853f);
+                    float dx         = std::cos (angle);
+                    float dy         = std::sin (angle);
+                    float max_length = query % 3 == 0 ? 200.f : 2000.f;
+                    float nearest    = std::numeric_limits< float >::infinity ();
+
+                    auto slab = [&] (float left, float bottom, float right, float top, float & entering, float & leaving)
+                    {
+                        float tx0 = (left   - x) / dx, tx1 = (right - x) / dx;
+                        float ty0 = (bottom - y) / dy, ty1 = (top   - y) / dy;
+
+                        entering = std::max ({ entering, std::min (tx0, tx1), std::min (ty0, ty1) });
+                        leaving  = std::min ({ leaving,  std::max (tx0, tx1), std::max (ty0, ty1) });
+
+                        return entering <= leaving;
+                    };
+
+                    float start = 0.f, end = max_length;
+
+                    if (slab (0.f, 0.f, width, height, start, end))
+                    {
+                        for (const Box & box : boxes)
+                        {
+                            const GameObject & object = box.object;
+
+                            if (!object.is_visible () || !(box.categories & categories)) continue;
+
+                            float entering = start, leaving = end;
+
+                            if (slab (object.get_left_x (), object.get_bottom_y (), object.get_right_x (), object.get_top_y (), entering, leaving))
+                            {
+                                nearest = std::min (nearest, entering);
+                            }
+                        }
+                    }
+
+                    Spatial_Index::Hit hit;
+
+                    bool hit_found = index.ray_cast ({ x, y }, { dx, dy }, max_length, categories, hit);
+
+                    if (hit_found != (nearest < std::numeric_limits< float >::infinity ()) || (hit_found && std::fabs (hit.distance - nearest) > tolerance))
+                    {
+                        return fail (detail, "ray_cast desde (%.2f, %.2f) con ángulo %.4f: %.4f en lugar de %.4f", x, y, angle, hit_found ? hit.distance : -1.f, nearest);
+                    }
+                }
+
+                return true;
+            }
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Wave_Timeline. Se codifica una lista de eventos aleatorios (con varios en el mismo
+    // milisegundo y saltos largos que necesitan varints de varios bytes), se escribe en un fichero
+    // y se lee con un Cursor que avanza con pasos irregulares (de cero a varios segundos). Cada
+    // evento tiene que llegar una sola vez, en orden, en el paso en el que vence y con los valores
+    // redondeados como indica encode(). Después, el mismo fichero cortado por cualquier punto tiene
+    // que dar un prefijo de esos eventos y terminar la línea de tiempo sin leer fuera.
+
+    static bool write_file (const char * path, const std::vector< uint8_t > & data, size_t size)
+    {
+        std::ofstream file (path, std::ios::binary | std::ios::trunc);
+
+        return bool(file.write (reinterpret_cast< const char * >(data.data ()), std::streamsize(size)));
+    }
+
+    void Self_Test::add_wave_checks ()
+    {
+        add
+        ({
+            "wave_timeline_round_trip",
+            [] (std::string & detail)
+            {
+                typedef Wave_Timeline::Event Event;
+
+                const char * path = "sinkthemall_self_test.swtl";
+
+                Random_Stream        random (Counter_Random(47), 0, 0);
+                std::vector< Event > events;
+                float                time   = 0.f;
+
+                for (unsigned count = 0; count < 600; ++count)
+                {
+                    unsigned choice = count % 10;
+
+                    time += choice == 0 ? 0.f : choice == 9 ? random.next_float (20.f, 400.f) : random.next_float (0.f, .5f);
+
+                    Event event;
+
+                    event.time      = time;
+                    event.kind      = count % 3 == 0 ? Wave_Timeline::FIRE : Wave_Timeline::SPAWN;
+                    event.submarine = count % 7 == 0 && event.kind == Wave_Timeline::FIRE ? Wave_Timeline::any_submarine : unsigned(random.next_float (0.f, 1000.f));
+                    event.y         = random.next_float (0.f, 720.f);
+                    event.speed     = random.next_float (-300.f, 300.f);
+                    event.volley    = unsigned(random.next_float (1.f, 20.f));
+
+                    events.push_back (event);
+                }
+
+                std::vector< uint8_t > data = Wave_Timeline::encode (events);
+
+                // Lo que debe llegar de cada evento según encode():
+
+                std::vector< Event > expected;
+
+                for (const Event & event : events)
+                {
+                    Event decoded {};
+
+                    decoded.time      = uint32_t(std::lround (event.time * 1000.f)) * .001f;
+                    decoded.kind      = event.kind;
+                    decoded.submarine = event.submarine;
+
+                    if (event.kind == Wave_Timeline::SPAWN)
+                    {
+                        decoded.y     = float(std::lround (event.y));
+                        decoded.speed = float(std::lround (event.speed));
+                    }
+                    else
+                    {
+                        decoded.volley = event.volley;
+                    }
+
+                    expected.push_back (decoded);
+                }
+
+                auto same_event = [] (const Event & a, const Event & b)
+                {
+                    return a.time == b.time && a.kind == b.kind && a.submarine == b.submarine && a.y == b.y && a.speed == b.speed && a.volley == b.volley;
+                };
+
+                // Lectura completa con pasos irregulares:
+
+                Wave_Timeline timeline;
+
+                bool written = write_file (path, data, data.size ());
+                bool opened  = written && timeline.open (path);
+
+                if (!opened)
+                {
+                    std::remove (path);
+                    return fail (detail, "no se ha podido escribir o abrir %s", path);
+                }
+
+                if (timeline.get_event_count () != events.size ())
+                {
+                    return fail (detail, "la cabecera indica %u eventos en lugar de %zu", timeline.get_event_count (), events.size ());
+                }
+
+                Wave_Timeline::Cursor cursor (timeline);
+                size_t                received = 0;
+                bool                  wrong    = false;
+                unsigned              steps    = 0;
+
+                while (!cursor.is_finished () && steps < 1000000 && !wrong)
+                {
+                    unsigned choice = steps++ % 8;
+                    float    step   = choice == 0 ? 0.f : choice == 7 ? random.next_float (1.f, 30.f) : random.next_float (0.f, .05f);
+                    float    before = cursor.get_elapsed ();
+
+                    cursor.advance (step, [&] (const Event & event)
+                    {
+                        // Tiene que ser el siguiente y vencer en este paso, no en uno anterior:
+
+                        wrong = wrong || received >= expected.size () || !same_event (event, expected[received])
+                                      || event.time > cursor.get_elapsed () + .0005f || (received > 0 && event.time <= before - .0005f && step > 0.f);
+
+                        received++;
+                    });
+                }
+
+                if (wrong)
+                {
+                    return fail (detail, "el evento %zu llega cambiado, fuera de orden o en otro paso", received - 1);
+                }
+
+                if (received != expected.size ())
+                {
+                    return fail (detail, "han llegado %zu eventos de %zu", received, expected.size ());
+                }
+
+                // Fichero cortado en distintos puntos (sin cabecera completa no se debe poder abrir):
+
+                for (size_t size = 0; size < data.size (); size += size < Wave_Timeline::header_size + 64 ? 1 : 13)
+                {
+                    Wave_Timeline truncated;
+
+                    if (!write_file (path, data, size)) break;
+
+                    bool open = truncated.open (path);
+
+                    if (open != (size >= Wave_Timeline::header_size))
+                    {
+                        std::remove (path);
+                        return fail (detail, "un fichero de %zu bytes %s abrir", size, open ? "se ha podido" : "no se ha podido");
+                    }
+
+                    if (!open) continue;
+
+                    Wave_Timeline::Cursor truncated_cursor (truncated);
+                    size_t                decoded = 0;
+                    bool                  prefix  = true;
+
+                    truncated_cursor.advance (1e7f, [&] (const Event & event)
+                    {
+                        prefix = prefix && decoded < expected.size () && same_event (event, expected[decoded]);
+
+                        decoded++;
+                    });
+
+                    if (!prefix || !truncated_cursor.is_finished () || decoded >= expected.size ())
+                    {
+                        std::remove (path);
+                        return fail (detail, "cortado a %zu bytes da %zu eventos%s", size, decoded, prefix ? " y no termina" : " que no coinciden");
+                    }
+                }
+
+                std::remove (path);
+
+                return true;
+            }
+        });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Resource_Cache con sustitutos de Texture_2D y del contexto gráfico que no necesitan GPU (una
+    // ruta vacía hace que la carga falle). Game_Scene::load_textures() toma sus texturas con
+    // acquire_next() y se salta la espera de la pantalla de carga si este deja resident a true, así
+    // que se comprueba que eso ocurre cuando la escena anterior ha precargado el manifiesto con
+    // preload() y preload_step() (como hace Game_Scene::preload_assets()) y no en caso contrario.
+
+    struct Stub_Texture;
+
+    struct Stub_Graphics
+    {
+        unsigned created;                               ///< Texturas "leídas de disco".
+        unsigned added;                                 ///< Texturas añadidas al contexto.
+
+        void add (const std::shared_ptr< Stub_Texture > & )
+        {
+            added++;
+        }
+    };
+
+    struct Stub_Context
+    {
+        Stub_Graphics * graphics;
+
+        Stub_Graphics * operator -> () const
+        {
+            return graphics;
+        }
+    };
+
+    struct Stub_Texture
+    {
+        static std::shared_ptr< Stub_Texture > create (Id , Stub_Context & context, const char * path)
+        {
+            if (*path == 0) return nullptr;
+
+            context->created++;
+
+            return std::make_shared< Stub_Texture > ();
+        }
+
+        float get_width  () const { return 4.f; }
+        float get_height () const { return 4.f; }
+    };
+
+    typedef Basic_Resource_Cache< Stub_Texture, Stub_Context > Stub_Cache;
+
+    static constexpr Asset_Data stub_assets[] =
+    {
+        { ID(stub_background), "background.png", 4.f, 4.f },
+        { ID(stub_ship      ), "ship.png",       4.f, 4.f },
+        { ID(stub_submarine ), "submarine.png",  4.f, 4.f },
+        { ID(stub_bullet    ), "bullet.png",     4.f, 4.f },
+    };
+
+    void Self_Test::add_resource_checks ()
+    {
+        add
+        ({
+            "resource_cache_preload_skips_loading_delay",
+            [] (std::string & detail)
+            {
+                const auto manifest = make_asset_manifest (stub_assets);
+                const unsigned count = manifest.size ();
+
+                // Sin precarga se carga una textura por fotograma y la escena tiene que esperar:
+
+                {
+                    Stub_Graphics                                 graphics {};
+                    Stub_Context                                  context  { &graphics };
+                    Stub_Cache                                    cache;
+                    std::array< Stub_Cache::Texture_Handle, 4 >   handles;
+                    unsigned                                      loaded   = 0;
+                    unsigned                                      frames   = 0;
+                    bool                                          resident = true;
+
+                    while (loaded < count && frames < 2 * count)
+                    {
+                        if (!cache.acquire_next (manifest, loaded, handles, context, resident)) break;
+
+                        frames++;
+                    }
+
+                    if (loaded != count || frames != count || resident || graphics.created != count)
+                    {
+                        return fail (detail, "sin precarga: %u texturas en %u fotogramas, %u leídas, resident %d", loaded, frames, graphics.created, int(resident));
+                    }
+                }
+
+                // Con el manifiesto precargado se toman todas en el mismo fotograma sin leer nada:
+
+                Stub_Graphics                                 graphics {};
+                Stub_Context                                  context  { &graphics };
+                Stub_Cache                                    cache;
+                std::array< Stub_Cache::Texture_Handle, 4 >   handles;
+                unsigned                                      loaded   = 0;
+                bool                                          resident = true;
+
+                cache.preload (manifest);
+                cache.preload (manifest);
+
+                if (cache.get_statistics ().pending != count)
+                {
+                    return fail (detail, "se han encolado %u texturas de %u", cache.get_statistics ().pending, count);
+                }
+
+                for (unsigned step = 0; step < count && cache.preload_step (context, 0.f); ++step);
+
+                Stub_Cache::Statistics preloaded = cache.get_statistics ();
+
+                if (preloaded.pending != 0 || preloaded.resident != count || graphics.created != count)
+                {
+                    return fail (detail, "la precarga deja %u pendientes y %u residentes", preloaded.pending, preloaded.resident);
+                }
+
+                bool acquired = cache.acquire_next (manifest, loaded, handles, context, resident);
+
+                if (!acquired || loaded != count || !resident || graphics.created != count || graphics.added != count)
+                {
+                    return fail (detail, "con precarga: %u texturas en un fotograma, %u leídas, resident %d", loaded, graphics.created, int(resident));
+                }
+
+                for (unsigned index = 0; index < count; ++index)
+                {
+                    if (handles[manifest.index_of (stub_assets[index].id)] != cache.find (stub_assets[index].id))
+                    {
+                        return fail (detail, "la textura %u no es la que retiene la caché", index);
+                    }
+                }
+
+                // Una textura que no se puede cargar detiene la carga y se queda en nullptr:
+
+                static constexpr Asset_Data broken_assets[] =
+                {
+                    { ID(stub_background), "background.png", 4.f, 4.f },
+                    { ID(stub_broken    ), "",               4.f, 4.f },
+                };
+
+                const auto                                  broken = make_asset_manifest (broken_assets);
+                std::array< Stub_Cache::Texture_Handle, 2 > broken_handles;
+                unsigned                                    broken_loaded = 0;
+
+                if (cache.acquire_next (broken, broken_loaded, broken_handles, context, resident) || broken_loaded != 1 || broken_handles[broken.index_of (ID(stub_broken))])
+                {
+                    return fail (detail, "una textura que no se puede cargar no detiene la carga");
+                }
+
+                return true;
+            }
+        });
+    }
+
+}
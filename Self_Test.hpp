@@ -0,0 +1,82 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef SELF_TEST_HEADER
+#define SELF_TEST_HEADER
+
+    #include <string>
+    #include <vector>
+    #include <functional>
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Comprobaciones de corrección de los subsistemas que no dependen de un contexto gráfico
+         * (valores de referencia, equivalencia entre las rutas SIMD y escalares, estadística).
+         * Son deterministas: usan semillas y datos fijos, así que un fallo siempre se repite.
+         */
+        class Self_Test
+        {
+        public:
+
+            struct Result
+            {
+                std::string name;
+                bool        passed;
+                std::string detail;                     ///< Qué ha fallado (vacío si ha pasado).
+            };
+
+            typedef std::vector< Result > Results;
+
+            /**
+             * Una comprobación devuelve false y describe el fallo en 'detail' si no se cumple.
+             */
+            struct Check
+            {
+                std::string                                   name;
+                std::function< bool (std::string & detail) >  run;
+            };
+
+        private:
+
+            std::vector< Check > checks;
+
+        public:
+
+            /**
+             * Crea la batería con todas las comprobaciones del juego.
+             */
+            Self_Test();
+
+            void add (Check check)
+            {
+                checks.push_back (std::move (check));
+            }
+
+            Results run () const;
+
+        private:
+
+            void add_random_checks     ();
+            void add_fixed_checks      ();
+            void add_texture_checks    ();
+            void add_resolution_checks ();
+            void add_timer_checks      ();
+            void add_spatial_checks    ();
+            void add_wave_checks       ();
+            void add_resource_checks   ();
+
+        };
+
+    }
+
+#endif
@@ -0,0 +1,493 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Software_Canvas.hpp"
+
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SOFTWARE_CANVAS_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define SOFTWARE_CANVAS_USE_NEON
+#endif
+
+using namespace basics;
+
+namespace jesus_villar_examen
+{
+
+    // ---------------------------------------------------------------------------------------------
+    // Funciones auxiliares para rellenar tramos horizontales (spans) del framebuffer. La mezcla es
+    // dst = (src * a + dst * (255 - a)) / 255 por canal, redondeando, igual en SIMD y en escalar
+    // para que el resultado no dependa de la plataforma.
+
+    static inline uint32_t pack_color (float red, float green, float blue)
+    {
+        return  uint32_t(std::min (std::max (red,   0.f), 1.f) * 255.f + .5f)
+             | (uint32_t(std::min (std::max (green, 0.f), 1.f) * 255.f + .5f) <<  8)
+             | (uint32_t(std::min (std::max (blue,  0.f), 1.f) * 255.f + .5f) << 16)
+             | 0xFF000000u;
+    }
+
+    static inline uint32_t blend_pixel (uint32_t source, uint32_t destination)
+    {
+        uint32_t alpha   = source >> 24;
+        uint32_t inverse = 255 - alpha;
+        uint32_t result  = 0;
+
+        for (unsigned shift = 0; shift < 32; shift += 8)
+        {
+            uint32_t value = ((source >> shift) & 0xFF) * alpha + ((destination >> shift) & 0xFF) * inverse + 128;
+
+            result |= (((value + (value >> 8)) >> 8) & 0xFF) << shift;
+        }
+
+        return result;
+    }
+
+    static void fill_span (uint32_t * row, unsigned count, uint32_t color)
+    {
+        unsigned index = 0;
+
+        #if defined(SOFTWARE_CANVAS_USE_SSE2)
+
+            const __m128i value = _mm_set1_epi32 (int(color));
+
+            for ( ; index + 4 <= count; index += 4)
+            {
+                _mm_storeu_si128 (reinterpret_cast< __m128i * >(row + index), value);
+            }
+
+        #elif defined(SOFTWARE_CANVAS_USE_NEON)
+
+            const uint32x4_t value = vdupq_n_u32 (color);
+
+            for ( ; index + 4 <= count; index += 4)
+            {
+                vst1q_u32 (row + index, value);
+            }
+
+        #endif
+
+        for ( ; index < count; ++index)
+        {
+            row[index] = color;
+        }
+    }
+
+    #if defined(SOFTWARE_CANVAS_USE_SSE2)
+
+        static inline __m128i blend_4_pixels (__m128i source, __m128i destination)
+        {
+            const __m128i zero       = _mm_setzero_si128 ();
+            const __m128i full       = _mm_set1_epi16 (255);
+            const __m128i half       = _mm_set1_epi16 (128);
+
+            __m128i source_low       = _mm_unpacklo_epi8 (source,      zero);
+            __m128i source_high      = _mm_unpackhi_epi8 (source,      zero);
+            __m128i destination_low  = _mm_unpacklo_epi8 (destination, zero);
+            __m128i destination_high = _mm_unpackhi_epi8 (destination, zero);
+
+            // Se replica el alfa de cada píxel en sus cuatro canales:
+
+            __m128i alpha_low  = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (source_low,  _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            __m128i alpha_high = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (source_high, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+            __m128i low  = _mm_add_epi16 (_mm_mullo_epi16 (source_low,  alpha_low ), _mm_mullo_epi16 (destination_low,  _mm_sub_epi16 (full, alpha_low )));
+            __m128i high = _mm_add_epi16 (_mm_mullo_epi16 (source_high, alpha_high), _mm_mullo_epi16 (destination_high, _mm_sub_epi16 (full, alpha_high)));
+
+            low  = _mm_add_epi16 (low,  half);
+            high = _mm_add_epi16 (high, half);
+            low  = _mm_srli_epi16 (_mm_add_epi16 (low,  _mm_srli_epi16 (low,  8)), 8);
+            high = _mm_srli_epi16 (_mm_add_epi16 (high, _mm_srli_epi16 (high, 8)), 8);
+
+            return _mm_packus_epi16 (low, high);
+        }
+
+    #endif
+
+    // Rellena un span con los texels de una fila de la textura. 'u' y 'step' están en coma fija
+    // 16.16 (muestreo por vecino más cercano).
+
+    static void blend_span (uint32_t * row, unsigned count, const uint32_t * texels, uint32_t texel_count, uint32_t u, uint32_t step)
+    {
+        const uint32_t last = texel_count - 1;
+
+        unsigned index = 0;
+
+        #if defined(SOFTWARE_CANVAS_USE_SSE2)
+
+            const __m128i alpha_mask = _mm_set1_epi32 (int(0xFF000000u));
+
+            for ( ; index + 4 <= count; index += 4)
+            {
+                uint32_t gathered[4];
+
+                for (unsigned lane = 0; lane < 4; ++lane, u += step)
+                {
+                    gathered[lane] = texels[std::min (u >> 16, last)];
+                }
+
+                __m128i source = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(gathered));
+                __m128i alpha  = _mm_and_si128   (source, alpha_mask);
+
+                if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (alpha, alpha_mask)) == 0xFFFF)
+                {
+                    _mm_storeu_si128 (reinterpret_cast< __m128i * >(row + index), source);              // Los 4 son opacos
+                }
+                else if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (alpha, _mm_setzero_si128 ())) != 0xFFFF)
+                {
+                    __m128i destination = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(row + index));
+
+                    _mm_storeu_si128 (reinterpret_cast< __m128i * >(row + index), blend_4_pixels (source, destination));
+                }
+            }
+
+        #elif defined(SOFTWARE_CANVAS_USE_NEON)
+
+            for ( ; index + 8 <= count; index += 8)
+            {
+                uint32_t gathered[8];
+
+                for (unsigned lane = 0; lane < 8; ++lane, u += step)
+                {
+                    gathered[lane] = texels[std::min (u >> 16, last)];
+                }
+
+                uint8x8x4_t source      = vld4_u8 (reinterpret_cast< const uint8_t * >(gathered));
+                uint8x8x4_t destination = vld4_u8 (reinterpret_cast< const uint8_t * >(row + index));
+                uint8x8_t   alpha       = source.val[3];
+                uint8x8_t   inverse     = vmvn_u8 (alpha);
+                uint8x8x4_t result;
+
+                for (unsigned channel = 0; channel < 4; ++channel)
+                {
+                    uint16x8_t value = vmlal_u8 (vmull_u8 (source.val[channel], alpha), destination.val[channel], inverse);
+
+                    result.val[channel] = vraddhn_u16 (value, vrshrq_n_u16 (value, 8));
+                }
+
+                vst4_u8 (reinterpret_cast< uint8_t * >(row + index), result);
+            }
+
+        #endif
+
+        for ( ; index < count; ++index, u += step)
+        {
+            row[index] = blend_pixel (texels[std::min (u >> 16, last)], row[index]);
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Software_Canvas::Software_Canvas(unsigned width, unsigned height)
+    :
+        virtual_width  (width),
+        virtual_height (height),
+        render_scale   (1.f),
+        clear_color    (0xFF000000u),
+        pixels_filled  (0),
+        render_seconds (0.f),
+        buffer_memory  (MEMORY_RENDER_BUFFERS),
+        texture_memory (MEMORY_TEXTURES_CPU)
+    {
+        framebuffer.width  = width;
+        framebuffer.height = height;
+        framebuffer.pixels.resize (size_t(width) * height);
+
+        update_memory ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Software_Canvas::set_clear_color (float red, float green, float blue)
+    {
+        clear_color = pack_color (red, green, blue);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Software_Canvas::set_texture_image (Id texture_id, Image image)
+    {
+        if (image.width > 0 && image.height > 0 && image.pixels.size () == size_t(image.width) * image.height)
+        {
+            texture_images[texture_id] = std::move (image);
+
+            update_memory ();
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Software_Canvas::set_render_scale (float scale)
+    {
+        render_scale = std::min (std::max (scale, .01f), 1.f);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Software_Canvas::clear ()
+    {
+        unsigned width  = std::max (unsigned(virtual_width  * render_scale + .5f), 1u);
+        unsigned height = std::max (unsigned(virtual_height * render_scale + .5f), 1u);
+
+        if (width != framebuffer.width || height != framebuffer.height)
+        {
+            framebuffer.width  = width;
+            framebuffer.height = height;
+            framebuffer.pixels.resize (size_t(width) * height);
+
+            update_memory ();
+        }
+
+        pixels_filled  = 0;
+        render_seconds = 0.f;
+
+        fill_span (framebuffer.pixels.data (), unsigned(framebuffer.pixels.size ()), clear_color);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Software_Canvas::render (const Render_Snapshot & snapshot, size_t skipped_command)
+    {
+        auto start = std::chrono::steady_clock::now ();
+
+        for (size_t index = 0; index < snapshot.commands.size (); ++index)
+        {
+            if (index != skipped_command) pixels_filled += fill_rectangle (snapshot.commands[index]);
+        }
+
+        render_seconds += std::chrono::duration< float >(std::chrono::steady_clock::now () - start).count ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Se rellenan los píxeles cuyo centro cae dentro del rectángulo. El anchor se interpreta igual
+    // que en GameObject (bits 0-1 horizontal y 2-3 vertical).
+
+    uint64_t Software_Canvas::fill_rectangle (const Render_Command & command)
+    {
+        // Se pasa de coordenadas virtuales a píxeles del framebuffer (que puede estar escalado):
+
+        float scale_x = float(framebuffer.width ) / virtual_width;
+        float scale_y = float(framebuffer.height) / virtual_height;
+        float width   = command.width  * scale_x;
+        float height  = command.height * scale_y;
+        float x       = command.x      * scale_x;
+        float y       = command.y      * scale_y;
+
+        float left   = (command.anchor & 0x3) == LEFT   ? x : (command.anchor & 0x3) == RIGHT ? x - width  : x - width  * .5f;
+        float bottom = (command.anchor & 0xC) == BOTTOM ? y : (command.anchor & 0xC) == TOP   ? y - height : y - height * .5f;
+
+        if (width <= 0.f || height <= 0.f) return 0;
+
+        int x0 = std::max (int(std::ceil (left - .5f)), 0);
+        int y0 = std::max (int(std::ceil (bottom - .5f)), 0);
+        int x1 = std::min (int(std::ceil (left   + width  - .5f)), int(framebuffer.width ));
+        int y1 = std::min (int(std::ceil (bottom + height - .5f)), int(framebuffer.height));
+
+        if (x0 >= x1 || y0 >= y1) return 0;
+
+        unsigned span = unsigned(x1 - x0);
+
+        auto image = texture_images.find (command.texture_id);
+
+        if (image == texture_images.end ())
+        {
+            uint32_t color = pack_color (command.red, command.green, command.blue);
+
+            for (int y = y0; y < y1; ++y)
+            {
+                fill_span (&framebuffer.pixels[size_t(y) * framebuffer.width + x0], span, color);
+            }
+        }
+        else
+        {
+            // Se muestrea solo la región UV del comando (por ejemplo, un fotograma de un atlas):
+
+            const Image & texture = image->second;
+
+            float    region_left        = command.uv.u0 * texture.width;
+            float    region_bottom      = command.uv.v0 * texture.height;
+            float    texels_per_pixel_x = (command.uv.u1 - command.uv.u0) * texture.width  / width;
+            float    texels_per_pixel_y = (command.uv.v1 - command.uv.v0) * texture.height / height;
+            uint32_t u0                 = uint32_t((region_left + (x0 + .5f - left) * texels_per_pixel_x) * 65536.f);
+            uint32_t step               = uint32_t(texels_per_pixel_x * 65536.f);
+
+            for (int y = y0; y < y1; ++y)
+            {
+                unsigned v = std::min (unsigned(region_bottom + (y + .5f - bottom) * texels_per_pixel_y), texture.height - 1);
+
+                blend_span
+                (
+                    &framebuffer.pixels[size_t(y) * framebuffer.width + x0], span,
+                    &texture.pixels[size_t(v) * texture.width], texture.width,
+                    u0, step
+                );
+            }
+        }
+
+        return uint64_t(span) * unsigned(y1 - y0);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Ampliación al vecino más cercano: cada fila de salida se genera una sola vez por fila de
+    // origen y las siguientes que salen de la misma se copian de ella. Con la proporción exacta de
+    // 2 (escala 0.5) cada píxel se duplica con SIMD; con cualquier otra se leen las columnas de
+    // origen precalculadas.
+
+    static void double_row (uint32_t * target, const uint32_t * source, unsigned source_width)
+    {
+        unsigned x = 0;
+
+        #if defined(SOFTWARE_CANVAS_USE_SSE2)
+
+            for ( ; x + 4 <= source_width; x += 4)
+            {
+                __m128i pixels = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(source + x));
+
+                _mm_storeu_si128 (reinterpret_cast< __m128i * >(target + x * 2    ), _mm_unpacklo_epi32 (pixels, pixels));
+                _mm_storeu_si128 (reinterpret_cast< __m128i * >(target + x * 2 + 4), _mm_unpackhi_epi32 (pixels, pixels));
+            }
+
+        #elif defined(SOFTWARE_CANVAS_USE_NEON)
+
+            for ( ; x + 4 <= source_width; x += 4)
+            {
+                uint32x4_t   pixels  = vld1q_u32 (source + x);
+                uint32x4x2_t doubled = vzipq_u32 (pixels, pixels);
+
+                vst1q_u32 (target + x * 2,     doubled.val[0]);
+                vst1q_u32 (target + x * 2 + 4, doubled.val[1]);
+            }
+
+        #endif
+
+        for ( ; x < source_width; ++x)
+        {
+            target[x * 2] = target[x * 2 + 1] = source[x];
+        }
+    }
+
+    void Software_Canvas::resolve ()
+    {
+        if (!is_scaled ()) return;
+
+        output.width  = virtual_width;
+        output.height = virtual_height;
+        if (output.pixels.size () != size_t(virtual_width) * virtual_height)
+        {
+            output.pixels.resize (size_t(virtual_width) * virtual_height);
+
+            update_memory ();
+        }
+
+        auto nearest = [] (unsigned index, unsigned source_size, unsigned target_size) -> unsigned
+        {
+            return std::min (unsigned((uint64_t(index) * 2 + 1) * source_size / (uint64_t(target_size) * 2)), source_size - 1);
+        };
+
+        const bool doubled = framebuffer.width * 2 == virtual_width;
+
+        std::vector< unsigned > columns(doubled ? 0 : virtual_width);
+
+        for (unsigned x = 0; x < columns.size (); ++x) columns[x] = nearest (x, framebuffer.width, virtual_width);
+
+        unsigned last_row = ~0u;
+
+        for (unsigned y = 0; y < virtual_height; ++y)
+        {
+            unsigned   row    = nearest (y, framebuffer.height, virtual_height);
+            uint32_t * target = &output.pixels[size_t(y) * virtual_width];
+
+            if (row == last_row)
+            {
+                std::copy (target - virtual_width, target, target);
+                continue;
+            }
+
+            const uint32_t * source = &framebuffer.pixels[size_t(row) * framebuffer.width];
+
+            if (doubled)
+            {
+                double_row (target, source, framebuffer.width);
+            }
+            else for (unsigned x = 0; x < virtual_width; ++x)
+            {
+                target[x] = source[columns[x]];
+            }
+
+            last_row = row;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Software_Canvas::update_memory ()
+    {
+        size_t texture_bytes = 0;
+
+        for (const auto & texture_image : texture_images)
+        {
+            texture_bytes += texture_image.second.pixels.capacity () * sizeof(uint32_t);
+        }
+
+        buffer_memory .set_bytes ((framebuffer.pixels.capacity () + output.pixels.capacity ()) * sizeof(uint32_t));
+        texture_memory.set_bytes (texture_bytes);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // TGA sin comprimir de 32 bits con el origen abajo a la izquierda, que coincide con el orden de
+    // filas del framebuffer. TGA guarda los canales como BGRA.
+
+    bool Software_Canvas::save_tga (const std::string & path) const
+    {
+        std::ofstream file (path, std::ios::binary);
+
+        if (!file) return false;
+
+        const Image & image = get_framebuffer ();
+
+        const uint8_t header[18] =
+        {
+            0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            uint8_t(image.width  & 0xFF), uint8_t(image.width  >> 8),
+            uint8_t(image.height & 0xFF), uint8_t(image.height >> 8),
+            32, 8
+        };
+
+        file.write (reinterpret_cast< const char * >(header), sizeof(header));
+
+        std::vector< uint8_t > row(image.width * 4);
+
+        for (unsigned y = 0; y < image.height; ++y)
+        {
+            const uint32_t * pixels = &image.pixels[size_t(y) * image.width];
+
+            for (unsigned x = 0; x < image.width; ++x)
+            {
+                row[x * 4 + 0] = uint8_t(pixels[x] >> 16);
+                row[x * 4 + 1] = uint8_t(pixels[x] >>  8);
+                row[x * 4 + 2] = uint8_t(pixels[x]      );
+                row[x * 4 + 3] = uint8_t(pixels[x] >> 24);
+            }
+
+            file.write (reinterpret_cast< const char * >(row.data ()), row.size ());
+        }
+
+        return bool(file);
+    }
+
+}
@@ -0,0 +1,154 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef SOFTWARE_CANVAS_HEADER
+#define SOFTWARE_CANVAS_HEADER
+
+    #include <map>
+    #include <string>
+    #include <vector>
+    #include <cstdint>
+
+    #include "Render_Snapshot.hpp"
+    #include "Memory_Tracker.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Canvas que rasteriza en memoria (sin GPU) los comandos de un Render_Snapshot. Dibuja
+         * rectángulos de color liso o con textura y mezcla alfa, procesando los tramos horizontales
+         * de varios píxeles a la vez con SIMD (SSE2 o NEON según la plataforma). Sirve para ejecutar
+         * y medir el render en máquinas sin GPU y para volcar fotogramas a fichero.
+         *
+         * Los comandos se dan en coordenadas virtuales, pero se pueden rasterizar a una fracción de
+         * esa resolución (set_render_scale()) y escalar después el resultado con resolve().
+         */
+        class Software_Canvas
+        {
+        public:
+
+            /**
+             * Imagen RGBA de 8 bits por canal (R en el byte de menor peso). La fila 0 es la inferior.
+             */
+            struct Image
+            {
+                unsigned                width;
+                unsigned                height;
+                std::vector< uint32_t > pixels;
+            };
+
+        private:
+
+            Image                                       framebuffer;        ///< Destino del render, a la resolución escalada.
+            Image                                       output;             ///< framebuffer escalado a la resolución virtual (si la escala no es 1).
+            unsigned                                    virtual_width;
+            unsigned                                    virtual_height;
+            float                                       render_scale;
+            uint32_t                                    clear_color;
+            std::map< Id, Image >                       texture_images;     ///< Copia en CPU de las texturas que se quieren dibujar (por Id del manifiesto).
+
+            uint64_t                                    pixels_filled;      ///< Píxeles escritos desde el último clear().
+            float                                       render_seconds;     ///< Tiempo dibujando desde el último clear().
+
+            Memory_Counter                              buffer_memory;      ///< Bytes de framebuffer y output (MEMORY_RENDER_BUFFERS).
+            Memory_Counter                              texture_memory;     ///< Bytes de texture_images (MEMORY_TEXTURES_CPU).
+
+        public:
+
+            /**
+             * @param width  Ancho del framebuffer en píxeles (coincide con el ancho virtual de la escena).
+             * @param height Alto  del framebuffer en píxeles (coincide con el alto  virtual de la escena).
+             */
+            Software_Canvas(unsigned width, unsigned height);
+
+        public:
+
+            /**
+             * Imagen final a la resolución virtual (la de resolve() si se dibuja a escala).
+             */
+            const Image & get_framebuffer () const { return is_scaled () ? output : framebuffer; }
+            unsigned      get_width       () const { return virtual_width;    }
+            unsigned      get_height      () const { return virtual_height;   }
+            float         get_render_scale() const { return render_scale;     }
+
+            bool is_scaled () const
+            {
+                return framebuffer.width != virtual_width || framebuffer.height != virtual_height;
+            }
+
+            /**
+             * Tasa de relleno de los render() desde el último clear() en megapíxeles por segundo.
+             */
+            float get_megapixels_per_second () const
+            {
+                return render_seconds > 0.f ? float(pixels_filled) / render_seconds * 1e-6f : 0.f;
+            }
+
+            uint64_t get_pixels_filled  () const { return pixels_filled;  }
+            float    get_render_seconds () const { return render_seconds; }
+
+        public:
+
+            void set_clear_color (float red, float green, float blue);
+
+            /**
+             * Cambia la fracción de la resolución virtual a la que se rasteriza. Se aplica desde el
+             * siguiente clear().
+             */
+            void set_render_scale (float scale);
+
+            /**
+             * Registra los píxeles con los que se dibujan los comandos cuyo texture_id es 'texture_id'.
+             * Los comandos cuya textura no tiene imagen registrada se dibujan con su color liso.
+             */
+            void set_texture_image (Id texture_id, Image image);
+
+            /**
+             * Rellena todo el framebuffer con el color de borrado y empieza a medir un nuevo fotograma.
+             */
+            void clear ();
+
+            /**
+             * Dibuja todos los comandos del snapshot en orden y acumula la tasa de relleno.
+             * @param skipped_command Índice de un comando que no se debe dibujar o no_command.
+             */
+            void render (const Render_Snapshot & snapshot, size_t skipped_command = Render_Snapshot::no_command);
+
+            /**
+             * Si se dibuja a escala, amplía el framebuffer a la resolución virtual tomando el píxel
+             * más cercano (a escala 1 no hace nada). Se llama una vez terminado el fotograma.
+             */
+            void resolve ();
+
+            /**
+             * Guarda el framebuffer como imagen TGA de 32 bits sin comprimir.
+             * @return false si no se ha podido escribir el fichero.
+             */
+            bool save_tga (const std::string & path) const;
+
+        private:
+
+            /**
+             * Dibuja un rectángulo. Devuelve el número de píxeles escritos.
+             */
+            uint64_t fill_rectangle (const Render_Command & command);
+
+            /**
+             * Actualiza los bytes que se atribuyen a los framebuffers y a las copias de texturas.
+             */
+            void update_memory ();
+
+        };
+
+    }
+
+#endif
@@ -0,0 +1,499 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Spatial_Index.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace jesus_villar_examen
+{
+
+    Spatial_Index::Spatial_Index(float width, float height, float cell_size)
+    :
+        query(0)
+    {
+        reset (width, height, cell_size);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Spatial_Index::reset (float width, float height, float new_cell_size)
+    {
+        cell_size         = new_cell_size;
+        inverse_cell_size = 1.f / cell_size;
+        columns           = std::max (unsigned(std::ceil (width  / cell_size)), 1u);
+        rows              = std::max (unsigned(std::ceil (height / cell_size)), 1u);
+        layers            = 1;
+
+        std::fill_n (layer_cells, 32, 0u);
+
+        clear ();
+
+        cell_start.assign (size_t(columns) * rows + 1, 0);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Spatial_Index::clear ()
+    {
+        entries     .clear ();
+        cell_entries.clear ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Spatial_Index::insert (const GameObject & object, uint32_t categories)
+    {
+        if (object.is_visible ())
+        {
+            float left   = object.get_left_x   ();
+            float bottom = object.get_bottom_y ();
+            float right  = object.get_right_x  ();
+            float top    = object.get_top_y    ();
+
+            entries.push_back
+            ({
+                left, bottom, right, top, categories, &object,
+                uint16_t(column_of (left  )), uint16_t(column_of (right)),
+                uint16_t(row_of    (bottom)), uint16_t(row_of    (top  ))
+            });
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Ordenación por conteo: primero se cuenta cuántas entradas caen en cada cubo (celda y bit de
+    // categoría), luego se calcula dónde empieza cada cubo y por último se colocan las entradas.
+    // Los cubos de una celda quedan seguidos, de modo que una consulta que solo busca algunas
+    // categorías no recorre las entradas de las demás.
+
+    void Spatial_Index::build ()
+    {
+        uint32_t used_categories = 0;
+
+        std::fill_n (layer_cells, 32, 0u);
+
+        for (const Entry & entry : entries)
+        {
+            uint32_t cells = uint32_t(entry.last_column - entry.first_column + 1) * (entry.last_row - entry.first_row + 1);
+
+            used_categories |= entry.categories;
+
+            for (uint32_t layer = 0, bits = entry.categories; bits != 0; ++layer, bits >>= 1)
+            {
+                if (!(bits & 1u)) continue;
+
+                Cell_Range & range = layer_ranges[layer];
+
+                if (layer_cells[layer] == 0)
+                {
+                    range = { entry.first_column, entry.last_column, entry.first_row, entry.last_row };
+                }
+                else
+                {
+                    range.first_column = std::min< unsigned > (range.first_column, entry.first_column);
+                    range.last_column  = std::max< unsigned > (range.last_column,  entry.last_column );
+                    range.first_row    = std::min< unsigned > (range.first_row,    entry.first_row   );
+                    range.last_row     = std::max< unsigned > (range.last_row,     entry.last_row    );
+                }
+
+                layer_cells[layer] += cells;
+            }
+        }
+
+        for (layers = 1; layers < 32 && (used_categories >> layers) != 0; ++layers);
+
+        cell_start.assign (size_t(columns) * rows * layers + 1, 0u);
+
+        auto for_each_bucket = [this] (const Entry & entry, auto && action)
+        {
+            for (unsigned row = entry.first_row; row <= entry.last_row; ++row)
+            {
+                for (unsigned column = entry.first_column; column <= entry.last_column; ++column)
+                {
+                    for (unsigned layer = 0; layer < layers; ++layer)
+                    {
+                        if (entry.categories & (1u << layer)) action ((row * columns + column) * layers + layer);
+                    }
+                }
+            }
+        };
+
+        for (const Entry & entry : entries)
+        {
+            for_each_bucket (entry, [this] (unsigned bucket) { cell_start[bucket + 1]++; });
+        }
+
+        for (size_t bucket = 1; bucket < cell_start.size (); ++bucket)
+        {
+            cell_start[bucket] += cell_start[bucket - 1];
+        }
+
+        cell_entries.resize (cell_start.back ());
+
+        // Se usa cell_start desplazado un cubo como cursor de escritura y después se restaura:
+
+        for (uint32_t index = 0; index < entries.size (); ++index)
+        {
+            for_each_bucket (entries[index], [this, index] (unsigned bucket) { cell_entries[cell_start[bucket]++] = index; });
+        }
+
+        for (size_t bucket = cell_start.size () - 1; bucket > 0; --bucket)
+        {
+            cell_start[bucket] = cell_start[bucket - 1];
+        }
+
+        cell_start[0] = 0;
+
+        stamps.assign (entries.size (), query);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    size_t Spatial_Index::count_cells (uint32_t categories) const
+    {
+        size_t count = 0;
+
+        for (unsigned layer = 0; layer < 32; ++layer)
+        {
+            if (categories & (1u << layer)) count += layer_cells[layer];
+        }
+
+        return count;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    size_t Spatial_Index::query_point (const Point2f & point, uint32_t categories, const GameObject ** results, size_t capacity)
+    {
+        float  x     = point[0];
+        float  y     = point[1];
+        size_t count = 0;
+
+        next_query ();
+
+        visit_cell (column_of (x), row_of (y), categories, [&] (const Entry & entry)
+        {
+            if (count < capacity && x > entry.left && x < entry.right && y > entry.bottom && y < entry.top)
+            {
+                results[count++] = entry.object;
+            }
+        });
+
+        return count;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    size_t Spatial_Index::query_rectangle (float left, float bottom, float right, float top, uint32_t categories, const GameObject ** results, size_t capacity)
+    {
+        size_t count = 0;
+
+        if (capacity > 0)
+        {
+            visit_rectangle (left, bottom, right, top, categories, [&] (const GameObject & object)
+            {
+                results[count++] = &object;
+
+                return count < capacity;
+            });
+        }
+
+        return count;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    size_t Spatial_Index::query_overlapping (const GameObject & object, uint32_t categories, const GameObject ** results, size_t capacity)
+    {
+        size_t count = query_rectangle (object.get_left_x (), object.get_bottom_y (), object.get_right_x (), object.get_top_y (), categories, results, capacity);
+
+        // Se quita el propio objeto si estaba en el índice:
+
+        for (size_t index = 0; index < count; ++index)
+        {
+            if (results[index] == &object)
+            {
+                results[index] = results[--count];
+                break;
+            }
+        }
+
+        return count;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Se recorren anillos de celdas cada vez más alejados de la celda del punto. Todas las celdas
+    // del anillo r + 1 están al menos a r * cell_size del punto, así que se puede parar en cuanto
+    // los resultados más lejanos estén por debajo de esa distancia. Solo se visitan las celdas
+    // del rectángulo que ocupan las categorías buscadas: los anillos que no lo tocan se saltan y
+    // de los demás solo se recorre la parte que cae dentro, de modo que un punto alejado de todos
+    // los objetos no paga por las celdas vacías que hay entre medias.
+
+    size_t Spatial_Index::query_nearest (const Point2f & point, uint32_t categories, Hit * results, size_t capacity, float max_distance)
+    {
+        if (capacity == 0) return 0;
+
+        bool       found = false;
+        Cell_Range range { 0, 0, 0, 0 };
+
+        for (unsigned layer = 0; layer < layers; ++layer)
+        {
+            if (!(categories & (1u << layer)) || layer_cells[layer] == 0) continue;
+
+            const Cell_Range & layer_range = layer_ranges[layer];
+
+            if (!found)
+            {
+                range = layer_range;
+                found = true;
+            }
+            else
+            {
+                range.first_column = std::min (range.first_column, layer_range.first_column);
+                range.last_column  = std::max (range.last_column,  layer_range.last_column );
+                range.first_row    = std::min (range.first_row,    layer_range.first_row   );
+                range.last_row     = std::max (range.last_row,     layer_range.last_row    );
+            }
+        }
+
+        if (!found) return 0;
+
+        float  x             = point[0];
+        float  y             = point[1];
+        int    center_column = int(column_of (x));
+        int    center_row    = int(row_of    (y));
+        int    first_column  = int(range.first_column), last_column = int(range.last_column);
+        int    first_row     = int(range.first_row   ), last_row    = int(range.last_row   );
+        int    first_ring    = std::max ({ 0, first_column - center_column, center_column - last_column, first_row - center_row, center_row - last_row });
+        int    last_ring     = std::max ({ center_column - first_column, last_column - center_column, center_row - first_row, last_row - center_row });
+        float  max_squared   = max_distance * max_distance;
+        size_t count         = 0;
+
+        next_query ();
+
+        // Se compara con distancias al cuadrado y solo se calcula la raíz de las que entran:
+
+        auto consider = [&] (const Entry & entry)
+        {
+            float dx      = std::max (std::max (entry.left - x, x - entry.right), 0.f);
+            float dy      = std::max (std::max (entry.bottom - y, y - entry.top), 0.f);
+            float squared = dx * dx + dy * dy;
+
+            if (squared > max_squared) return;
+
+            if (count == capacity && squared >= results[count - 1].distance * results[count - 1].distance) return;
+
+            float distance = std::sqrt (squared);
+
+            // Inserción ordenada (los resultados son pocos):
+
+            size_t position = count < capacity ? count++ : count - 1;
+
+            while (position > 0 && results[position - 1].distance > distance)
+            {
+                results[position] = results[position - 1];
+                --position;
+            }
+
+            results[position] = { entry.object, distance };
+        };
+
+        // Una celda solo se recorre si puede contener algo más cerca que lo ya encontrado. Cada
+        // entrada está también en la celda que contiene su punto más cercano, que no se descarta,
+        // así que no se pierde ninguna. Las celdas del borde se extienden hasta el infinito porque
+        // en ellas están también las entradas que se salen de la rejilla:
+
+        const float infinity = std::numeric_limits< float >::infinity ();
+
+        auto visit = [&] (int column, int row)
+        {
+            float left    = column == 0                ? -infinity : column * cell_size;
+            float right   = column == int(columns) - 1 ?  infinity : (column + 1) * cell_size;
+            float bottom  = row    == 0                ? -infinity : row * cell_size;
+            float top     = row    == int(rows) - 1    ?  infinity : (row + 1) * cell_size;
+            float dx      = std::max (std::max (left - x, x - right), 0.f);
+            float dy      = std::max (std::max (bottom - y, y - top), 0.f);
+            float squared = dx * dx + dy * dy;
+
+            if (squared > max_squared) return;
+
+            if (count == capacity && squared >= results[count - 1].distance * results[count - 1].distance) return;
+
+            visit_cell (unsigned(column), unsigned(row), categories, consider);
+        };
+
+        for (int ring = first_ring; ring <= last_ring; ++ring)
+        {
+            float ring_distance = std::max (ring - 1, 0) * cell_size;
+
+            if (ring_distance > max_distance || (count == capacity && results[count - 1].distance <= ring_distance)) break;
+
+            for (int row = std::max (center_row - ring, first_row); row <= std::min (center_row + ring, last_row); ++row)
+            {
+                if (row == center_row - ring || row == center_row + ring)
+                {
+                    for (int column = std::max (center_column - ring, first_column); column <= std::min (center_column + ring, last_column); ++column)
+                    {
+                        visit (column, row);
+                    }
+                }
+                else
+                {
+                    if (center_column - ring >= first_column) visit (center_column - ring, row);
+                    if (center_column + ring <= last_column ) visit (center_column + ring, row);
+                }
+            }
+        }
+
+        return count;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Recorrido de las celdas que atraviesa el rayo (Amanatides y Woo). Se puede parar en cuanto el
+    // impacto más cercano encontrado está antes de la salida de la celda actual. El rayo se recorta
+    // a la zona de la rejilla antes de comprobar las cajas: las celdas del borde también guardan
+    // las que se salen de ella, y sin recortar solo se encontrarían las partes de fuera de las que
+    // están en las celdas por las que pasa el rayo.
+
+    bool Spatial_Index::ray_cast (const Point2f & origin, const Vector2f & direction, float max_distance, uint32_t categories, Hit & hit)
+    {
+        const float infinity = std::numeric_limits< float >::infinity ();
+
+        float length = std::sqrt (direction[0] * direction[0] + direction[1] * direction[1]);
+
+        if (length == 0.f) return false;
+
+        float ox = origin[0],             oy = origin[1];
+        float dx = direction[0] / length, dy = direction[1] / length;
+
+        // Tramo del rayo que se tiene en cuenta (al principio, todo):
+
+        float clip_enter = 0.f;
+        float clip_leave = max_distance;
+
+        // Distancias a las que el rayo entra y sale de una caja dentro del tramo (false si no la
+        // atraviesa):
+
+        auto slab = [&] (float left, float bottom, float right, float top, float & enter, float & leave) -> bool
+        {
+            float entering = clip_enter, leaving = clip_leave;
+
+            if (dx != 0.f)
+            {
+                float t0 = (left - ox) / dx, t1 = (right - ox) / dx;
+
+                entering = std::max (entering, std::min (t0, t1));
+                leaving  = std::min (leaving,  std::max (t0, t1));
+            }
+            else if (ox < left || ox > right) return false;
+
+            if (dy != 0.f)
+            {
+                float t0 = (bottom - oy) / dy, t1 = (top - oy) / dy;
+
+                entering = std::max (entering, std::min (t0, t1));
+                leaving  = std::min (leaving,  std::max (t0, t1));
+            }
+            else if (oy < bottom || oy > top) return false;
+
+            enter = entering;
+            leave = leaving;
+
+            return entering <= leaving;
+        };
+
+        // Tramo del rayo que está dentro de la rejilla:
+
+        float start, end;
+
+        if (!slab (0.f, 0.f, columns * cell_size, rows * cell_size, start, end)) return false;
+
+        clip_enter = start;
+        clip_leave = end;
+
+        int   column = int(column_of (ox + dx * start));
+        int   row    = int(row_of    (oy + dy * start));
+        int   step_x = dx > 0.f ? 1 : -1;
+        int   step_y = dy > 0.f ? 1 : -1;
+        float next_x = dx != 0.f ? ((column + (dx > 0.f ? 1 : 0)) * cell_size - ox) / dx : infinity;
+        float next_y = dy != 0.f ? ((row    + (dy > 0.f ? 1 : 0)) * cell_size - oy) / dy : infinity;
+        float delta_x = dx != 0.f ? cell_size / std::fabs (dx) : infinity;
+        float delta_y = dy != 0.f ? cell_size / std::fabs (dy) : infinity;
+
+        hit = { nullptr, infinity };
+
+        next_query ();
+
+        for (;;)
+        {
+            visit_cell (unsigned(column), unsigned(row), categories, [&] (const Entry & entry)
+            {
+                float enter, leave;
+
+                if (slab (entry.left, entry.bottom, entry.right, entry.top, enter, leave) && enter < hit.distance)
+                {
+                    hit = { entry.object, enter };
+                }
+            });
+
+            float cell_exit = std::min (next_x, next_y);
+
+            if (hit.object && hit.distance <= cell_exit) break;
+            if (cell_exit > max_distance) break;
+
+            if (next_x < next_y)
+            {
+                column += step_x;
+                next_x += delta_x;
+
+                if (column < 0 || column >= int(columns)) break;
+            }
+            else
+            {
+                row    += step_y;
+                next_y += delta_y;
+
+                if (row < 0 || row >= int(rows)) break;
+            }
+        }
+
+        return hit.object != nullptr;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    unsigned Spatial_Index::column_of (float x) const
+    {
+        return x <= 0.f ? 0 : unsigned(std::min (x * inverse_cell_size, float(columns - 1)));
+    }
+
+    unsigned Spatial_Index::row_of (float y) const
+    {
+        return y <= 0.f ? 0 : unsigned(std::min (y * inverse_cell_size, float(rows - 1)));
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Spatial_Index::next_query ()
+    {
+        // Si el contador da la vuelta, se limpian las marcas para no confundir consultas:
+
+        if (++query == 0)
+        {
+            std::fill (stamps.begin (), stamps.end (), 0u);
+
+            query = 1;
+        }
+    }
+
+}
@@ -0,0 +1,237 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef SPATIAL_INDEX_HEADER
+#define SPATIAL_INDEX_HEADER
+
+    #include <vector>
+    #include <cstdint>
+
+    #include "GameObject.hpp"
+    #include "Memory_Tracker.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Índice espacial de los gameobjects de una escena basado en una rejilla uniforme. Se
+         * reconstruye en cada paso (insert() de los objetos y build(), que los reparte por celdas
+         * con una ordenación por conteo sin reservar memoria una vez que los arrays han crecido) y
+         * responde consultas por punto, rectángulo, rayo y k vecinos más cercanos filtradas por
+         * categoría. Los resultados se escriben en buffers del llamador. Dentro de cada celda los
+         * objetos se separan por bit de categoría, así que conviene usar bits bajos.
+         *
+         * Se comparan las cajas de los objetos tal y como estaban al insertarlos. Si un objeto se
+         * mueve después, sus resultados pueden estar desactualizados hasta el siguiente build().
+         */
+        class Spatial_Index
+        {
+        public:
+
+            /**
+             * Resultado de una consulta de vecinos o de un rayo.
+             */
+            struct Hit
+            {
+                const GameObject * object;
+                float              distance;            ///< Distancia desde el punto (o desde el origen del rayo) a la caja.
+            };
+
+        private:
+
+            struct Entry
+            {
+                float              left, bottom;
+                float              right, top;
+                uint32_t           categories;
+                const GameObject * object;
+                uint16_t           first_column, last_column;   ///< Celdas que ocupa (calculadas al insertarla).
+                uint16_t           first_row,    last_row;
+            };
+
+            /**
+             * Celdas entre las que están todas las entradas de un bit de categoría.
+             */
+            struct Cell_Range
+            {
+                unsigned first_column, last_column;
+                unsigned first_row,    last_row;
+            };
+
+            float                   cell_size;
+            float                   inverse_cell_size;
+            unsigned                columns;
+            unsigned                rows;
+
+            unsigned                layers;             ///< Bits de categoría en uso (cada celda tiene un cubo por bit).
+            uint32_t                layer_cells[32];    ///< Suma de las celdas que ocupan las entradas de cada bit de categoría.
+            Cell_Range              layer_ranges[32];   ///< Celdas que ocupan las entradas de cada bit de categoría (si layer_cells no es 0).
+
+            Tracked_Vector< Entry   , MEMORY_SPATIAL_INDEX > entries;
+            Tracked_Vector< uint32_t, MEMORY_SPATIAL_INDEX > cell_start;    ///< Primer elemento de cada cubo en cell_entries (uno más al final).
+            Tracked_Vector< uint32_t, MEMORY_SPATIAL_INDEX > cell_entries;  ///< Índices de entries agrupados por celda y bit de categoría.
+            Tracked_Vector< uint32_t, MEMORY_SPATIAL_INDEX > stamps;        ///< Última consulta que visitó cada entrada (para no repetirla).
+            uint32_t                query;
+
+        public:
+
+            /**
+             * @param width  Ancho de la zona que cubre la rejilla (lo que quede fuera va a las celdas del borde).
+             * @param height Alto  de la zona que cubre la rejilla.
+             * @param cell_size Lado de cada celda (del orden del tamaño de los objetos).
+             */
+            Spatial_Index(float width = 1.f, float height = 1.f, float cell_size = 64.f);
+
+            /**
+             * Cambia la zona cubierta. Vacía el índice.
+             */
+            void reset (float width, float height, float cell_size);
+
+        public:
+
+            /**
+             * Vacía el índice conservando la memoria reservada.
+             */
+            void clear ();
+
+            /**
+             * Añade un objeto (solo si es visible) con las categorías indicadas (máscara de bits).
+             */
+            void insert (const GameObject & object, uint32_t categories);
+
+            /**
+             * Reparte los objetos insertados por celdas. Hay que llamarlo antes de consultar.
+             */
+            void build ();
+
+            size_t size () const
+            {
+                return entries.size ();
+            }
+
+            /**
+             * Suma de las celdas que ocupan las entradas con alguna de las categorías de la máscara
+             * (las que tienen varias se cuentan una vez por cada una). Da una idea de lo que cuesta
+             * consultar el índice con la caja de cada una de ellas.
+             */
+            size_t count_cells (uint32_t categories) const;
+
+            /**
+             * Llama a visitor(const GameObject &) con cada objeto que tenga alguna de las categorías
+             * de la máscara, en el orden en el que se insertaron.
+             */
+            template< typename VISITOR >
+            void visit_category (uint32_t categories, VISITOR && visitor) const
+            {
+                for (const Entry & entry : entries)
+                {
+                    if (entry.categories & categories) visitor (*entry.object);
+                }
+            }
+
+        public:
+
+            // Todas las consultas devuelven cuántos resultados se han escrito (como mucho capacity)
+            // y solo tienen en cuenta los objetos con alguna de las categorías de la máscara:
+
+            size_t query_point (const Point2f & point, uint32_t categories, const GameObject ** results, size_t capacity);
+
+            size_t query_rectangle (float left, float bottom, float right, float top, uint32_t categories, const GameObject ** results, size_t capacity);
+
+            /**
+             * Llama a visitor(const GameObject &) con cada objeto que se solapa con el rectángulo
+             * hasta que devuelva false. Sirve cuando el número de resultados no está acotado o
+             * cuando basta con encontrar uno.
+             */
+            template< typename VISITOR >
+            void visit_rectangle (float left, float bottom, float right, float top, uint32_t categories, VISITOR && visitor)
+            {
+                bool visiting = true;
+
+                next_query ();
+
+                for (unsigned row = row_of (bottom); row <= row_of (top) && visiting; ++row)
+                {
+                    for (unsigned column = column_of (left); column <= column_of (right) && visiting; ++column)
+                    {
+                        visit_cell (column, row, categories, [&] (const Entry & entry)
+                        {
+                            if (visiting && entry.left < right && entry.right > left && entry.bottom < top && entry.top > bottom)
+                            {
+                                visiting = visitor (*entry.object);
+                            }
+                        });
+                    }
+                }
+            }
+
+            /**
+             * Objetos que se solapan con otro (sin incluirlo a él).
+             */
+            size_t query_overlapping (const GameObject & object, uint32_t categories, const GameObject ** results, size_t capacity);
+
+            /**
+             * Los 'capacity' objetos más cercanos a un punto, ordenados de más cerca a más lejos.
+             * @param max_distance Distancia máxima a la que se buscan.
+             */
+            size_t query_nearest (const Point2f & point, uint32_t categories, Hit * results, size_t capacity, float max_distance = 1e30f);
+
+            /**
+             * Primer objeto que atraviesa un rayo.
+             * @param direction Dirección del rayo (no hace falta que esté normalizada).
+             * @param max_distance Longitud máxima del rayo. Solo se recorre la zona que cubre la
+             *                     rejilla: si el rayo entra en ella dentro de un objeto, la
+             *                     distancia de este es la del punto de entrada.
+             * @return false si no atraviesa ninguno.
+             */
+            bool ray_cast (const Point2f & origin, const Vector2f & direction, float max_distance, uint32_t categories, Hit & hit);
+
+        private:
+
+            unsigned column_of (float x) const;
+            unsigned row_of    (float y) const;
+
+            /**
+             * Empieza una consulta nueva (para descartar las entradas repetidas en varias celdas).
+             */
+            void next_query ();
+
+            /**
+             * Recorre las entradas de una celda que no se han visitado aún en esta consulta.
+             */
+            template< typename VISITOR >
+            void visit_cell (unsigned column, unsigned row, uint32_t categories, VISITOR && visitor)
+            {
+                unsigned first_bucket = (row * columns + column) * layers;
+
+                for (unsigned layer = 0; layer < layers; ++layer)
+                {
+                    if (!(categories & (1u << layer))) continue;
+
+                    for (uint32_t index = cell_start[first_bucket + layer]; index < cell_start[first_bucket + layer + 1]; ++index)
+                    {
+                        uint32_t entry = cell_entries[index];
+
+                        if (stamps[entry] != query)
+                        {
+                            stamps[entry] = query;
+
+                            visitor (entries[entry]);
+                        }
+                    }
+                }
+            }
+
+        };
+
+    }
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Sprite_Animator.hpp"
+
+#include <algorithm>
+
+namespace jesus_villar_examen
+{
+
+    // ---------------------------------------------------------------------------------------------
+    // Las coordenadas UV tienen el origen abajo a la izquierda, así que la primera fila de celdas
+    // (la superior) es la que tiene las v mayores.
+
+    uint16_t Sprite_Animator::add_grid_frames (unsigned columns, unsigned rows, unsigned count)
+    {
+        uint16_t first = uint16_t(frames.size ());
+
+        unsigned cells = columns * rows;
+
+        if (count == 0 || count > cells) count = cells;
+
+        for (unsigned cell = 0; cell < count; ++cell)
+        {
+            float column = float(cell % columns);
+            float row    = float(cell / columns);
+
+            frames.push_back
+            ({
+                 column        / columns, 1.f - (row + 1.f) / rows,
+                (column + 1.f) / columns, 1.f -  row        / rows
+            });
+        }
+
+        return first;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Sprite_Animator::Clip Sprite_Animator::add_clip (uint16_t first_frame, uint16_t frame_count, float frames_per_second, bool looping, Id event)
+    {
+        clips.push_back ({ first_frame, std::max (frame_count, uint16_t(1)), frames_per_second, looping, event });
+
+        return Clip(clips.size () - 1);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Sprite_Animator::Animation Sprite_Animator::add_animation (Clip clip)
+    {
+        clip_of .push_back (clip);
+        frame_of.push_back (0);
+        time_of .push_back (0.f);
+        playing .push_back (1);
+        uvs     .push_back (frames[clips[clip].first_frame]);
+
+        return Animation(clip_of.size () - 1);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Sprite_Animator::play (Animation animation, Clip clip)
+    {
+        clip_of [animation] = clip;
+        frame_of[animation] = 0;
+        time_of [animation] = 0.f;
+        playing [animation] = 1;
+        uvs     [animation] = frames[clips[clip].first_frame];
+    }
+
+}
@@ -0,0 +1,156 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef SPRITE_ANIMATOR_HEADER
+#define SPRITE_ANIMATOR_HEADER
+
+    #include <vector>
+    #include <cstdint>
+
+    #include <basics/Id>
+
+    #include "Render_Snapshot.hpp"
+    #include "Memory_Tracker.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        using basics::Id;
+
+        /**
+         * Animaciones de sprites a partir de secuencias de fotogramas de un atlas. Los fotogramas
+         * (rectángulos UV) y los clips (secuencia, velocidad, si se repite y evento al terminar)
+         * se comparten; de cada animación solo se guarda su clip, su fotograma y su tiempo en
+         * arrays paralelos. Todas las animaciones avanzan en un único recorrido por fotograma que
+         * deja el rectángulo UV de cada una listo para añadirlo a los comandos de dibujado.
+         */
+        class Sprite_Animator
+        {
+        public:
+
+            typedef uint16_t Clip;
+            typedef uint32_t Animation;
+
+        private:
+
+            struct Clip_Data
+            {
+                uint16_t first_frame;
+                uint16_t frame_count;
+                float    frames_per_second;
+                bool     looping;
+                Id       event;                     ///< Se notifica al terminar (o al dar la vuelta si se repite). 0 para ninguno.
+            };
+
+            Tracked_Vector< UV_Rect  , MEMORY_ENTITIES > frames;
+            Tracked_Vector< Clip_Data, MEMORY_ENTITIES > clips;
+
+            // Estado de cada animación:
+
+            Tracked_Vector< Clip    , MEMORY_ENTITIES > clip_of;
+            Tracked_Vector< uint16_t, MEMORY_ENTITIES > frame_of;  ///< Fotograma actual dentro del clip.
+            Tracked_Vector< float   , MEMORY_ENTITIES > time_of;   ///< Segundos desde que empezó (o dio la vuelta) el clip.
+            Tracked_Vector< uint8_t , MEMORY_ENTITIES > playing;
+            Tracked_Vector< UV_Rect , MEMORY_ENTITIES > uvs;       ///< Resultado: rectángulo UV del fotograma actual.
+
+        public:
+
+            /**
+             * Añade los fotogramas de un atlas organizado en una rejilla, de izquierda a derecha y
+             * de arriba abajo.
+             * @param count Número de celdas (0 para todas).
+             * @return Índice del primer fotograma añadido.
+             */
+            uint16_t add_grid_frames (unsigned columns, unsigned rows, unsigned count = 0);
+
+            /**
+             * Define una secuencia de fotogramas consecutivos.
+             * @param event Id que se notifica en update() al terminar el clip o al dar la vuelta.
+             */
+            Clip add_clip (uint16_t first_frame, uint16_t frame_count, float frames_per_second, bool looping, Id event = 0);
+
+            /**
+             * Crea una animación que empieza a reproducir el clip indicado.
+             */
+            Animation add_animation (Clip clip);
+
+            /**
+             * Cambia el clip de una animación y lo reproduce desde el principio.
+             */
+            void play (Animation animation, Clip clip);
+
+            void stop (Animation animation)
+            {
+                playing[animation] = 0;
+            }
+
+            bool is_playing (Animation animation) const
+            {
+                return playing[animation] != 0;
+            }
+
+            const UV_Rect & get_uv (Animation animation) const
+            {
+                return uvs[animation];
+            }
+
+            size_t size () const
+            {
+                return clip_of.size ();
+            }
+
+            /**
+             * Avanza todas las animaciones y notifica los eventos de los clips que terminan o dan
+             * la vuelta.
+             * @param handler Se invoca como handler(Animation, Id) por cada evento.
+             */
+            template< typename HANDLER >
+            void update (float time, HANDLER && handler)
+            {
+                const size_t count = clip_of.size ();
+
+                for (size_t animation = 0; animation < count; ++animation)
+                {
+                    if (!playing[animation]) continue;
+
+                    const Clip_Data & clip = clips[clip_of[animation]];
+
+                    float    elapsed = time_of[animation] + time;
+                    unsigned frame   = unsigned(elapsed * clip.frames_per_second);
+
+                    if (frame >= clip.frame_count)
+                    {
+                        if (clip.looping)
+                        {
+                            elapsed -= float(frame / clip.frame_count * clip.frame_count) / clip.frames_per_second;
+                            frame   %= clip.frame_count;
+                        }
+                        else
+                        {
+                            frame = clip.frame_count - 1u;
+
+                            playing[animation] = 0;
+                        }
+
+                        if (clip.event) handler (Animation(animation), clip.event);
+                    }
+
+                    time_of [animation] = elapsed;
+                    frame_of[animation] = uint16_t(frame);
+                    uvs     [animation] = frames[clip.first_frame + frame];
+                }
+            }
+
+        };
+
+    }
+
+#endif
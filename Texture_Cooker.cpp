@@ -0,0 +1,626 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Texture_Cooker.hpp"
+
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+
+namespace jesus_villar_examen
+{
+
+    // ---------------------------------------------------------------------------------------------
+    // Tablas de la especificación de ETC2 (Khronos Data Format, sección ETC2/EAC).
+
+    static const int color_modifiers[8][4] =            // Índices de píxel 0..3: +a, +b, -a, -b
+    {
+        {  2,   8,  -2,   -8 }, {  5,  17,  -5,  -17 }, {  9,  29,  -9,  -29 }, { 13,  42, -13,  -42 },
+        { 18,  60, -18,  -60 }, { 24,  80, -24,  -80 }, { 33, 106, -33, -106 }, { 47, 183, -47, -183 },
+    };
+
+    static const int alpha_modifiers[16][8] =
+    {
+        { -3, -6,  -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+        { -2, -5,  -8, -13, 1, 4, 7, 12 }, { -2, -4,  -6, -13, 1, 3, 5, 12 },
+        { -3, -6,  -8, -12, 2, 5, 7, 11 }, { -3, -7,  -9, -11, 2, 6, 8, 10 },
+        { -4, -7,  -8, -11, 3, 6, 7, 10 }, { -3, -5,  -8, -11, 2, 4, 7, 10 },
+        { -2, -6,  -8, -10, 1, 5, 7,  9 }, { -2, -5,  -8, -10, 1, 4, 7,  9 },
+        { -2, -4,  -8, -10, 1, 3, 7,  9 }, { -2, -5,  -7, -10, 1, 4, 6,  9 },
+        { -3, -4,  -7, -10, 2, 3, 6,  9 }, { -1, -2,  -3, -10, 0, 1, 2,  9 },
+        { -4, -6,  -8,  -9, 3, 5, 7,  8 }, { -3, -5,  -7,  -9, 2, 4, 6,  8 },
+    };
+
+    static const size_t block_bytes = 16;
+
+    static const uint8_t ktx_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    // ---------------------------------------------------------------------------------------------
+    // Funciones auxiliares. Los bloques se manejan como enteros de 64 bits que se guardan en orden
+    // big-endian. Dentro de un bloque el píxel (x, y) tiene el índice x * 4 + y, con y creciendo en
+    // el mismo sentido que las filas de la imagen (que es el orden en el que se suben a la GPU).
+
+    static inline int clamp_byte (int value)
+    {
+        return value < 0 ? 0 : value > 255 ? 255 : value;
+    }
+
+    static inline int channel (uint32_t pixel, unsigned index)
+    {
+        return int((pixel >> (index * 8)) & 0xFF);
+    }
+
+    static void write_block (uint8_t * destination, uint64_t bits)
+    {
+        for (unsigned byte = 0; byte < 8; ++byte)
+        {
+            destination[byte] = uint8_t(bits >> (56 - byte * 8));
+        }
+    }
+
+    static uint64_t read_block (const uint8_t * source)
+    {
+        uint64_t bits = 0;
+
+        for (unsigned byte = 0; byte < 8; ++byte)
+        {
+            bits = (bits << 8) | source[byte];
+        }
+
+        return bits;
+    }
+
+    // Reúne los 16 píxeles de un bloque (repitiendo los bordes si la imagen no es múltiplo de 4).
+    // Fila 'y' del bloque = fila 'block_y * 4 + y' de la imagen.
+
+    static void gather_block (const Texture_Cooker::Image & image, unsigned block_x, unsigned block_y, uint32_t (& pixels)[16])
+    {
+        for (unsigned x = 0; x < 4; ++x)
+        {
+            for (unsigned y = 0; y < 4; ++y)
+            {
+                unsigned image_x = std::min (block_x * 4 + x, image.width  - 1);
+                unsigned image_y = std::min (block_y * 4 + y, image.height - 1);
+
+                pixels[x * 4 + y] = image.pixels[size_t(image_y) * image.width + image_x];
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Alfa EAC: base de 8 bits, multiplicador de 4 bits, tabla de 4 bits y un índice de 3 bits por
+    // píxel. Se prueban todas las tablas con el multiplicador y la base que ajustan el rango.
+
+    static uint64_t encode_alpha (const uint32_t (& pixels)[16])
+    {
+        int minimum = 255, maximum = 0;
+
+        for (uint32_t pixel : pixels)
+        {
+            minimum = std::min (minimum, channel (pixel, 3));
+            maximum = std::max (maximum, channel (pixel, 3));
+        }
+
+        if (minimum == maximum)                         // Alfa uniforme: modificador 0 de la tabla 13
+        {
+            uint64_t bits = uint64_t(minimum) << 56 | uint64_t(1) << 52 | uint64_t(13) << 48;
+
+            for (unsigned p = 0; p < 16; ++p) bits |= uint64_t(4) << (45 - p * 3);
+
+            return bits;
+        }
+
+        uint64_t best_bits  = 0;
+        int      best_error = 0x7FFFFFFF;
+
+        for (int table = 0; table < 16; ++table)
+        {
+            const int * modifiers = alpha_modifiers[table];
+            int         range     = modifiers[7] - modifiers[3];
+            int         estimate  = (maximum - minimum + range / 2) / range;
+
+            for (int multiplier = std::max (estimate - 1, 1); multiplier <= std::min (estimate + 1, 15); ++multiplier)
+            {
+                int centered = (minimum + maximum - (modifiers[3] + modifiers[7]) * multiplier) / 2;
+
+                for (int base = clamp_byte (centered - 1); base <= clamp_byte (centered + 1); ++base)
+                {
+                    uint64_t bits  = uint64_t(base) << 56 | uint64_t(multiplier) << 52 | uint64_t(table) << 48;
+                    int      error = 0;
+
+                    for (unsigned p = 0; p < 16 && error < best_error; ++p)
+                    {
+                        int alpha          = channel (pixels[p], 3);
+                        int best_index     = 0;
+                        int best_distance  = 0x7FFFFFFF;
+
+                        for (int index = 0; index < 8; ++index)
+                        {
+                            int distance = std::abs (clamp_byte (base + modifiers[index] * multiplier) - alpha);
+
+                            if (distance < best_distance) { best_distance = distance; best_index = index; }
+                        }
+
+                        error += best_distance * best_distance;
+                        bits  |= uint64_t(best_index) << (45 - p * 3);
+                    }
+
+                    if (error < best_error) { best_error = error; best_bits = bits; }
+                }
+            }
+        }
+
+        return best_bits;
+    }
+
+    static void decode_alpha (uint64_t bits, uint32_t (& pixels)[16])
+    {
+        int         base       = int(bits >> 56);
+        int         multiplier = int(bits >> 52) & 0xF;
+        const int * modifiers  = alpha_modifiers[(bits >> 48) & 0xF];
+
+        for (unsigned p = 0; p < 16; ++p)
+        {
+            int alpha = clamp_byte (base + modifiers[(bits >> (45 - p * 3)) & 0x7] * multiplier);
+
+            pixels[p] = (pixels[p] & 0x00FFFFFFu) | uint32_t(alpha) << 24;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Color: el bloque se divide en dos mitades de 2x4 (flip = 0) o 4x2 (flip = 1). Cada mitad
+    // tiene un color base y una tabla de modificadores de luminancia.
+
+    static inline bool in_first_half (unsigned p, bool flip)
+    {
+        return flip ? (p & 3) < 2 : (p >> 2) < 2;
+    }
+
+    // Elige la mejor tabla para una mitad y devuelve su error. Los índices se dejan en 'indices'.
+
+    static int fit_half (const uint32_t (& pixels)[16], bool flip, bool first, const int (& base)[3], int & best_table, uint32_t & indices)
+    {
+        int best_error = 0x7FFFFFFF;
+
+        for (int table = 0; table < 8; ++table)
+        {
+            uint32_t table_indices = 0;
+            int      error         = 0;
+
+            for (unsigned p = 0; p < 16; ++p)
+            {
+                if (in_first_half (p, flip) != first) continue;
+
+                int best_distance = 0x7FFFFFFF, best_index = 0;
+
+                for (int index = 0; index < 4; ++index)
+                {
+                    int distance = 0;
+
+                    for (unsigned c = 0; c < 3; ++c)
+                    {
+                        int difference = clamp_byte (base[c] + color_modifiers[table][index]) - channel (pixels[p], c);
+
+                        distance += difference * difference;
+                    }
+
+                    if (distance < best_distance) { best_distance = distance; best_index = index; }
+                }
+
+                error         += best_distance;
+                table_indices |= uint32_t(best_index >> 1) << (16 + p) | uint32_t(best_index & 1) << p;
+            }
+
+            if (error < best_error) { best_error = error; best_table = table; indices = table_indices; }
+        }
+
+        return best_error;
+    }
+
+    static uint64_t encode_color (const uint32_t (& pixels)[16])
+    {
+        uint64_t best_bits  = 0;
+        int      best_error = 0x7FFFFFFF;
+
+        for (int flip = 0; flip < 2; ++flip)
+        {
+            int average[2][3] = { { 0, 0, 0 }, { 0, 0, 0 } };
+
+            for (unsigned p = 0; p < 16; ++p)
+            {
+                for (unsigned c = 0; c < 3; ++c) average[in_first_half (p, flip != 0) ? 0 : 1][c] += channel (pixels[p], c);
+            }
+
+            for (int differential = 0; differential < 2; ++differential)
+            {
+                int quantized[2][3], base[2][3];
+
+                for (unsigned c = 0; c < 3; ++c)
+                {
+                    for (unsigned half = 0; half < 2; ++half)
+                    {
+                        int value = average[half][c] / 8;
+
+                        if (differential)
+                        {
+                            quantized[half][c] = (value * 31 + 127) / 255;
+                        }
+                        else
+                        {
+                            quantized[half][c] = (value * 15 + 127) / 255;
+                        }
+                    }
+
+                    if (differential)               // La segunda mitad se guarda como diferencia en [-4, 3]
+                    {
+                        quantized[1][c] = quantized[0][c] + std::min (std::max (quantized[1][c] - quantized[0][c], -4), 3);
+
+                        for (unsigned half = 0; half < 2; ++half) base[half][c] = quantized[half][c] << 3 | quantized[half][c] >> 2;
+                    }
+                    else
+                    {
+                        for (unsigned half = 0; half < 2; ++half) base[half][c] = quantized[half][c] * 17;
+                    }
+                }
+
+                int      tables[2];
+                uint32_t indices[2];
+                int      error = fit_half (pixels, flip != 0, true,  base[0], tables[0], indices[0])
+                               + fit_half (pixels, flip != 0, false, base[1], tables[1], indices[1]);
+
+                if (error >= best_error) continue;
+
+                uint64_t bits = uint64_t(tables[0]) << 37 | uint64_t(tables[1]) << 34
+                              | uint64_t(differential) << 33 | uint64_t(flip) << 32
+                              | indices[0] | indices[1];
+
+                for (unsigned c = 0; c < 3; ++c)
+                {
+                    unsigned shift = 56 - c * 8;
+
+                    if (differential)
+                    {
+                        bits |= uint64_t(quantized[0][c]) << (shift + 3) | uint64_t((quantized[1][c] - quantized[0][c]) & 7) << shift;
+                    }
+                    else
+                    {
+                        bits |= uint64_t(quantized[0][c]) << (shift + 4) | uint64_t(quantized[1][c]) << shift;
+                    }
+                }
+
+                best_error = error;
+                best_bits  = bits;
+            }
+        }
+
+        return best_bits;
+    }
+
+    static bool decode_color (uint64_t bits, uint32_t (& pixels)[16])
+    {
+        bool differential = (bits >> 33) & 1;
+        bool flip         = (bits >> 32) & 1;
+        int  base[2][3];
+
+        for (unsigned c = 0; c < 3; ++c)
+        {
+            unsigned shift = 56 - c * 8;
+
+            if (differential)
+            {
+                int first  = int(bits >> (shift + 3)) & 0x1F;
+                int delta  = int(bits >> shift) & 0x7;
+                int second = first + (delta >= 4 ? delta - 8 : delta);
+
+                if (second < 0 || second > 31) return false;    // Modos T, H o planar
+
+                base[0][c] = first  << 3 | first  >> 2;
+                base[1][c] = second << 3 | second >> 2;
+            }
+            else
+            {
+                base[0][c] = (int(bits >> (shift + 4)) & 0xF) * 17;
+                base[1][c] = (int(bits >>  shift     ) & 0xF) * 17;
+            }
+        }
+
+        int tables[2] = { int(bits >> 37) & 7, int(bits >> 34) & 7 };
+
+        for (unsigned p = 0; p < 16; ++p)
+        {
+            unsigned half     = in_first_half (p, flip) ? 0 : 1;
+            int      index    = int((bits >> (16 + p)) & 1) << 1 | int((bits >> p) & 1);
+            int      modifier = color_modifiers[tables[half]][index];
+
+            pixels[p] = uint32_t(clamp_byte (base[half][0] + modifier))
+                      | uint32_t(clamp_byte (base[half][1] + modifier)) <<  8
+                      | uint32_t(clamp_byte (base[half][2] + modifier)) << 16;
+        }
+
+        return true;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Texture_Cooker::Texture_Cooker(unsigned threads)
+    :
+        threads(threads > 0 ? threads : std::max (std::thread::hardware_concurrency (), 1u))
+    {
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Texture_Cooker::Report_Entry Texture_Cooker::cook (const std::string & path)
+    {
+        Report_Entry entry { replace_extension (path, ".tga"), replace_extension (path, ".ktx"), false, 0, 0, 0, 0, 0.0, 0.f };
+        Image        original;
+
+        if (!load_tga (entry.source_path, original)) return entry;
+
+        auto             start      = std::chrono::steady_clock::now ();
+        Compressed_Image compressed = encode (original);
+
+        entry.seconds            = std::chrono::duration< float >(std::chrono::steady_clock::now () - start).count ();
+        entry.width              = original.width;
+        entry.height             = original.height;
+        entry.uncompressed_bytes = original.pixels.size () * sizeof(uint32_t);
+        entry.compressed_bytes   = compressed.blocks.size ();
+
+        Image decoded;
+
+        if (decode (compressed, decoded)) entry.psnr = psnr (original, decoded);
+
+        entry.cooked = save_ktx (entry.cooked_path, compressed);
+
+        return entry;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Cada hilo codifica un bloque contiguo de filas de bloques. Los bloques son independientes,
+    // así que no hace falta sincronizar nada más que el join final.
+
+    Texture_Cooker::Compressed_Image Texture_Cooker::encode (const Image & image) const
+    {
+        Compressed_Image compressed { image.width, image.height, {} };
+
+        if (image.width == 0 || image.height == 0) return compressed;
+
+        unsigned blocks_x = (image.width  + 3) / 4;
+        unsigned blocks_y = (image.height + 3) / 4;
+
+        compressed.blocks.resize (size_t(blocks_x) * blocks_y * block_bytes);
+
+        auto encode_rows = [&image, &compressed, blocks_x] (unsigned first_row, unsigned last_row)
+        {
+            uint32_t pixels[16];
+
+            for (unsigned block_y = first_row; block_y < last_row; ++block_y)
+            {
+                for (unsigned block_x = 0; block_x < blocks_x; ++block_x)
+                {
+                    uint8_t * block = &compressed.blocks[(size_t(block_y) * blocks_x + block_x) * block_bytes];
+
+                    gather_block (image, block_x, block_y, pixels);
+
+                    write_block (block,     encode_alpha (pixels));
+                    write_block (block + 8, encode_color (pixels));
+                }
+            }
+        };
+
+        unsigned                   workers = std::min (threads, blocks_y);
+        std::vector< std::thread > pool;
+
+        for (unsigned worker = 1; worker < workers; ++worker)
+        {
+            pool.emplace_back (encode_rows, blocks_y * worker / workers, blocks_y * (worker + 1) / workers);
+        }
+
+        encode_rows (0, blocks_y / workers);
+
+        for (auto & thread : pool) thread.join ();
+
+        return compressed;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    bool Texture_Cooker::decode (const Compressed_Image & compressed, Image & image)
+    {
+        unsigned blocks_x = (compressed.width  + 3) / 4;
+        unsigned blocks_y = (compressed.height + 3) / 4;
+
+        if (compressed.blocks.size () != size_t(blocks_x) * blocks_y * block_bytes) return false;
+
+        image.width  = compressed.width;
+        image.height = compressed.height;
+        image.pixels.assign (size_t(image.width) * image.height, 0);
+
+        uint32_t pixels[16];
+
+        for (unsigned block_y = 0; block_y < blocks_y; ++block_y)
+        {
+            for (unsigned block_x = 0; block_x < blocks_x; ++block_x)
+            {
+                const uint8_t * block = &compressed.blocks[(size_t(block_y) * blocks_x + block_x) * block_bytes];
+
+                if (!decode_color (read_block (block + 8), pixels)) return false;
+
+                decode_alpha (read_block (block), pixels);
+
+                for (unsigned p = 0; p < 16; ++p)
+                {
+                    unsigned x = block_x * 4 + (p >> 2);
+                    unsigned y = block_y * 4 + (p &  3);
+
+                    if (x < image.width && y < image.height) image.pixels[size_t(y) * image.width + x] = pixels[p];
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    double Texture_Cooker::psnr (const Image & a, const Image & b)
+    {
+        if (a.width != b.width || a.height != b.height || a.pixels.empty ()) return 0.0;
+
+        double squared_error = 0.0;
+
+        for (size_t index = 0; index < a.pixels.size (); ++index)
+        {
+            for (unsigned c = 0; c < 4; ++c)
+            {
+                double difference = channel (a.pixels[index], c) - channel (b.pixels[index], c);
+
+                squared_error += difference * difference;
+            }
+        }
+
+        double mean = squared_error / (a.pixels.size () * 4.0);
+
+        return mean > 0.0 ? 10.0 * std::log10 (255.0 * 255.0 / mean) : 99.0;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // TGA tipo 2 (truecolor sin comprimir). El bit 5 del descriptor indica si la primera fila del
+    // fichero es la superior, en cuyo caso se invierte para dejar la fila 0 abajo.
+
+    bool Texture_Cooker::load_tga (const std::string & path, Image & image)
+    {
+        std::ifstream file (path, std::ios::binary);
+
+        uint8_t header[18];
+
+        if (!file.read (reinterpret_cast< char * >(header), sizeof(header))) return false;
+
+        unsigned bytes_per_pixel = header[16] / 8;
+
+        if (header[2] != 2 || (bytes_per_pixel != 3 && bytes_per_pixel != 4)) return false;
+
+        image.width  = header[12] | header[13] << 8;
+        image.height = header[14] | header[15] << 8;
+        image.pixels.resize (size_t(image.width) * image.height);
+
+        file.ignore (header[0]);                        // Campo de identificación
+
+        std::vector< uint8_t > row(size_t(image.width) * bytes_per_pixel);
+
+        bool top_first = (header[17] & 0x20) != 0;
+
+        for (unsigned line = 0; line < image.height; ++line)
+        {
+            if (!file.read (reinterpret_cast< char * >(row.data ()), row.size ())) return false;
+
+            uint32_t * pixels = &image.pixels[size_t(top_first ? image.height - 1 - line : line) * image.width];
+
+            for (unsigned x = 0; x < image.width; ++x)
+            {
+                const uint8_t * bgra = &row[x * bytes_per_pixel];
+
+                pixels[x] = uint32_t(bgra[2]) | uint32_t(bgra[1]) << 8 | uint32_t(bgra[0]) << 16
+                          | uint32_t(bytes_per_pixel == 4 ? bgra[3] : 0xFF) << 24;
+            }
+        }
+
+        return true;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // KTX 1.1 en little-endian. Los bloques se guardan en el orden de la imagen (fila 0 abajo), que
+    // es el orden en el que OpenGL espera las filas al subir la textura.
+
+    bool Texture_Cooker::save_ktx (const std::string & path, const Compressed_Image & compressed)
+    {
+        const uint32_t header[13] =
+        {
+            0x04030201,                                 // endianness
+            0,                                          // glType (comprimido)
+            1,                                          // glTypeSize
+            0,                                          // glFormat (comprimido)
+            0x9278,                                     // glInternalFormat = GL_COMPRESSED_RGBA8_ETC2_EAC
+            0x1908,                                     // glBaseInternalFormat = GL_RGBA
+            compressed.width,
+            compressed.height,
+            0,                                          // pixelDepth
+            0,                                          // numberOfArrayElements
+            1,                                          // numberOfFaces
+            1,                                          // numberOfMipmapLevels
+            0,                                          // bytesOfKeyValueData
+        };
+
+        std::ofstream file (path, std::ios::binary);
+
+        if (!file) return false;
+
+        uint32_t image_size = uint32_t(compressed.blocks.size ());
+
+        file.write (reinterpret_cast< const char * >(ktx_identifier), sizeof(ktx_identifier));
+        file.write (reinterpret_cast< const char * >(header),         sizeof(header));
+        file.write (reinterpret_cast< const char * >(&image_size),    sizeof(image_size));
+        file.write (reinterpret_cast< const char * >(compressed.blocks.data ()), compressed.blocks.size ());
+
+        return bool(file);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Solo se aceptan ficheros en el mismo orden de bytes que la máquina (los que se cocinan con
+    // save_ktx() en cualquier plataforma little-endian). Los metadatos se saltan.
+
+    bool Texture_Cooker::load_ktx (const std::string & path, Compressed_Image & compressed)
+    {
+        std::ifstream file (path, std::ios::binary);
+
+        uint8_t  identifier[12];
+        uint32_t header[13];
+        uint32_t image_size;
+
+        if (!file.read (reinterpret_cast< char * >(identifier), sizeof(identifier))) return false;
+        if (!file.read (reinterpret_cast< char * >(header),     sizeof(header    ))) return false;
+
+        if (!std::equal (identifier, identifier + sizeof(identifier), ktx_identifier)) return false;
+
+        if (header[0] != 0x04030201 || header[4] != 0x9278) return false;     // endianness y glInternalFormat
+        if (header[8] != 0 || header[9] != 0 || header[10] != 1 || header[11] > 1) return false;
+
+        file.ignore (header[12]);                       // bytesOfKeyValueData
+
+        if (!file.read (reinterpret_cast< char * >(&image_size), sizeof(image_size))) return false;
+
+        unsigned blocks_x = (header[6] + 3) / 4;
+        unsigned blocks_y = (header[7] + 3) / 4;
+
+        if (image_size != size_t(blocks_x) * blocks_y * block_bytes) return false;
+
+        compressed.width  = header[6];
+        compressed.height = header[7];
+        compressed.blocks.resize (image_size);
+
+        return bool(file.read (reinterpret_cast< char * >(compressed.blocks.data ()), image_size));
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    std::string Texture_Cooker::replace_extension (const std::string & path, const char * extension)
+    {
+        size_t dot   = path.find_last_of ('.');
+        size_t slash = path.find_last_of ("/\\");
+
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return path + extension;
+
+        return path.substr (0, dot) + extension;
+    }
+
+}
@@ -0,0 +1,151 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef TEXTURE_COOKER_HEADER
+#define TEXTURE_COOKER_HEADER
+
+    #include <string>
+    #include <vector>
+    #include <cstdint>
+
+    #include "Asset_Manifest.hpp"
+    #include "Software_Canvas.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Convierte texturas RGBA a ETC2 (formato RGBA8 ETC2 + EAC, 16 bytes por bloque de 4x4
+         * píxeles, 4 veces menos memoria que RGBA sin comprimir) y las guarda en ficheros KTX que
+         * la GPU puede usar directamente. Se ejecuta fuera del juego: los bloques se reparten
+         * entre varios hilos y cada textura se decodifica de nuevo con un decodificador de
+         * referencia para medir la calidad (PSNR).
+         *
+         * El color se codifica con los modos individual y diferencial (los heredados de ETC1, que
+         * cualquier decodificador ETC2 acepta) y el alfa con EAC.
+         *
+         * El juego todavía carga los PNG originales: basics::Texture_2D solo se crea a partir de
+         * una imagen sin comprimir, así que para subir los KTX a la GPU hará falta un tipo de
+         * textura propio que llame a glCompressedTexImage2D con lo que devuelve load_ktx().
+         */
+        class Texture_Cooker
+        {
+        public:
+
+            typedef Software_Canvas::Image Image;       ///< RGBA (R en el byte de menor peso), fila 0 abajo.
+
+            /**
+             * Textura comprimida: bloques de 16 bytes (alfa EAC seguido de color ETC2) en orden de
+             * filas de bloques, empezando por la fila inferior.
+             */
+            struct Compressed_Image
+            {
+                unsigned               width;
+                unsigned               height;
+                std::vector< uint8_t > blocks;
+            };
+
+            /**
+             * Resultado de cocinar una textura del manifiesto.
+             */
+            struct Report_Entry
+            {
+                std::string  source_path;
+                std::string  cooked_path;
+                bool         cooked;                    ///< false si no se pudo leer el original o escribir el resultado.
+                unsigned     width;
+                unsigned     height;
+                size_t       uncompressed_bytes;        ///< Memoria que ocupa en RGBA sin comprimir.
+                size_t       compressed_bytes;          ///< Memoria que ocupa en ETC2.
+                double       psnr;                      ///< Calidad en dB respecto al original (RGBA).
+                float        seconds;                   ///< Tiempo de codificación.
+            };
+
+        private:
+
+            unsigned threads;
+
+        public:
+
+            /**
+             * @param threads Número de hilos de codificación (0 para usar uno por núcleo).
+             */
+            Texture_Cooker(unsigned threads = 0);
+
+        public:
+
+            /**
+             * Cocina todas las texturas de un manifiesto. El original de cada una se lee de un TGA
+             * con el mismo nombre que su ruta en el manifiesto y el resultado se escribe junto a él
+             * con extensión .ktx.
+             * @param root Carpeta a la que son relativas las rutas del manifiesto.
+             */
+            template< unsigned COUNT >
+            std::vector< Report_Entry > cook (const Asset_Manifest< COUNT > & manifest, const std::string & root)
+            {
+                std::vector< Report_Entry > report;
+
+                for (unsigned index = 0; index < COUNT; ++index)
+                {
+                    report.push_back (cook (root + "/" + manifest[index].path));
+                }
+
+                return report;
+            }
+
+            /**
+             * Cocina una textura (ver la versión que recibe un manifiesto).
+             * @param path Ruta de la textura tal y como aparece en el manifiesto.
+             */
+            Report_Entry cook (const std::string & path);
+
+            Compressed_Image encode (const Image & image) const;
+
+        public:
+
+            /**
+             * Decodificador de referencia.
+             * @return false si algún bloque usa un modo que no genera este codificador (T, H o planar).
+             */
+            static bool decode (const Compressed_Image & compressed, Image & image);
+
+            /**
+             * PSNR en dB entre dos imágenes del mismo tamaño (99 si son idénticas).
+             */
+            static double psnr (const Image & a, const Image & b);
+
+            /**
+             * Lee un TGA de 24 o 32 bits sin comprimir.
+             */
+            static bool load_tga (const std::string & path, Image & image);
+
+            /**
+             * Guarda la textura en un KTX 1.1 con formato GL_COMPRESSED_RGBA8_ETC2_EAC y sin mipmaps.
+             */
+            static bool save_ktx (const std::string & path, const Compressed_Image & compressed);
+
+            /**
+             * Lee un KTX 1.1 con formato GL_COMPRESSED_RGBA8_ETC2_EAC y un solo nivel (como los que
+             * escribe save_ktx()).
+             * @return false si no se puede leer o tiene otro formato.
+             */
+            static bool load_ktx (const std::string & path, Compressed_Image & compressed);
+
+            /**
+             * Cambia la extensión de una ruta.
+             */
+            static std::string replace_extension (const std::string & path, const char * extension);
+
+        };
+
+    }
+
+#endif
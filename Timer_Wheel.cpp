@@ -0,0 +1,360 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Timer_Wheel.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace jesus_villar_examen
+{
+
+    constexpr Timer_Wheel::Handle Timer_Wheel::invalid_handle;
+    constexpr float               Timer_Wheel::tick_duration;
+    constexpr unsigned            Timer_Wheel::slot_bits;
+    constexpr unsigned            Timer_Wheel::slots_per_level;
+    constexpr unsigned            Timer_Wheel::level_count;
+    constexpr uint32_t            Timer_Wheel::max_delay;
+    constexpr uint32_t            Timer_Wheel::nil;
+
+    // ---------------------------------------------------------------------------------------------
+    // El handle combina el índice del nodo (16 bits bajos) con su generación (16 bits altos). Como
+    // la generación nunca vale 0, un handle válido nunca coincide con invalid_handle.
+
+    static inline Timer_Wheel::Handle make_handle (uint32_t index, uint16_t generation)
+    {
+        return (uint32_t(generation) << 16) | index;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Timer_Wheel::Timer_Wheel(unsigned capacity)
+    {
+        nodes.resize (std::min (capacity, 0xFFFFu));
+        slots.resize (slots_per_level * level_count);
+        fired.reserve(nodes.size ());
+
+        for (Node & node : nodes)
+        {
+            node.generation = 1;
+        }
+
+        clear ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Timer_Wheel::Handle Timer_Wheel::schedule (float delay, Id event, uint32_t data)
+    {
+        if (free_list == nil) return invalid_handle;
+
+        uint32_t index = free_list;
+        Node   & node  = nodes[index];
+
+        free_list = node.next;
+
+        // Un temporizador vence como pronto en el siguiente tick, incluso con retardo 0:
+
+        float    ticks = std::ceil (std::max (delay, 0.f) / tick_duration);
+        uint32_t delta = ticks < 1.f ? 1 : ticks >= float(max_delay) ? max_delay : uint32_t(ticks);
+
+        node.due_tick = current_tick + delta;
+        node.event    = event;
+        node.data     = data;
+
+        insert (index);
+
+        ++active_count;
+
+        return make_handle (index, node.generation);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    bool Timer_Wheel::cancel (Handle handle)
+    {
+        uint32_t index = handle & 0xFFFFu;
+
+        if (handle != invalid_handle && index < nodes.size ())
+        {
+            Node & node = nodes[index];
+
+            if (node.slot != nil && node.generation == uint16_t(handle >> 16))
+            {
+                unlink  (index);
+                release (index);
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Timer_Wheel::clear ()
+    {
+        std::fill (slots.begin (), slots.end (), nil);
+
+        // Todos los nodos pasan a la lista libre. Se invalidan los handles de los que estaban en uso:
+
+        for (uint32_t index = 0, count = uint32_t(nodes.size ()); index < count; ++index)
+        {
+            Node & node = nodes[index];
+
+            if (node.slot != nil && ++node.generation == 0) node.generation = 1;
+
+            node.slot = nil;
+            node.next = index + 1 < count ? index + 1 : nil;
+        }
+
+        free_list        = nodes.empty () ? nil : 0;
+        current_tick     = 0;
+        accumulated_time = 0.f;
+        active_count     = 0;
+
+        fired.clear ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Se avanza tick a tick. Cuando el índice de un nivel da la vuelta se reparten los nodos del
+    // hueco correspondiente del nivel superior entre los niveles inferiores (cascada) y después se
+    // recogen los nodos del hueco actual del nivel 0, que son justo los que vencen en este tick.
+
+    void Timer_Wheel::collect_expired (float time)
+    {
+        accumulated_time += time;
+
+        while (accumulated_time >= tick_duration)
+        {
+            accumulated_time -= tick_duration;
+
+            ++current_tick;
+
+            for (unsigned level = 1; level < level_count; ++level)
+            {
+                if ((current_tick >> (slot_bits * (level - 1))) & (slots_per_level - 1)) break;
+
+                cascade (level);
+            }
+
+            uint32_t & head = slots[current_tick & (slots_per_level - 1)];
+
+            while (head != nil)
+            {
+                uint32_t index = head;
+                Node   & node  = nodes[index];
+
+                fired.push_back ({ node.event, node.data });
+
+                unlink  (index);
+                release (index);
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Se elige el nivel más bajo cuyo alcance cubre el tiempo que le falta al temporizador y, dentro
+    // de él, el hueco que indican los bits del tick de vencimiento correspondientes a ese nivel.
+
+    void Timer_Wheel::insert (uint32_t index)
+    {
+        Node   & node  = nodes[index];
+        uint32_t delta = node.due_tick - current_tick;
+        unsigned level = 0;
+
+        while (level + 1 < level_count && delta >= (1u << (slot_bits * (level + 1)))) ++level;
+
+        uint32_t slot = level * slots_per_level + ((node.due_tick >> (slot_bits * level)) & (slots_per_level - 1));
+
+        node.slot     = slot;
+        node.previous = nil;
+        node.next     = slots[slot];
+
+        if (node.next != nil) nodes[node.next].previous = index;
+
+        slots[slot] = index;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Timer_Wheel::unlink (uint32_t index)
+    {
+        Node & node = nodes[index];
+
+        if (node.previous != nil) nodes[node.previous].next = node.next; else slots[node.slot] = node.next;
+        if (node.next     != nil) nodes[node.next].previous = node.previous;
+
+        node.slot = nil;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Timer_Wheel::release (uint32_t index)
+    {
+        Node & node = nodes[index];
+
+        if (++node.generation == 0) node.generation = 1;
+
+        node.next = free_list;
+        free_list = index;
+
+        --active_count;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Timer_Wheel::cascade (unsigned level)
+    {
+        uint32_t slot = level * slots_per_level + ((current_tick >> (slot_bits * level)) & (slots_per_level - 1));
+        uint32_t head = slots[slot];
+
+        slots[slot] = nil;
+
+        while (head != nil)
+        {
+            uint32_t index = head;
+
+            head = nodes[index].next;
+
+            insert (index);
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // El estado se guarda campo a campo como enteros little-endian (los float por su
+    // representación IEEE), de modo que el formato no depende del relleno de Node ni del orden de
+    // bytes de la máquina. Empieza por la capacidad para poder validar la carga:
+    //
+    //   capacity, free_list, current_tick, accumulated_time, active_count   (u32)
+    //   slots                                                                (u32 cada uno)
+    //   due_tick, event, data, previous, next, slot, generation (u16)       (por cada nodo)
+
+    static void write_uint (std::ostream & stream, uint32_t value, unsigned bytes = 4)
+    {
+        char data[4];
+
+        for (unsigned byte = 0; byte < bytes; ++byte) data[byte] = char(value >> (byte * 8));
+
+        stream.write (data, bytes);
+    }
+
+    static bool read_uint (std::istream & stream, uint32_t & value, unsigned bytes = 4)
+    {
+        unsigned char data[4];
+
+        if (!stream.read (reinterpret_cast< char * >(data), bytes)) return false;
+
+        value = 0;
+
+        for (unsigned byte = 0; byte < bytes; ++byte) value |= uint32_t(data[byte]) << (byte * 8);
+
+        return true;
+    }
+
+    void Timer_Wheel::save (std::ostream & stream) const
+    {
+        uint32_t accumulated_bits;
+
+        std::memcpy (&accumulated_bits, &accumulated_time, sizeof(accumulated_bits));
+
+        write_uint (stream, uint32_t(nodes.size ()));
+        write_uint (stream, free_list);
+        write_uint (stream, current_tick);
+        write_uint (stream, accumulated_bits);
+        write_uint (stream, active_count);
+
+        for (uint32_t head : slots) write_uint (stream, head);
+
+        for (const Node & node : nodes)
+        {
+            write_uint (stream, node.due_tick);
+            write_uint (stream, node.event);
+            write_uint (stream, node.data);
+            write_uint (stream, node.previous);
+            write_uint (stream, node.next);
+            write_uint (stream, node.slot);
+            write_uint (stream, node.generation, 2);
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    bool Timer_Wheel::load (std::istream & stream)
+    {
+        uint32_t capacity;
+
+        if (!read_uint (stream, capacity) || capacity != nodes.size ())
+        {
+            return false;
+        }
+
+        // Se lee sobre copias para no dejar la rueda a medias si el stream está truncado o los
+        // enlaces apuntan fuera del pool:
+
+        uint32_t                                 loaded_free_list = 0;
+        uint32_t                                 loaded_tick = 0;
+        uint32_t                                 loaded_accumulated = 0;
+        uint32_t                                 loaded_active = 0;
+        Tracked_Vector< uint32_t, MEMORY_POOLS > loaded_slots (slots.size ());
+        Tracked_Vector< Node    , MEMORY_POOLS > loaded_nodes (nodes.size ());
+
+        auto valid_link = [capacity] (uint32_t index) { return index == nil || index < capacity; };
+
+        bool valid = read_uint (stream, loaded_free_list  )
+                  && read_uint (stream, loaded_tick       )
+                  && read_uint (stream, loaded_accumulated)
+                  && read_uint (stream, loaded_active     )
+                  && valid_link (loaded_free_list) && loaded_active <= capacity;
+
+        for (uint32_t & head : loaded_slots)
+        {
+            valid = valid && read_uint (stream, head) && valid_link (head);
+        }
+
+        for (Node & node : loaded_nodes)
+        {
+            uint32_t event = 0, generation = 0;
+
+            valid = valid
+                 && read_uint (stream, node.due_tick)
+                 && read_uint (stream, event        )
+                 && read_uint (stream, node.data    )
+                 && read_uint (stream, node.previous)
+                 && read_uint (stream, node.next    )
+                 && read_uint (stream, node.slot    )
+                 && read_uint (stream, generation, 2)
+                 && valid_link (node.previous) && valid_link (node.next)
+                 && (node.slot == nil || node.slot < loaded_slots.size ()) && generation != 0;
+
+            node.event      = Id(event);
+            node.generation = uint16_t(generation);
+        }
+
+        if (!valid) return false;
+
+        free_list    = loaded_free_list;
+        current_tick = loaded_tick;
+        active_count = loaded_active;
+
+        std::memcpy (&accumulated_time, &loaded_accumulated, sizeof(accumulated_time));
+
+        slots.swap (loaded_slots);
+        nodes.swap (loaded_nodes);
+
+        fired.clear ();
+
+        return true;
+    }
+
+}
@@ -0,0 +1,168 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef TIMER_WHEEL_HEADER
+#define TIMER_WHEEL_HEADER
+
+    #include <vector>
+    #include <cstdint>
+    #include <istream>
+    #include <ostream>
+
+    #include <basics/Id>
+
+    #include "Memory_Tracker.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        using basics::Id;
+
+        /**
+         * Rueda de temporizadores jerárquica basada en el tiempo de simulación. Los temporizadores
+         * se guardan en un pool de tamaño fijo enlazados en listas intrusivas, por lo que programar
+         * y cancelar son O(1) y no reservan memoria. En lugar de callbacks arbitrarios cada
+         * temporizador lleva un Id de evento y un dato, lo que permite serializar su estado junto
+         * con el resto de la simulación.
+         */
+        class Timer_Wheel
+        {
+        public:
+
+            typedef uint32_t Handle;                                ///< Identifica un temporizador programado.
+
+            static constexpr Handle   invalid_handle = 0;           ///< Handle que nunca corresponde a un temporizador.
+            static constexpr float    tick_duration  = 1.f / 100;   ///< Duración de un tick en segundos de simulación.
+
+        private:
+
+            static constexpr unsigned slot_bits      = 6;
+            static constexpr unsigned slots_per_level = 1u << slot_bits;
+            static constexpr unsigned level_count    = 4;
+            static constexpr uint32_t max_delay      = (1u << (slot_bits * level_count)) - 1;
+            static constexpr uint32_t nil            = 0xFFFFFFFFu;
+
+            /**
+             * Nodo del pool. Los nodos libres se enlazan en la lista libre usando 'next'.
+             */
+            struct Node
+            {
+                uint32_t due_tick;                  ///< Tick en el que vence el temporizador.
+                Id       event;                     ///< Id que se entrega al vencer.
+                uint32_t data;                      ///< Dato que se entrega al vencer.
+                uint32_t previous;                  ///< Nodo anterior en la lista del hueco (o nil).
+                uint32_t next;                      ///< Nodo siguiente en la lista del hueco o en la lista libre (o nil).
+                uint32_t slot;                      ///< Hueco de la rueda en el que está (o nil si está libre).
+                uint16_t generation;                ///< Se incrementa al liberar el nodo para invalidar handles antiguos.
+            };
+
+            /**
+             * Temporizador vencido pendiente de notificar.
+             */
+            struct Fired
+            {
+                Id       event;
+                uint32_t data;
+            };
+
+        private:
+
+            Tracked_Vector< Node    , MEMORY_POOLS > nodes;  ///< Pool de temporizadores.
+            Tracked_Vector< uint32_t, MEMORY_POOLS > slots;  ///< Primer nodo de cada hueco de cada nivel.
+            Tracked_Vector< Fired   , MEMORY_POOLS > fired;  ///< Temporizadores vencidos en el paso actual.
+
+            uint32_t free_list;                                     ///< Primer nodo libre del pool.
+            uint32_t current_tick;                                  ///< Tick de simulación actual.
+            float    accumulated_time;                              ///< Tiempo acumulado que aún no completa un tick.
+            unsigned active_count;                                  ///< Número de temporizadores programados.
+
+        public:
+
+            /**
+             * Reserva de una vez toda la memoria necesaria.
+             * @param capacity Número máximo de temporizadores programados a la vez (como mucho 65535).
+             */
+            Timer_Wheel(unsigned capacity);
+
+        public:
+
+            unsigned get_active_count () const { return active_count;                 }
+            unsigned get_capacity     () const { return unsigned(nodes.size ());       }
+            uint32_t get_current_tick () const { return current_tick;                 }
+
+        public:
+
+            /**
+             * Programa un temporizador.
+             * @param delay Segundos de simulación que deben pasar hasta que venza.
+             * @param event Id que se entregará al vencer.
+             * @param data Dato opcional que se entregará al vencer.
+             * @return Handle con el que se puede cancelar o invalid_handle si el pool está lleno.
+             */
+            Handle schedule (float delay, Id event, uint32_t data = 0);
+
+            /**
+             * Cancela un temporizador. Cancelar uno que ya ha vencido o ha sido cancelado no tiene efecto.
+             * @return true si el temporizador estaba programado.
+             */
+            bool cancel (Handle handle);
+
+            /**
+             * Cancela todos los temporizadores y vuelve al tick 0.
+             */
+            void clear ();
+
+            /**
+             * Avanza la rueda y, cuando ha terminado, invoca al manejador con cada temporizador
+             * vencido (en orden de vencimiento). El manejador puede programar o cancelar otros
+             * temporizadores.
+             * @param time Segundos de simulación que se deben avanzar.
+             * @param handler Función invocable como handler(Id event, uint32_t data).
+             */
+            template< typename HANDLER >
+            void advance (float time, HANDLER && handler)
+            {
+                collect_expired (time);
+
+                for (const Fired & item : fired)
+                {
+                    handler (item.event, item.data);
+                }
+
+                fired.clear ();
+            }
+
+        public:
+
+            /**
+             * Escribe el estado completo de la rueda (incluidos los handles vigentes) en binario.
+             */
+            void save (std::ostream & stream) const;
+
+            /**
+             * Restablece un estado guardado con save() en una rueda de la misma capacidad.
+             * @return false si el stream no contiene un estado válido (la rueda no se modifica).
+             */
+            bool load (std::istream & stream);
+
+        private:
+
+            void collect_expired (float time);
+            void insert          (uint32_t index);
+            void unlink          (uint32_t index);
+            void release         (uint32_t index);
+            void cascade         (unsigned level);
+
+        };
+
+    }
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Transform_Hierarchy.hpp"
+
+#include <numeric>
+#include <algorithm>
+#include <type_traits>
+
+namespace jesus_villar_examen
+{
+
+    constexpr Transform_Hierarchy::Node Transform_Hierarchy::no_parent;            ///< Nodo sin padre.
+
+    // ---------------------------------------------------------------------------------------------
+    // Los nodos nuevos se añaden al final. Como el padre ya existe, su profundidad es conocida; el
+    // orden por profundidad se restablece en el siguiente update().
+
+    Transform_Hierarchy::Node Transform_Hierarchy::attach (GameObject * object, Node parent, const Point2f & local_position)
+    {
+        Node     node = Node(slot_of_node.size ());
+        uint32_t slot = uint32_t(node_of_slot.size ());
+
+        uint32_t parent_index = parent == no_parent ? no_parent : slot_of_node[parent];
+        uint16_t node_depth   = parent == no_parent ? 0 : uint16_t(depth[parent_index] + 1);
+
+        parent_slot .push_back (parent_index);
+        depth       .push_back (node_depth);
+        local_x     .push_back (parent == no_parent ? 0.f : local_position[0]);
+        local_y     .push_back (parent == no_parent ? 0.f : local_position[1]);
+        world_x     .push_back (object ? object->get_position_x () : 0.f);
+        world_y     .push_back (object ? object->get_position_y () : 0.f);
+        dirty       .push_back (1);
+        objects     .push_back (object);
+        node_of_slot.push_back (node);
+        slot_of_node.push_back (slot);
+
+        if (slot > 0 && depth[slot - 1] > node_depth) sorted = false;
+
+        return node;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Transform_Hierarchy::set_local_position (Node node, const Point2f & local_position)
+    {
+        uint32_t slot = slot_of_node[node];
+
+        local_x[slot] = local_position[0];
+        local_y[slot] = local_position[1];
+        dirty  [slot] = 1;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Transform_Hierarchy::clear ()
+    {
+        parent_slot .clear ();
+        depth       .clear ();
+        local_x     .clear ();
+        local_y     .clear ();
+        world_x     .clear ();
+        world_y     .clear ();
+        dirty       .clear ();
+        objects     .clear ();
+        node_of_slot.clear ();
+        slot_of_node.clear ();
+
+        sorted = true;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Como cada padre está antes que sus hijos, basta con un recorrido: cuando se recalcula un nodo
+    // se marca como sucio y sus hijos, que vienen después, lo verán al llegar a ellos.
+
+    void Transform_Hierarchy::update ()
+    {
+        if (!sorted) sort_by_depth ();
+
+        const size_t count = node_of_slot.size ();
+
+        for (size_t slot = 0; slot < count; ++slot)
+        {
+            uint32_t parent = parent_slot[slot];
+
+            if (parent == no_parent)
+            {
+                if (objects[slot])
+                {
+                    float x = objects[slot]->get_position_x ();
+                    float y = objects[slot]->get_position_y ();
+
+                    dirty  [slot] |= uint8_t(x != world_x[slot] || y != world_y[slot]);
+                    world_x[slot]  = x;
+                    world_y[slot]  = y;
+                }
+            }
+            else if (dirty[slot] | dirty[parent])
+            {
+                dirty  [slot] = 1;
+                world_x[slot] = world_x[parent] + local_x[slot];
+                world_y[slot] = world_y[parent] + local_y[slot];
+
+                if (objects[slot]) objects[slot]->set_position ({ world_x[slot], world_y[slot] });
+            }
+        }
+
+        std::fill (dirty.begin (), dirty.end (), uint8_t(0));
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Transform_Hierarchy::sort_by_depth ()
+    {
+        const size_t count = node_of_slot.size ();
+
+        std::vector< uint32_t > order(count);
+
+        std::iota (order.begin (), order.end (), 0u);
+        std::stable_sort (order.begin (), order.end (), [this] (uint32_t a, uint32_t b) { return depth[a] < depth[b]; });
+
+        // order[nuevo] = antiguo. Se aplica la permutación a cada array y se traducen los padres:
+
+        std::vector< uint32_t > new_slot(count);
+
+        for (uint32_t slot = 0; slot < count; ++slot) new_slot[order[slot]] = slot;
+
+        auto permute = [&order, count] (auto & values)
+        {
+            typename std::decay< decltype(values) >::type permuted(count);
+
+            for (size_t slot = 0; slot < count; ++slot) permuted[slot] = values[order[slot]];
+
+            values.swap (permuted);
+        };
+
+        permute (parent_slot);
+        permute (depth);
+        permute (local_x);
+        permute (local_y);
+        permute (world_x);
+        permute (world_y);
+        permute (dirty);
+        permute (objects);
+        permute (node_of_slot);
+
+        for (uint32_t slot = 0; slot < count; ++slot)
+        {
+            if (parent_slot[slot] != no_parent) parent_slot[slot] = new_slot[parent_slot[slot]];
+
+            slot_of_node[node_of_slot[slot]] = slot;
+        }
+
+        sorted = true;
+    }
+
+}
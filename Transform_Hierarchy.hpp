@@ -0,0 +1,119 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef TRANSFORM_HIERARCHY_HEADER
+#define TRANSFORM_HIERARCHY_HEADER
+
+    #include <vector>
+    #include <cstdint>
+
+    #include "GameObject.hpp"
+    #include "Memory_Tracker.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Jerarquía de transformaciones (traslaciones 2D) para entidades compuestas de varias
+         * partes. Cada nodo tiene una posición local relativa a su padre y una posición en el
+         * mundo. Los nodos raíz siguen al GameObject al que están asociados (que es el que mueve la
+         * simulación) y los hijos escriben su posición del mundo en el suyo. Un nodo sin GameObject
+         * sirve como punto de referencia (por ejemplo, el cañón de un barco).
+         *
+         * Los nodos se guardan en arrays paralelos ordenados por profundidad, de modo que todos los
+         * padres preceden a sus hijos y update() recalcula las posiciones en un único recorrido
+         * lineal (en anchura) sin recursión. Solo se recalculan los nodos marcados como sucios o
+         * cuyo padre ha cambiado en este mismo recorrido.
+         */
+        class Transform_Hierarchy
+        {
+        public:
+
+            typedef uint32_t Node;                      ///< Identificador estable de un nodo.
+
+            static constexpr Node no_parent = Node(-1);
+
+        private:
+
+            // Datos por hueco (en orden de profundidad):
+
+            Tracked_Vector< uint32_t   , MEMORY_ENTITIES > parent_slot;   ///< Hueco del padre o no_parent.
+            Tracked_Vector< uint16_t   , MEMORY_ENTITIES > depth;
+            Tracked_Vector< float      , MEMORY_ENTITIES > local_x;
+            Tracked_Vector< float      , MEMORY_ENTITIES > local_y;
+            Tracked_Vector< float      , MEMORY_ENTITIES > world_x;
+            Tracked_Vector< float      , MEMORY_ENTITIES > world_y;
+            Tracked_Vector< uint8_t    , MEMORY_ENTITIES > dirty;
+            Tracked_Vector< GameObject*, MEMORY_ENTITIES > objects;
+            Tracked_Vector< Node       , MEMORY_ENTITIES > node_of_slot;
+
+            Tracked_Vector< uint32_t   , MEMORY_ENTITIES > slot_of_node;  ///< Hueco que ocupa cada nodo.
+            bool                      sorted;           ///< false si se han añadido nodos desde el último update().
+
+        public:
+
+            Transform_Hierarchy() : sorted(true)
+            {
+            }
+
+        public:
+
+            /**
+             * Añade un nodo.
+             * @param object GameObject que representa el nodo o nullptr. Si el nodo es una raíz, su
+             *      posición se lee del GameObject; si no, se escribe en él.
+             * @param parent Nodo padre o no_parent.
+             * @param local_position Posición relativa al padre (ignorada en las raíces).
+             */
+            Node attach (GameObject * object, Node parent = no_parent, const Point2f & local_position = { 0.f, 0.f });
+
+            /**
+             * Cambia la posición de un nodo respecto a su padre. Sus descendientes se actualizan en
+             * el siguiente update().
+             */
+            void set_local_position (Node node, const Point2f & local_position);
+
+            /**
+             * Posición en el mundo calculada en el último update().
+             */
+            Point2f get_world_position (Node node) const
+            {
+                uint32_t slot = slot_of_node[node];
+
+                return { world_x[slot], world_y[slot] };
+            }
+
+            size_t size () const
+            {
+                return node_of_slot.size ();
+            }
+
+            void clear ();
+
+            /**
+             * Marca como sucias las raíces que se han movido y recalcula, en orden de profundidad,
+             * las posiciones de los nodos sucios y de todos sus descendientes.
+             */
+            void update ();
+
+        private:
+
+            /**
+             * Reordena los arrays por profundidad conservando el orden de inserción entre nodos de
+             * la misma profundidad.
+             */
+            void sort_by_depth ();
+
+        };
+
+    }
+
+#endif
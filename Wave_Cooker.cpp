@@ -0,0 +1,119 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Wave_Cooker.hpp"
+
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+
+namespace jesus_villar_examen
+{
+
+    Wave_Cooker::Report Wave_Cooker::cook (const std::string & source_path, const std::string & cooked_path)
+    {
+        Report report { source_path, cooked_path, false, 0, 0, 0.f, 0, 0 };
+
+        std::ifstream source (source_path);
+
+        if (!source) return report;
+
+        std::vector< Wave_Timeline::Event > events;
+
+        if (!parse (source, events, report.error_line)) return report;
+
+        source.clear ();
+
+        report.source_bytes = size_t(source.seekg (0, std::ios::end).tellg ());
+
+        std::stable_sort
+        (
+            events.begin (), events.end (),
+            [] (const Wave_Timeline::Event & a, const Wave_Timeline::Event & b) { return a.time < b.time; }
+        );
+
+        std::vector< uint8_t > cooked = Wave_Timeline::encode (events);
+
+        std::ofstream file (cooked_path, std::ios::binary);
+
+        file.write (reinterpret_cast< const char * >(cooked.data ()), cooked.size ());
+
+        report.cooked       = bool(file);
+        report.events       = unsigned(events.size ());
+        report.duration     = events.empty () ? 0.f : events.back ().time;
+        report.cooked_bytes = cooked.size ();
+
+        return report;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    bool Wave_Cooker::parse (std::istream & source, std::vector< Wave_Timeline::Event > & events, unsigned & error_line)
+    {
+        std::string line;
+        unsigned    line_number = 0;
+
+        error_line = 0;
+
+        while (std::getline (source, line))
+        {
+            line_number++;
+            line = line.substr (0, line.find ('#'));
+
+            if (line.find_first_not_of (" \t\r") == std::string::npos) continue;
+
+            std::istringstream  fields (line);
+            std::string         kind;
+            std::string         extra;
+            Wave_Timeline::Event event { 0.f, Wave_Timeline::SPAWN, 0, 0.f, 0.f, 0 };
+
+            bool valid = bool(fields >> event.time >> kind) && event.time >= 0.f;
+
+            if (valid && kind == "spawn")
+            {
+                valid = bool(fields >> event.submarine >> event.y >> event.speed) && event.y >= 0.f;
+            }
+            else if (valid && kind == "fire")
+            {
+                std::string submarine;
+
+                event.kind = Wave_Timeline::FIRE;
+                valid      = bool(fields >> submarine >> event.volley) && event.volley > 0;
+
+                if (valid && submarine == "*")
+                {
+                    event.submarine = Wave_Timeline::any_submarine;
+                }
+                else if (valid)
+                {
+                    std::istringstream number (submarine);
+
+                    valid = bool(number >> event.submarine) && number.eof ();
+                }
+            }
+            else
+            {
+                valid = false;
+            }
+
+            if (!valid || fields >> extra)
+            {
+                error_line = line_number;
+                return false;
+            }
+
+            events.push_back (event);
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,68 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef WAVE_COOKER_HEADER
+#define WAVE_COOKER_HEADER
+
+    #include <string>
+    #include <vector>
+    #include <istream>
+
+    #include "Wave_Timeline.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Convierte la descripción en texto de un nivel en una Wave_Timeline. Se ejecuta fuera del
+         * juego. Cada línea es un evento (lo que sigue a '#' se ignora):
+         *
+         *   <segundos> spawn <submarino> <altura> <velocidad>
+         *   <segundos> fire  <submarino o *> <balas>
+         *
+         * Los eventos pueden aparecer en cualquier orden: se ordenan por tiempo conservando el
+         * orden de los que coinciden.
+         */
+        class Wave_Cooker
+        {
+        public:
+
+            struct Report
+            {
+                std::string  source_path;
+                std::string  cooked_path;
+                bool         cooked;                    ///< false si no se pudo leer el texto o escribir el resultado.
+                unsigned     error_line;                ///< Primera línea mal formada (0 si no hay ninguna).
+                unsigned     events;
+                float        duration;                  ///< Segundos hasta el último evento.
+                size_t       source_bytes;
+                size_t       cooked_bytes;
+            };
+
+        public:
+
+            /**
+             * Cocina un fichero de texto. No se escribe nada si alguna línea está mal formada.
+             */
+            static Report cook (const std::string & source_path, const std::string & cooked_path);
+
+            /**
+             * Lee los eventos de un texto en el orden en que aparecen.
+             * @param error_line Se escribe la primera línea mal formada (0 si no hay ninguna).
+             * @return false si alguna línea está mal formada.
+             */
+            static bool parse (std::istream & source, std::vector< Wave_Timeline::Event > & events, unsigned & error_line);
+
+        };
+
+    }
+
+#endif
@@ -0,0 +1,257 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Wave_Timeline.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace jesus_villar_examen
+{
+
+    constexpr uint32_t Wave_Timeline::any_submarine;                ///< Submarino de un FIRE que elige la IA.
+    constexpr uint16_t Wave_Timeline::version;                      ///< Versión del formato que se escribe y se acepta.
+    constexpr size_t   Wave_Timeline::header_size;                  ///< Bytes de la cabecera.
+
+    static const uint8_t magic[4] = { 'S', 'W', 'T', 'L' };
+
+    // ---------------------------------------------------------------------------------------------
+    // Lectura y escritura de enteros. Un varint de 32 bits ocupa como mucho 5 bytes; si no termina
+    // antes del final de los datos se considera mal formado.
+
+    static bool read_varint (const uint8_t * & data, const uint8_t * end, uint32_t & value)
+    {
+        value = 0;
+
+        for (unsigned shift = 0; shift < 35 && data < end; shift += 7)
+        {
+            uint8_t byte = *data++;
+
+            value |= uint32_t(byte & 0x7F) << shift;
+
+            if (!(byte & 0x80)) return true;
+        }
+
+        return false;
+    }
+
+    static void write_varint (std::vector< uint8_t > & data, uint32_t value)
+    {
+        for ( ; value >= 0x80; value >>= 7)
+        {
+            data.push_back (uint8_t(value | 0x80));
+        }
+
+        data.push_back (uint8_t(value));
+    }
+
+    static uint32_t read_uint (const uint8_t * data, unsigned bytes)
+    {
+        uint32_t value = 0;
+
+        for (unsigned byte = 0; byte < bytes; ++byte) value |= uint32_t(data[byte]) << (byte * 8);
+
+        return value;
+    }
+
+    static void write_uint (std::vector< uint8_t > & data, uint32_t value, unsigned bytes)
+    {
+        for (unsigned byte = 0; byte < bytes; ++byte) data.push_back (uint8_t(value >> (byte * 8)));
+    }
+
+    // Zigzag: 0, -1, 1, -2... se guardan como 0, 1, 2, 3... para que los negativos pequeños
+    // también ocupen pocos bytes.
+
+    static uint32_t zigzag_encode (int32_t value)
+    {
+        return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+    }
+
+    static int32_t zigzag_decode (uint32_t value)
+    {
+        return int32_t(value >> 1) ^ -int32_t(value & 1);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Wave_Timeline::Wave_Timeline()
+    :
+        event_count (0),
+        duration    (0)
+    {
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    bool Wave_Timeline::open (const std::string & path)
+    {
+        event_count = 0;
+        duration    = 0;
+
+        if (!file.open (path)) return false;
+
+        const uint8_t * header = file.get_data ();
+
+        bool valid = file.get_size () >= header_size
+                  && std::equal (magic, magic + 4, header)
+                  && read_uint (header + 4, 2) == version
+                  && read_uint (header + 6, 2) == header_size;
+
+        if (!valid)
+        {
+            file.close ();
+            return false;
+        }
+
+        event_count = read_uint (header +  8, 4);
+        duration    = read_uint (header + 12, 4);
+
+        return true;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    std::vector< uint8_t > Wave_Timeline::encode (const std::vector< Event > & events)
+    {
+        std::vector< uint8_t > data (magic, magic + 4);
+
+        write_uint (data, version,                  2);
+        write_uint (data, header_size,              2);
+        write_uint (data, uint32_t(events.size ()), 4);
+        write_uint (data, 0,                        4);         // Duración, se completa al final
+
+        uint32_t time = 0;
+
+        for (const Event & event : events)
+        {
+            uint32_t event_time = std::max (uint32_t(std::lround (std::max (event.time, 0.f) * 1000.f)), time);
+
+            write_varint (data, (event_time - time) << 2 | event.kind);
+
+            time = event_time;
+
+            if (event.kind == SPAWN)
+            {
+                write_varint (data, event.submarine);
+                write_varint (data, uint32_t(std::lround (std::max (event.y, 0.f))));
+                write_varint (data, zigzag_encode (int32_t(std::lround (event.speed))));
+            }
+            else
+            {
+                write_varint (data, event.submarine == any_submarine ? 0 : event.submarine + 1);
+                write_varint (data, event.volley);
+            }
+        }
+
+        for (unsigned byte = 0; byte < 4; ++byte) data[12 + byte] = uint8_t(time >> (byte * 8));
+
+        return data;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Wave_Timeline::Cursor::Cursor()
+    :
+        timeline  (nullptr),
+        next      (nullptr),
+        remaining (0),
+        next_time (0),
+        next_kind (SPAWN),
+        elapsed   (0.0)
+    {
+    }
+
+    Wave_Timeline::Cursor::Cursor(const Wave_Timeline & timeline)
+    :
+        timeline (&timeline)
+    {
+        rewind ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Wave_Timeline::Cursor::rewind ()
+    {
+        next      = nullptr;
+        remaining = 0;
+        next_time = 0;
+        next_kind = SPAWN;
+        elapsed   = 0.0;
+
+        if (timeline && timeline->is_open ())
+        {
+            next      = timeline->file.get_data () + header_size;
+            remaining = timeline->event_count;
+
+            if (remaining > 0 && !read_timing ()) remaining = 0;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // Lee el varint con el que empieza el siguiente evento (tiempo y tipo), que es lo único que hace
+    // falta para saber si vence en este paso. Los parámetros se leen en decode().
+
+    bool Wave_Timeline::Cursor::read_timing ()
+    {
+        const uint8_t * end = timeline->file.get_data () + timeline->file.get_size ();
+
+        uint32_t timing;
+
+        if (!read_varint (next, end, timing)) return false;
+
+        next_time += timing >> 2;
+        next_kind  = Event_Kind(timing & 3);
+
+        return next_kind == SPAWN || next_kind == FIRE;
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    bool Wave_Timeline::Cursor::decode (Event & event)
+    {
+        const uint8_t * end = timeline->file.get_data () + timeline->file.get_size ();
+
+        event.time      = next_time * .001f;
+        event.kind      = next_kind;
+        event.submarine = any_submarine;
+        event.y         = 0.f;
+        event.speed     = 0.f;
+        event.volley    = 0;
+
+        uint32_t first, second, third = 0;
+
+        bool valid = read_varint (next, end, first) && read_varint (next, end, second) && (next_kind != SPAWN || read_varint (next, end, third));
+
+        if (valid)
+        {
+            if (next_kind == SPAWN)
+            {
+                event.submarine = first;
+                event.y         = float(second);
+                event.speed     = float(zigzag_decode (third));
+            }
+            else
+            {
+                event.submarine = first == 0 ? any_submarine : first - 1;
+                event.volley    = second;
+            }
+
+            remaining--;
+        }
+
+        // Si este evento o el tiempo del siguiente están mal formados no se lee nada más:
+
+        if (!valid || (remaining > 0 && !read_timing ())) remaining = 0;
+
+        return valid;
+    }
+
+}
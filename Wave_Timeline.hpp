@@ -0,0 +1,190 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef WAVE_TIMELINE_HEADER
+#define WAVE_TIMELINE_HEADER
+
+    #include <string>
+    #include <vector>
+    #include <cstdint>
+
+    #include "Mapped_File.hpp"
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Línea de tiempo de un nivel diseñado: cuándo aparece cada submarino y cuándo dispara.
+         * Se genera con Wave_Cooker a partir de un fichero de texto y se lee proyectada en memoria,
+         * sin cargarla: un Cursor decodifica solo los eventos que vencen en cada paso, sin reservar
+         * memoria, así que lo que ocupa no depende de la longitud del nivel. Varias escenas pueden
+         * compartir la misma Wave_Timeline con un Cursor cada una.
+         *
+         * Formato (little-endian):
+         *
+         *   Cabecera de 16 bytes: "SWTL", versión (uint16), tamaño de la cabecera (uint16),
+         *   número de eventos (uint32) y milisegundo del último evento (uint32).
+         *
+         *   Eventos ordenados por tiempo. Cada uno empieza con un varint que lleva los
+         *   milisegundos desde el evento anterior desplazados 2 bits y el tipo en esos 2 bits,
+         *   seguido de sus parámetros:
+         *     SPAWN: submarino (varint), altura (varint) y velocidad (varint zigzag), en unidades
+         *            virtuales enteras.
+         *     FIRE:  submarino + 1 (varint, 0 para el que elija la IA) y balas (varint).
+         *
+         * Los varint guardan 7 bits por byte, empezando por los de menor peso, con el bit alto
+         * a 1 en todos los bytes menos el último.
+         */
+        class Wave_Timeline
+        {
+        public:
+
+            enum Event_Kind
+            {
+                SPAWN = 0,                              ///< Aparece un submarino.
+                FIRE  = 1,                              ///< Dispara un submarino.
+            };
+
+            static constexpr uint32_t any_submarine = 0xFFFFFFFF;      ///< Submarino de un FIRE que elige la IA.
+            static constexpr uint16_t version       = 1;               ///< Versión del formato que se escribe y se acepta.
+            static constexpr size_t   header_size   = 16;              ///< Bytes de la cabecera.
+
+            struct Event
+            {
+                float      time;                        ///< Segundos desde el comienzo.
+                Event_Kind kind;
+                uint32_t   submarine;                   ///< Índice del submarino (o any_submarine).
+                float      y;                           ///< Altura a la que aparece (SPAWN).
+                float      speed;                       ///< Velocidad horizontal (SPAWN). Si es negativa entra por la derecha.
+                unsigned   volley;                      ///< Balas que dispara (FIRE).
+            };
+
+            /**
+             * Posición de lectura en una línea de tiempo. Solo guarda dónde empieza el siguiente
+             * evento y cuándo vence.
+             */
+            class Cursor
+            {
+                const Wave_Timeline * timeline;
+                const uint8_t       * next;             ///< Parámetros del siguiente evento.
+                uint32_t              remaining;        ///< Eventos por decodificar.
+                uint32_t              next_time;        ///< Milisegundo en el que vence el siguiente evento.
+                Event_Kind            next_kind;
+                double                elapsed;          ///< Milisegundos avanzados.
+
+            public:
+
+                Cursor();
+
+                explicit Cursor(const Wave_Timeline & timeline);
+
+            public:
+
+                /**
+                 * Vuelve al comienzo de la línea de tiempo.
+                 */
+                void rewind ();
+
+                /**
+                 * Avanza el tiempo y llama a handler(const Event &) con cada evento que vence, en
+                 * orden. Un evento mal formado (fichero truncado) termina la línea de tiempo.
+                 * @return Número de eventos decodificados.
+                 */
+                template< typename HANDLER >
+                unsigned advance (float time, HANDLER && handler)
+                {
+                    elapsed += double(time) * 1000.0;
+
+                    unsigned decoded = 0;
+                    Event    event;
+
+                    while (remaining > 0 && next_time <= elapsed && decode (event))
+                    {
+                        handler (static_cast< const Event & >(event));
+
+                        decoded++;
+                    }
+
+                    return decoded;
+                }
+
+                bool is_finished () const
+                {
+                    return remaining == 0;
+                }
+
+                float get_elapsed () const
+                {
+                    return float(elapsed * .001);
+                }
+
+            private:
+
+                bool decode     (Event & event);
+                bool read_timing ();
+
+            };
+
+        private:
+
+            Mapped_File file;
+            uint32_t    event_count;
+            uint32_t    duration;                       ///< Milisegundo del último evento.
+
+        public:
+
+            Wave_Timeline();
+
+        public:
+
+            /**
+             * Proyecta una línea de tiempo cocinada y comprueba su cabecera.
+             * @return false si no se puede abrir o no es una línea de tiempo de esta versión.
+             */
+            bool open (const std::string & path);
+
+            bool is_open () const
+            {
+                return file.is_open ();
+            }
+
+            uint32_t get_event_count () const
+            {
+                return event_count;
+            }
+
+            float get_duration () const
+            {
+                return duration * .001f;
+            }
+
+            /**
+             * Bytes de la línea de tiempo (cabecera incluida).
+             */
+            size_t get_size () const
+            {
+                return file.get_size ();
+            }
+
+        public:
+
+            /**
+             * Codifica una lista de eventos (ya ordenada por tiempo) con el formato de la
+             * línea de tiempo, cabecera incluida. Los tiempos se redondean a milisegundos y las
+             * alturas y velocidades a unidades enteras.
+             */
+            static std::vector< uint8_t > encode (const std::vector< Event > & events);
+
+        };
+
+    }
+
+#endif
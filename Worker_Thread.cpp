@@ -0,0 +1,94 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#include "Worker_Thread.hpp"
+
+namespace jesus_villar_examen
+{
+
+    Worker_Thread::Worker_Thread()
+    :
+        busy     (false),
+        stopping (false)
+    {
+        thread = std::thread (&Worker_Thread::loop, this);
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    Worker_Thread::~Worker_Thread()
+    {
+        {
+            std::unique_lock< std::mutex > lock (mutex);
+
+            condition.wait (lock, [this] { return !busy; });
+
+            stopping = true;
+        }
+
+        condition.notify_all ();
+
+        thread.join ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Worker_Thread::run (std::function< void() > new_task)
+    {
+        {
+            std::unique_lock< std::mutex > lock (mutex);
+
+            condition.wait (lock, [this] { return !busy; });
+
+            task = std::move (new_task);
+            busy = true;
+        }
+
+        condition.notify_all ();
+    }
+
+    // ---------------------------------------------------------------------------------------------
+
+    void Worker_Thread::wait ()
+    {
+        std::unique_lock< std::mutex > lock (mutex);
+
+        condition.wait (lock, [this] { return !busy; });
+    }
+
+    // ---------------------------------------------------------------------------------------------
+    // La tarea se ejecuta sin tener el mutex bloqueado para que el hilo principal pueda consultar
+    // el estado mientras tanto.
+
+    void Worker_Thread::loop ()
+    {
+        std::unique_lock< std::mutex > lock (mutex);
+
+        for (;;)
+        {
+            condition.wait (lock, [this] { return busy || stopping; });
+
+            if (stopping) break;
+
+            lock.unlock ();
+
+            task ();
+
+            lock.lock ();
+
+            task = nullptr;
+            busy = false;
+
+            condition.notify_all ();
+        }
+    }
+
+}
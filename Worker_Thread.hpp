@@ -0,0 +1,69 @@
+/*
+ * CREATED BY
+ *
+ * Jesus 'Pokoi' Villar
+ * © pokoidev 2019 (pokoidev.com)
+ *
+ * Creative Commons License:
+ * Attribution 4.0 International (CC BY 4.0)
+ *
+ */
+
+#ifndef WORKER_THREAD_HEADER
+#define WORKER_THREAD_HEADER
+
+    #include <mutex>
+    #include <thread>
+    #include <functional>
+    #include <condition_variable>
+
+    namespace jesus_villar_examen
+    {
+
+        /**
+         * Hilo persistente que ejecuta de una en una las tareas que se le encargan. Se usa para
+         * simular el siguiente paso mientras el hilo principal dibuja el anterior.
+         */
+        class Worker_Thread
+        {
+
+            std::thread               thread;
+            std::mutex                mutex;
+            std::condition_variable   condition;
+            std::function< void() >   task;             ///< Tarea pendiente o en curso (vacía si no hay).
+            bool                      busy;             ///< true desde que se encarga una tarea hasta que termina.
+            bool                      stopping;         ///< true cuando el hilo debe terminar.
+
+        public:
+
+            Worker_Thread();
+
+            /**
+             * Espera a que termine la tarea en curso y detiene el hilo.
+             */
+           ~Worker_Thread();
+
+            Worker_Thread(const Worker_Thread & ) = delete;
+            Worker_Thread & operator = (const Worker_Thread & ) = delete;
+
+        public:
+
+            /**
+             * Encarga una tarea. Si hay otra en curso se espera antes a que termine.
+             */
+            void run (std::function< void() > new_task);
+
+            /**
+             * Bloquea al llamador hasta que no hay ninguna tarea en curso.
+             */
+            void wait ();
+
+        private:
+
+            void loop ();
+
+        };
+
+    }
+
+#endif
@@ -19,12 +19,20 @@
   *
   */
 
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <basics/Director>
 #include <basics/enable>
 #include <basics/Graphics_Resource_Cache>
 #include <basics/opengles/Context>
 #include <basics/Window>
 #include "Game_Scene.hpp"
+#include "Batch_Runner.hpp"
+#include "Texture_Cooker.hpp"
+#include "Benchmark_Suite.hpp"
+#include "Self_Test.hpp"
+#include "Wave_Cooker.hpp"
 #include <basics/opengles/Canvas_ES2>
 #include <basics/opengles/OpenGL_ES2>
 
@@ -34,13 +42,333 @@ using namespace std;
 
 int main ()
 {
+    // Con SINKTHEMALL_SCENARIO=<fichero> se cambian el número de entidades, el ritmo de disparo y
+    // las velocidades de la escena (ver Scenario.hpp) tanto al jugar como en las partidas HEADLESS:
+
+    Scenario scenario = Scenario::defaults ();
+
+    if (const char * path = getenv ("SINKTHEMALL_SCENARIO"))
+    {
+        if (!scenario.load (path)) printf ("%s: no se ha podido leer el escenario completo\n", path);
+    }
+
+    // Con SINKTHEMALL_WAVES=<línea de tiempo cocinada> los submarinos aparecen y disparan según un
+    // nivel diseñado (ver Wave_Timeline.hpp) en lugar de al azar:
+
+    shared_ptr< Wave_Timeline > wave_timeline;
+
+    if (const char * path = getenv ("SINKTHEMALL_WAVES"))
+    {
+        wave_timeline = make_shared< Wave_Timeline > ();
+
+        if (!wave_timeline->open (path))
+        {
+            printf ("%s: no es una línea de tiempo válida\n", path);
+
+            wave_timeline.reset ();
+        }
+    }
+
+    // Con SINKTHEMALL_TEXTURE_BUDGET_KB=<KB> se limita la memoria de texturas en GPU que se puede
+    // ocupar precargando. SINKTHEMALL_MEMORY_REPORT=1 muestra al terminar una partida HEADLESS la
+    // memoria que ha usado cada subsistema:
+
+    if (const char * budget = getenv ("SINKTHEMALL_TEXTURE_BUDGET_KB"))
+    {
+        Memory_Tracker::get_instance ().set_budget (MEMORY_TEXTURES_GPU, size_t(atol (budget)) * 1024);
+    }
+
+    const bool memory_report = getenv ("SINKTHEMALL_MEMORY_REPORT") != nullptr;
+
+    // Con SINKTHEMALL_SCALING=1 no se abre ninguna ventana: se juega una partida HEADLESS de diez
+    // segundos con cada escenario de estrés y se muestra una tabla CSV con la que representar cómo
+    // crecen el tiempo por fotograma, la memoria y los pares de colisión con las entidades, y cuánto
+    // cuestan en cada paso cada script de comportamiento y cada animación de los submarinos:
+
+    if (getenv ("SINKTHEMALL_SCALING"))
+    {
+        printf ("entidades,ms_por_fotograma,memoria_kb,memoria_anotada_kb,pares_por_fotograma,ns_por_script,ns_scripts_por_reanudacion,ns_por_animacion,contactos_descartados\n");
+
+        for (unsigned entities : { 1000u, 10000u, 100000u })
+        {
+            Batch_Runner runner (1, 1);
+
+            runner.set_scenario (Scenario::stress (entities));
+
+            Batch_Runner::Report report = runner.run (10 * 60);
+
+            printf
+            (
+                "%u,%.3f,%zu,%zu,%.0f,%.1f,%.1f,%.2f,%llu\n",
+                Scenario::stress (entities).entities (), report.frame_milliseconds, report.resident_bytes / 1024,
+                report.tracked_peak_bytes / 1024, report.collision_pairs, report.script_nanoseconds, report.script_nanoseconds_per_resume,
+                report.animation_nanoseconds, (unsigned long long)report.overflowed_contacts
+            );
+        }
+
+        if (memory_report) printf ("%s", Memory_Tracker::get_instance ().format_report ().c_str ());
+
+        return 0;
+    }
+
+    // Con SINKTHEMALL_CHECK=1 no se abre ninguna ventana: se ejecutan las comprobaciones de
+    // Self_Test.hpp y el programa termina con error si falla alguna:
+
+    if (getenv ("SINKTHEMALL_CHECK"))
+    {
+        unsigned failed = 0;
+
+        for (const Self_Test::Result & result : Self_Test().run ())
+        {
+            if (result.passed)
+            {
+                printf ("OK    %s\n", result.name.c_str ());
+            }
+            else
+            {
+                printf ("FALLO %s: %s\n", result.name.c_str (), result.detail.c_str ());
+                failed++;
+            }
+        }
+
+        return failed > 0 ? 1 : 0;
+    }
+
+    // Con SINKTHEMALL_BENCH=<fichero JSON> no se abre ninguna ventana: se ejecutan los microbenchmarks
+    // (ver Benchmark_Suite.hpp) y se guardan los resultados en ese fichero, que después puede servir
+    // de referencia. Con SINKTHEMALL_BENCH_BASELINE=<fichero JSON> además se comparan con una
+    // referencia y el programa termina con error si alguno es más de SINKTHEMALL_BENCH_THRESHOLD
+    // por ciento (10 por defecto) más lento:
+
+    if (const char * output = getenv ("SINKTHEMALL_BENCH"))
+    {
+        const char * baseline_path = getenv ("SINKTHEMALL_BENCH_BASELINE" );
+        const char * threshold     = getenv ("SINKTHEMALL_BENCH_THRESHOLD");
+
+        Benchmark_Suite          suite;
+        Benchmark_Suite::Results results = suite.run ();
+
+        for (const Benchmark_Suite::Result & result : results)
+        {
+            printf ("%-32s %8u %12.2f ns\n", result.name.c_str (), result.size, result.nanoseconds);
+        }
+
+        if (*output)
+        {
+            ofstream file (output);
+
+            if (!(file << Benchmark_Suite::to_json (results))) printf ("%s: no se han podido guardar los resultados\n", output);
+        }
+
+        if (baseline_path)
+        {
+            Benchmark_Suite::Results baseline;
+
+            if (!Benchmark_Suite::load (baseline_path, baseline))
+            {
+                printf ("%s: no es una referencia válida\n", baseline_path);
+                return 1;
+            }
+
+            double threshold_percent = threshold ? atof (threshold) : 10.0;
+
+            Benchmark_Suite::Regressions regressions = Benchmark_Suite::compare (results, baseline, threshold_percent);
+
+            for (const Benchmark_Suite::Regression & regression : regressions)
+            {
+                printf
+                (
+                    "REGRESIÓN %s (%u): %.2f -> %.2f ns (+%.1f%%)\n",
+                    regression.name.c_str (), regression.size, regression.baseline_nanoseconds, regression.nanoseconds, regression.percent
+                );
+            }
+
+            printf ("%zu regresiones por encima del %.1f%%\n", regressions.size (), threshold_percent);
+
+            if (!regressions.empty ()) return 1;
+        }
+
+        return 0;
+    }
+
+    // Con SINKTHEMALL_BATCH=<partidas> no se abre ninguna ventana: se juegan a la vez ese número de
+    // partidas HEADLESS durante un minuto de juego cada una y se muestran los resultados agregados:
+
+    if (const char * batch = getenv ("SINKTHEMALL_BATCH"))
+    {
+        Batch_Runner           runner (unsigned(atoi (batch)));
+
+        runner.set_scenario      (scenario);
+        runner.set_wave_timeline (wave_timeline);
+
+        Batch_Runner::Report   report = runner.run (60 * 60);
+
+        printf
+        (
+            "%u partidas, %u hilos, %u fotogramas: %.3f s, %.0f fotogramas/s\n"
+            "impactos medios %.2f, hundimientos medios %.2f, supervivencia media %.2f s (mejor %.2f s)\n",
+            report.simulations, report.threads, report.frames, report.wall_seconds, report.frames_per_second,
+            report.average_hits, report.average_deaths, report.average_best_survival, report.best_survival
+        );
+
+        if (memory_report) printf ("%s", Memory_Tracker::get_instance ().format_report ().c_str ());
+
+        return 0;
+    }
+
+    // Con SINKTHEMALL_COOK=<carpeta de recursos> tampoco se abre ninguna ventana: se comprimen a
+    // ETC2 las texturas de la escena (a partir de TGA con el mismo nombre que cada PNG) y se
+    // muestra cuánta memoria ocupan y con qué calidad:
+
+    if (const char * root = getenv ("SINKTHEMALL_COOK"))
+    {
+        Texture_Cooker cooker;
+        size_t         uncompressed = 0;
+        size_t         compressed   = 0;
+
+        for (const Texture_Cooker::Report_Entry & entry : cooker.cook (Game_Scene::get_textures_data (), root))
+        {
+            if (!entry.cooked)
+            {
+                printf ("%s: no se ha podido cocinar\n", entry.source_path.c_str ());
+                continue;
+            }
+
+            printf
+            (
+                "%s: %ux%u, %zu -> %zu bytes (%.1fx), PSNR %.2f dB, %.3f s\n",
+                entry.cooked_path.c_str (), entry.width, entry.height, entry.uncompressed_bytes, entry.compressed_bytes,
+                double(entry.uncompressed_bytes) / entry.compressed_bytes, entry.psnr, entry.seconds
+            );
+
+            uncompressed += entry.uncompressed_bytes;
+            compressed   += entry.compressed_bytes;
+        }
+
+        printf ("total: %zu -> %zu bytes\n", uncompressed, compressed);
+
+        return 0;
+    }
+
+    // Con SINKTHEMALL_COOK_WAVES=<fichero de texto> se cocina la línea de tiempo de un nivel (ver
+    // Wave_Cooker.hpp) y se guarda junto a él con extensión .waves:
+
+    if (const char * source = getenv ("SINKTHEMALL_COOK_WAVES"))
+    {
+        Wave_Cooker::Report report = Wave_Cooker::cook (source, Texture_Cooker::replace_extension (source, ".waves"));
+
+        if (report.error_line > 0)
+        {
+            printf ("%s:%u: evento mal formado\n", source, report.error_line);
+        }
+        else if (!report.cooked)
+        {
+            printf ("%s: no se ha podido cocinar\n", source);
+        }
+        else
+        {
+            printf
+            (
+                "%s: %u eventos, %.2f s, %zu -> %zu bytes\n",
+                report.cooked_path.c_str (), report.events, report.duration, report.source_bytes, report.cooked_bytes
+            );
+        }
+
+        return 0;
+    }
+
+    // SINKTHEMALL_LATE_LATCH=0 desactiva la corrección de la entrada justo antes de dibujar para
+    // poder comparar la latencia de los toques con y sin ella. SINKTHEMALL_HUD=1 muestra el panel
+    // de rendimiento encima de la escena:
+
+    const char * late_latch  = getenv ("SINKTHEMALL_LATE_LATCH" );
+    const char * hud         = getenv ("SINKTHEMALL_HUD"        );
+    const char * renderer    = getenv ("SINKTHEMALL_RENDERER"   );
+
+    // Con SINKTHEMALL_RENDERER=software no se abre ninguna ventana ni se usa la GPU: se juegan
+    // SINKTHEMALL_FRAMES fotogramas (600 por defecto) a 60 por segundo dibujándolos en memoria con
+    // el Software_Canvas, con las texturas leídas de los TGA de la carpeta SINKTHEMALL_ASSETS
+    // ("assets" por defecto), y se muestra la tasa de relleno y cómo ha ajustado la resolución
+    // dinámica la escala. SINKTHEMALL_RESOLUTION_TARGET_MS cambia el tiempo objetivo con el que
+    // rasterizar cada fotograma. SINKTHEMALL_DUMP_FRAMES=<prefijo> guarda un fotograma de cada 60
+    // en ficheros TGA:
+
+    if (renderer && string(renderer) == "software")
+    {
+        const char * frames_text = getenv ("SINKTHEMALL_FRAMES"     );
+        const char * assets      = getenv ("SINKTHEMALL_ASSETS"     );
+        const char * dump_prefix = getenv ("SINKTHEMALL_DUMP_FRAMES");
+        const char * target      = getenv ("SINKTHEMALL_RESOLUTION_TARGET_MS");
+
+        unsigned frames = frames_text ? unsigned(atoi (frames_text)) : 600;
+        string   root   = assets ? assets : "assets";
+
+        shared_ptr< Game_Scene > scene(new Game_Scene(Game_Scene::SOFTWARE_CANVAS, scenario));
+
+        if (dump_prefix) scene->set_frame_dump (dump_prefix, 60);
+        if (late_latch ) scene->set_late_latching (string(late_latch) != "0");
+        if (hud        ) scene->set_performance_hud (string(hud) != "0");
+
+        if (wave_timeline) scene->set_wave_timeline (wave_timeline);
+
+        if (target)
+        {
+            Dynamic_Resolution::Settings settings = scene->get_resolution_settings ();
+
+            settings.target_milliseconds = float(atof (target));
+
+            scene->set_resolution_settings (settings);
+        }
+
+        if (!scene->load_texture_images (root)) printf ("%s: faltan texturas TGA, se dibujarán con color liso\n", root.c_str ());
+
+        // Se toca la pantalla cada medio segundo para empezar a jugar y seguir disparando:
+
+        uint64_t pixels  = 0;
+        double   seconds = 0.0;
+
+        for (unsigned frame = 0; frame < frames; ++frame)
+        {
+            if (frame % 30 == 0) scene->touch ();
+
+            scene->update          (1.f / 60.f);
+            scene->render_software ();
+
+            const Software_Canvas & canvas = *scene->get_software_canvas ();
+
+            pixels  += canvas.get_pixels_filled  ();
+            seconds += canvas.get_render_seconds ();
+        }
+
+        const Dynamic_Resolution::Metrics & resolution = scene->get_resolution_metrics ();
+
+        printf
+        (
+            "%u fotogramas: %.1f megapíxeles/s, %.3f megapíxeles por fotograma\n"
+            "escala final %.2f (%.3f ms por fotograma, %u bajadas, %u subidas, %u bajadas deshechas)\n",
+            frames, seconds > 0.0 ? pixels / seconds * 1e-6 : 0.0, frames > 0 ? pixels * 1e-6 / frames : 0.0,
+            resolution.scale, resolution.frame_milliseconds, resolution.decreases, resolution.increases, resolution.reverts
+        );
+
+        if (memory_report) printf ("%s", Memory_Tracker::get_instance ().format_report ().c_str ());
+
+        return 0;
+    }
+
     // Es necesario habilitar un backend gráfico antes de nada:
 
     enable< basics::OpenGL_ES2 > ();
 
-    // Se crea una Game_Scene y se inicia mediante el Director:
+    shared_ptr< Game_Scene > scene(new Game_Scene(Game_Scene::GPU_CANVAS, scenario));
+
+    if (late_latch) scene->set_late_latching (string(late_latch) != "0");
+    if (hud       ) scene->set_performance_hud (string(hud) != "0");
+
+    if (wave_timeline) scene->set_wave_timeline (wave_timeline);
+
+    // Se inicia la Game_Scene mediante el Director:
 
-    director.run_scene (shared_ptr< Scene >(new Game_Scene));
+    director.run_scene (scene);
 
     return 0;
 }